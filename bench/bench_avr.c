@@ -0,0 +1,1203 @@
+/*
+ * bench_avr.c
+ *
+ *  Created on: 16 Oct 2026
+ *  Author: Dmitry Melnichansky / 4Z7DTF
+ *
+ *  Cycle accurate benchmark of the firmware. Runs a vx8_gps ELF built
+ *  with VX8_TRACE in simavr and feeds the recorded GPS output to USART0
+ *  back to back at the baud rate of the firmware, which is the worst case
+ *  the receiver sees from the NEO-6M. With -r the input is split into
+ *  epochs starting with RMC, the first sentence of an epoch of the NEO-6M,
+ *  and every epoch starts at the given rate like the GPS output does.
+ *  -b sets the input baud rate for firmware built with GPS_BAUDRATE. With
+ *  -s the output is decoded from the software UART pin of a VX8_SOFT_TX
+ *  build instead of USART0, and the timing of its edges is checked against
+ *  the ideal 9600 baud bit times. -u feeds firmware built with
+ *  VX8_UBX_INPUT with UBX captures made by nmea2ubx; epochs start with
+ *  NAV-POSLLH. -e loads the EEPROM from a file before the run and -E
+ *  saves it after, so that a VX8_LAST_FIX build can be run again with the
+ *  fix it saved. $PVX8S sentences of a VX8_TELEMETRY build are counted
+ *  and not compared. -p drives the PPS pin of a VX8_PPS build with a
+ *  100ms pulse at the start of every epoch of -r, like the TIMEPULSE
+ *  output of the NEO-6M. The milliseconds of the output time fields are
+ *  then compared with the time from the pulse to the end of the sentence,
+ *  and not with the host transform.
+ *  Reports:
+ *    - cycles spent in the main loop per input byte, by receiver state.
+ *      Bytes which complete or abort a sentence are counted as RESET,
+ *      frame hand-off to TX as HANDOFF. With -u all the bytes are counted
+ *      as UBX and rendering the sentences of an epoch as RENDER, the
+ *      telemetry sentence as TELEMETRY. ISR
+ *      cycles are excluded.
+ *    - USART_RX_vect latency from RX Complete to the first ISR cycle.
+ *    - bytes dropped by the RX ring buffer and USART, and sentences which
+ *      were not sent or differ from the output of the host build of the
+ *      transform.
+ *    - latency from the stop bit of the last input byte of a sentence to
+ *      the stop bit of the last output byte of the converted sentence,
+ *      and to the stop bit of its first output byte, with percentiles.
+ *      make bench-replay runs it at 1, 5 and 10 Hz epoch rates, the
+ *      sentences which were not sent are the drops at each rate.
+ *    - active and sleeping CPU cycles, per epoch with -r.
+ *    - the high-water mark of the TX queue (tx_high_water).
+ *    - the baud rate error of USART0 as set up by the firmware and, with
+ *      -s, the largest edge timing error, the shortest and longest bit
+ *      against the ideal bit time and framing errors of the software UART.
+ *    - with -p, the error of the output milliseconds and the time from
+ *      the pulse to the start of the output of the epoch.
+ *    - time from power-up to the first sentence, the first GGA with a
+ *      position and the first GGA with a position from the GPS. Flagged
+ *      last-known position sentences (GGA quality 6, RMC mode E) are
+ *      counted separately and not compared.
+ *  The results are written as JSON.
+ *
+ *  Build and run:
+ *    make bench-avr
+ *    make bench-soft-tx
+ *    make bench-ttff
+ *    make bench-pps
+ *  or
+ *    bench_avr [-f frequency] [-r epoch_rate] [-b input_baudrate] [-s] [-u] [-p] [-e eeprom.bin] [-E eeprom.bin]
+ *              [-o result.json] vx8_gps.elf capture...
+ */
+
+#include <elf.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <simavr/sim_avr.h>
+#include <simavr/sim_elf.h>
+#include <simavr/sim_irq.h>
+#include <simavr/sim_interrupts.h>
+#include <simavr/sim_cycle_timers.h>
+#include <simavr/avr_uart.h>
+#include <simavr/avr_ioport.h>
+#include <simavr/avr_eeprom.h>
+#include "../src/vx8_core.h"
+#include "../src/render.h"
+#include "../src/sentences.h"
+#include "../src/ubx.h"
+
+/* ATmega328P data space addresses and vector numbers. */
+#define GPIOR0_ADDR 0x3E
+#define GPIOR1_ADDR 0x4A
+#define UCSR0A_ADDR 0xC0
+#define UBRR0L_ADDR 0xC4
+#define UBRR0H_ADDR 0xC5
+#define U2X0_BIT 1
+#define TIMER1_COMPA_VECT 11
+#define USART_RX_VECT 18
+#define USART_UDRE_VECT 19
+#define SOFT_TX_PORT 'D'
+#define SOFT_TX_PIN 1
+#define PPS_PORT 'B'
+#define PPS_PIN 0 /* ICP1 */
+#define DATA_OFFSET 0x800000 /* Data space offset of avr-gcc ELF symbols */
+#define EEPROM_SIZE 1024
+
+#define BAUDRATE 9600
+#define BITS_PER_BYTE 10 /* 8N1 */
+#define IDLE_BYTES 2000 /* Output idle time which ends the run */
+/* Sentence types are matched after $ and the talker ID, e.g. $GP or $GN. */
+#define TALKER_END 3
+#define EPOCH_TYPE "RMC"
+#define GGA_TYPE "GGA"
+#define RMC_TYPE "RMC"
+#define GGA_QUALITY_FIELD 6
+#define GGA_NO_FIX '0'
+#define GGA_LAST_KNOWN '6'
+#define RMC_MODE_FIELD 12
+#define RMC_LAST_KNOWN 'E'
+#define TELEMETRY_HEADER "$PVX8S"
+#define PPS_WIDTH_MS 100 /* NEO-6M default pulse length */
+#define TIME_MS_POS 14 /* Milliseconds of the time field: $GPxxx,hhmmss.sss */
+#define CHECKSUM_LEN 4 /* hh CR LF */
+static const char ubx_epoch_start[] = { (char) UBX_SYNC_CHAR_1, UBX_SYNC_CHAR_2, UBX_CLASS_NAV, UBX_NAV_POSLLH };
+
+/* Trace values written by firmware.c */
+#define TRACE_HANDOFF 0x10
+#define TRACE_UBX 0x20
+#define TRACE_RENDER 0x21
+#define TRACE_TELEMETRY 0x30
+#define TRACE_IDLE 0xFF
+
+enum bench_states
+{
+	ST_READY, ST_TYPE_DETECT, ST_MESSAGE, ST_CHECKSUM, ST_RESET, ST_HANDOFF, ST_UBX, ST_RENDER, ST_TELEMETRY, ST_COUNT
+};
+
+static const char *state_names[ST_COUNT] = {
+	"READY", "RX_TYPE_DETECT", "RX_MESSAGE", "RX_CHECKSUM", "RESET", "HANDOFF", "UBX", "RENDER", "TELEMETRY"
+};
+
+static const char *result_names[] = {
+	"none", "frame", "field", "type", "field", "overflow", "checksum", "sync"
+};
+
+struct stat_acc
+{
+	unsigned long count;
+	unsigned long long sum;
+	unsigned long max;
+};
+
+/* All values, for percentiles. */
+struct samples
+{
+	long long *values;
+	size_t count;
+	size_t size;
+};
+
+/* Sentence expected from the firmware, produced by the host transform. */
+struct expected
+{
+	char buffer[VX8_BUFFER_SIZE];
+	uint8_t len;
+	avr_cycle_count_t input_end;
+	struct expected *next;
+};
+
+struct bench
+{
+	avr_t *avr;
+	avr_irq_t *uart_in;
+	avr_cycle_count_t byte_cycles; /* Input byte time */
+	avr_cycle_count_t out_byte_cycles; /* Output byte time */
+	uint32_t baudrate; /* Input baud rate */
+
+	/* Input */
+	const uint8_t *input;
+	size_t input_len;
+	size_t input_pos;
+	unsigned long gps_drops; /* Sentences dropped by the GPS to keep the epoch rate. */
+	size_t gps_drop_bytes;
+	size_t *epochs; /* Input positions where epochs start. */
+	unsigned epoch_count;
+	unsigned epoch;
+	avr_cycle_count_t epoch_cycles;
+	struct vx8 host;
+	struct vx8_frame host_frame;
+	struct ubx host_ubx;
+	int ubx_input;
+
+	/* PPS */
+	avr_irq_t *pps_pin;
+	int pps_level;
+	avr_cycle_count_t pps_edge; /* Cycle of the last rising edge, 0 before the first. */
+	avr_cycle_count_t pps_epoch_start; /* End of the first sentence after the edge, 0 until sent. */
+	unsigned long pps_pulses;
+	unsigned long pps_untimed; /* Sentences with .000 after a pulse */
+
+	/* Expected output queue */
+	struct expected *head, *tail;
+	char out[VX8_BUFFER_SIZE];
+	uint8_t out_len;
+	avr_cycle_count_t out_first; /* Stop bit of the first byte of out. */
+	avr_cycle_count_t last_output;
+
+	/* Software UART decoder */
+	double bit_cycles;
+	int soft_level;
+	int soft_bit; /* Bit being received, -1 when idle. */
+	uint8_t soft_byte;
+	avr_cycle_count_t soft_start;
+	unsigned long soft_bytes;
+	unsigned long framing_errors;
+	double max_edge_error; /* Cycles */
+	avr_cycle_count_t soft_edge; /* Last edge inside a byte. */
+	double min_bit, max_bit; /* Cycles per bit between two edges. */
+
+	/* Main loop trace */
+	uint8_t trace_state;
+	avr_cycle_count_t trace_start;
+	avr_cycle_count_t trace_isr;
+
+	/* ISRs */
+	avr_cycle_count_t isr_cycles;
+	avr_cycle_count_t isr_start;
+	avr_cycle_count_t rx_pending;
+	int rx_pending_set;
+	unsigned long rx_isr_count;
+
+	/* CPU */
+	avr_cycle_count_t window_start, window_end;
+	avr_cycle_count_t active_cycles;
+	avr_cycle_count_t sleep_cycles;
+
+	/* Results */
+	struct stat_acc states[ST_COUNT];
+	struct stat_acc rx_latency;
+	struct stat_acc sentence_latency;
+	struct samples first_latency; /* Input end to the first output byte, in cycles */
+	struct samples last_latency; /* Input end to the last output byte, in cycles */
+	struct stat_acc pps_error; /* Output milliseconds minus the actual ones, in cycles */
+	struct stat_acc pps_phase; /* Pulse to the end of the first sentence of the epoch, in cycles */
+	unsigned long results[sizeof(result_names) / sizeof(result_names[0])];
+	unsigned long sent;
+	unsigned long mismatched;
+	unsigned long missing;
+	unsigned long extra_bytes;
+	long ring_overflows; /* -1 if unknown */
+	long tx_high_water; /* -1 if unknown */
+	long pps_late; /* -1 if unknown */
+
+	/* Time to first fix, cycles from power-up, 0 if none. */
+	avr_cycle_count_t first_sentence;
+	avr_cycle_count_t first_fix;
+	avr_cycle_count_t first_gps_fix;
+	unsigned long last_known;
+	unsigned long telemetry; /* $PVX8S sentences */
+};
+
+static void acc_add(struct stat_acc *acc, unsigned long v)
+{
+	acc->count++;
+	acc->sum += v;
+	if (v > acc->max)
+		acc->max = v;
+}
+
+static void samples_add(struct samples *s, long long v)
+{
+	if (s->count == s->size)
+	{
+		s->size = s->size ? s->size * 2 : 1024;
+		s->values = realloc(s->values, s->size * sizeof(s->values[0]));
+	}
+	s->values[s->count++] = v;
+}
+
+static int compare_ll(const void *a, const void *b)
+{
+	long long x = *(const long long *) a;
+	long long y = *(const long long *) b;
+	return (x > y) - (x < y);
+}
+
+static void expect(struct bench *b, const struct vx8_frame *frame, avr_cycle_count_t input_end)
+{
+	struct expected *e = calloc(1, sizeof(*e));
+
+	memcpy(e->buffer, frame->buffer, frame->len);
+	e->len = frame->len;
+	e->input_end = input_end;
+	if (b->tail)
+		b->tail->next = e;
+	else
+		b->head = e;
+	b->tail = e;
+}
+
+/*
+ * Function: feed_byte
+ * -------------------
+ *   Cycle timer which puts the next input byte on the RX line every byte
+ *   time. The byte is also fed to the host transform and an expected
+ *   sentence is queued if it completes one. With UBX input the sentences
+ *   of a complete epoch are queued in the order the firmware renders them.
+ *
+ *   returns:	cycle of the next call, 0 when the input is exhausted.
+ */
+static avr_cycle_count_t feed_byte(avr_t *avr, avr_cycle_count_t when, void *param)
+{
+	struct bench *b = param;
+	uint8_t byte;
+
+	(void) avr;
+	if (b->input_pos >= b->input_len)
+		return 0;
+	byte = b->input[b->input_pos++];
+	avr_raise_irq(b->uart_in, byte);
+
+	if (b->ubx_input)
+	{
+		if (ubx_feed(&b->host_ubx, byte) == UBX_EPOCH)
+		{
+			for (uint8_t i = 0; i < SENTENCE_COUNT; i++)
+			{
+				if (render_sentence(&b->host_ubx.fix, i, RENDER_VX8, &b->host_frame))
+					expect(b, &b->host_frame, when + b->byte_cycles);
+			}
+		}
+	}
+	else if (vx8_feed(&b->host, byte) == VX8_FRAME)
+	{
+		expect(b, &b->host_frame, when + b->byte_cycles);
+	}
+
+	/* Like the GPS with a full TX buffer, a sentence which can't start
+	 * before the next epoch is dropped with the rest of its epoch.
+	 */
+	if (b->epoch < b->epoch_count && !b->ubx_input && b->input_pos < b->epochs[b->epoch]
+			&& b->input[b->input_pos] == '$'
+			&& when + b->byte_cycles > b->window_start + (b->epoch + 1) * b->epoch_cycles)
+	{
+		for (; b->input_pos < b->epochs[b->epoch]; b->input_pos++)
+		{
+			if (b->input[b->input_pos] == '$')
+				b->gps_drops++;
+			b->gps_drop_bytes++;
+		}
+	}
+
+	/* Next epoch starts on time, or right after the sentence being sent. */
+	if (b->epoch < b->epoch_count && b->input_pos == b->epochs[b->epoch])
+	{
+		avr_cycle_count_t start;
+		b->epoch++;
+		start = b->window_start + b->epoch * b->epoch_cycles;
+		if (start > when + b->byte_cycles)
+			return start;
+	}
+	return when + b->byte_cycles;
+}
+
+/*
+ * Function: pps_pulse
+ * -------------------
+ *   Cycle timer which raises the PPS pin at the start of every epoch and
+ *   lowers it PPS_WIDTH_MS later.
+ *
+ *   returns:	cycle of the next edge, 0 after the last epoch.
+ */
+static avr_cycle_count_t pps_pulse(avr_t *avr, avr_cycle_count_t when, void *param)
+{
+	struct bench *b = param;
+	avr_cycle_count_t width = avr->frequency / 1000 * PPS_WIDTH_MS;
+
+	b->pps_level = !b->pps_level;
+	avr_raise_irq(b->pps_pin, b->pps_level);
+	if (b->pps_level)
+	{
+		b->pps_edge = when;
+		b->pps_epoch_start = 0;
+		b->pps_pulses++;
+		return when + width;
+	}
+	when += b->epoch_cycles - width;
+	return when < b->window_end ? when : 0;
+}
+
+/*
+ * Function: is_sentence
+ * ---------------------
+ *   Checks the sentence type after $ and the two character talker ID, so
+ *   that $GP, $GN, $GL and other talkers are accepted like the transform
+ *   accepts them.
+ *
+ *   returns:	1 if s starts a sentence of the given type, 0 otherwise.
+ */
+static int is_sentence(const char *s, size_t len, const char *type)
+{
+	size_t type_len = strlen(type);
+	return len > TALKER_END + type_len && s[0] == '$' && memcmp(&s[TALKER_END], type, type_len) == 0;
+}
+
+/*
+ * Function: split_epochs
+ * ----------------------
+ *   Finds the positions where epochs start in the input. The first epoch
+ *   starts at the beginning of the input and includes everything before
+ *   the first RMC sentence, or NAV-POSLLH message with UBX input.
+ *
+ *   returns:	none
+ */
+static void split_epochs(struct bench *b)
+{
+	size_t len = b->ubx_input ? sizeof(ubx_epoch_start) : TALKER_END + strlen(EPOCH_TYPE);
+
+	b->epochs = malloc((b->input_len / len + 1) * sizeof(size_t));
+	b->epoch_count = 0;
+	for (size_t i = 1; i + len <= b->input_len; i++)
+	{
+		if (b->ubx_input ? memcmp(&b->input[i], ubx_epoch_start, len) == 0
+				: is_sentence((const char *) &b->input[i], b->input_len - i, EPOCH_TYPE))
+			b->epochs[b->epoch_count++] = i;
+	}
+	b->epoch = 0;
+}
+
+/*
+ * Function: count_cycles
+ * ----------------------
+ *   Adds the part of [from, to) inside the measurement window to active
+ *   or sleeping cycles.
+ *
+ *   returns:	none
+ */
+static void count_cycles(struct bench *b, avr_cycle_count_t from, avr_cycle_count_t to, int sleeping)
+{
+	if (from < b->window_start)
+		from = b->window_start;
+	if (to > b->window_end)
+		to = b->window_end;
+	if (from >= to)
+		return;
+	if (sleeping)
+		b->sleep_cycles += to - from;
+	else
+		b->active_cycles += to - from;
+}
+
+/*
+ * Function: field_char
+ * --------------------
+ *   returns:	the first character of field n of the sentence, 0 if the
+ *   			sentence is shorter.
+ */
+static char field_char(const char *s, uint8_t len, int n)
+{
+	for (uint8_t i = 0; i < len; i++)
+	{
+		if (s[i] == ',' && --n == 0)
+			return i + 1 < len ? s[i + 1] : 0;
+	}
+	return 0;
+}
+
+/*
+ * Function: time_to_fix
+ * ---------------------
+ *   Records the time of the first sentence and the first GGA sentences
+ *   with a position.
+ *
+ *   end: cycle at which the stop bit of the last byte ends
+ *
+ *   returns:	1 if the sentence is a flagged last-known position, which
+ *   			isn't produced by the host transform, 0 otherwise.
+ */
+static int time_to_fix(struct bench *b, avr_cycle_count_t end)
+{
+	int gga = is_sentence(b->out, b->out_len, GGA_TYPE);
+	int rmc = is_sentence(b->out, b->out_len, RMC_TYPE);
+	char quality = gga ? field_char(b->out, b->out_len, GGA_QUALITY_FIELD) : 0;
+
+	if (!b->first_sentence)
+		b->first_sentence = end;
+	if (gga && quality && quality != GGA_NO_FIX)
+	{
+		if (!b->first_fix)
+			b->first_fix = end;
+		if (!b->first_gps_fix && quality != GGA_LAST_KNOWN)
+			b->first_gps_fix = end;
+	}
+	if ((gga && quality == GGA_LAST_KNOWN) || (rmc && field_char(b->out, b->out_len, RMC_MODE_FIELD) == RMC_LAST_KNOWN))
+	{
+		b->last_known++;
+		return 1;
+	}
+	return 0;
+}
+
+/*
+ * Function: pps_check
+ * -------------------
+ *   Compares the milliseconds of the time field of a sentence sent after
+ *   a pulse with the time from the pulse to the end of its stop bit. The
+ *   checksum of the sentence is checked here, as same_sentence() skips it.
+ *
+ *   returns:	none
+ */
+static void pps_check(struct bench *b, avr_cycle_count_t end)
+{
+	const char *ms = b->out + TIME_MS_POS;
+	uint8_t sum = 0;
+	unsigned value;
+	char hex[3];
+
+	if (!b->pps_edge || b->out_len < TIME_MS_POS + 3 + CHECKSUM_LEN + 1 || ms[-1] != '.')
+		return;
+	for (uint8_t i = 1; i < b->out_len - CHECKSUM_LEN - 1; i++)
+		sum ^= (uint8_t) b->out[i];
+	snprintf(hex, sizeof(hex), "%02X", sum);
+	if (memcmp(hex, b->out + b->out_len - CHECKSUM_LEN, 2) != 0)
+	{
+		b->mismatched++;
+		return;
+	}
+	if (!b->pps_epoch_start)
+	{
+		b->pps_epoch_start = end;
+		acc_add(&b->pps_phase, end - b->pps_edge);
+	}
+	value = (ms[0] - '0') * 100 + (ms[1] - '0') * 10 + (ms[2] - '0');
+	if (value == 0)
+	{
+		b->pps_untimed++;
+		return;
+	}
+	{
+		long long error = (long long) value * b->avr->frequency / 1000 - (long long) (end - b->pps_edge);
+		acc_add(&b->pps_error, (unsigned long) (error < 0 ? -error : error));
+	}
+}
+
+/*
+ * Function: same_sentence
+ * -----------------------
+ *   returns:	1 if the output is the expected sentence. With -p the
+ *   			milliseconds and the checksum aren't compared.
+ */
+static int same_sentence(const struct bench *b, const struct expected *e)
+{
+	if (e->len != b->out_len)
+		return 0;
+	if (!b->pps_pin || e->len < TIME_MS_POS + 3 + CHECKSUM_LEN + 1)
+		return memcmp(e->buffer, b->out, e->len) == 0;
+	return memcmp(e->buffer, b->out, TIME_MS_POS) == 0
+			&& memcmp(e->buffer + TIME_MS_POS + 3, b->out + TIME_MS_POS + 3,
+					e->len - TIME_MS_POS - 3 - CHECKSUM_LEN) == 0;
+}
+
+/*
+ * Function: output_byte
+ * ---------------------
+ *   Collects output bytes. A complete sentence is compared to the expected
+ *   one and its latency is recorded. Sentences which the firmware skipped
+ *   are counted as missing.
+ *
+ *   value: the output byte
+ *   end: cycle at which its stop bit ends
+ *
+ *   returns:	none
+ */
+static void output_byte(struct bench *b, uint8_t value, avr_cycle_count_t end)
+{
+	struct expected *e;
+
+	b->last_output = b->avr->cycle;
+	if (b->out_len == 0)
+		b->out_first = end;
+	if (b->out_len < VX8_BUFFER_SIZE)
+		b->out[b->out_len++] = (char) value;
+	else
+		b->extra_bytes++;
+	if (value != '\n')
+		return;
+
+	b->sent++;
+	if (b->out_len > strlen(TELEMETRY_HEADER) && memcmp(b->out, TELEMETRY_HEADER, strlen(TELEMETRY_HEADER)) == 0)
+	{
+		b->telemetry++;
+		b->out_len = 0;
+		return;
+	}
+	if (time_to_fix(b, end))
+	{
+		b->out_len = 0;
+		return;
+	}
+	if (b->pps_pin)
+		pps_check(b, end);
+	for (e = b->head; e != NULL; e = e->next)
+	{
+		if (same_sentence(b, e))
+			break;
+	}
+	if (e == NULL)
+	{
+		b->mismatched++;
+		b->out_len = 0;
+		return;
+	}
+	/* Expected sentences before the sent one were skipped. */
+	while (b->head != e)
+	{
+		struct expected *skipped = b->head;
+		b->head = skipped->next;
+		b->missing++;
+		free(skipped);
+	}
+	b->head = e->next;
+	if (b->head == NULL)
+		b->tail = NULL;
+	acc_add(&b->sentence_latency, end - e->input_end);
+	samples_add(&b->first_latency, (long long) b->out_first - (long long) e->input_end);
+	samples_add(&b->last_latency, (long long) end - (long long) e->input_end);
+	free(e);
+	b->out_len = 0;
+}
+
+/*
+ * Function: uart_output
+ * ---------------------
+ *   Collects bytes written to UDR0. The byte leaves the shift register one
+ *   byte time after it is written.
+ *
+ *   returns:	none
+ */
+static void uart_output(struct avr_irq_t *irq, uint32_t value, void *param)
+{
+	struct bench *b = param;
+
+	(void) irq;
+	output_byte(b, (uint8_t) value, b->avr->cycle + b->out_byte_cycles);
+}
+
+/*
+ * Function: soft_sample
+ * ---------------------
+ *   Cycle timer which samples the software UART pin in the middle of every
+ *   bit after the start bit, like a hardware receiver does. A low stop bit
+ *   is a framing error.
+ *
+ *   returns:	cycle of the next sample, 0 after the stop bit.
+ */
+static avr_cycle_count_t soft_sample(avr_t *avr, avr_cycle_count_t when, void *param)
+{
+	struct bench *b = param;
+
+	(void) avr;
+	(void) when;
+	if (b->soft_bit < BITS_PER_BYTE - 1)
+	{
+		b->soft_byte |= b->soft_level << (b->soft_bit - 1);
+		b->soft_bit++;
+		return b->soft_start + (avr_cycle_count_t) ((b->soft_bit + 0.5) * b->bit_cycles);
+	}
+	b->soft_bit = -1;
+	if (!b->soft_level)
+	{
+		b->framing_errors++;
+		return 0;
+	}
+	b->soft_bytes++;
+	output_byte(b, b->soft_byte, b->soft_start + (avr_cycle_count_t) (BITS_PER_BYTE * b->bit_cycles));
+	return 0;
+}
+
+/*
+ * Function: soft_edge
+ * -------------------
+ *   Software UART pin change handler. A falling edge on the idle line
+ *   starts a byte. Every edge inside a byte is compared to the nearest bit
+ *   boundary of the byte, and the time from the previous edge gives the
+ *   width of the bits between them.
+ *
+ *   returns:	none
+ */
+static void soft_edge(struct avr_irq_t *irq, uint32_t value, void *param)
+{
+	struct bench *b = param;
+	int level = value != 0;
+
+	(void) irq;
+	if (level == b->soft_level)
+		return;
+	b->soft_level = level;
+	if (b->soft_bit < 0)
+	{
+		if (level)
+			return;
+		b->soft_start = b->avr->cycle;
+		b->soft_edge = b->avr->cycle;
+		b->soft_bit = 1;
+		b->soft_byte = 0;
+		avr_cycle_timer_register(b->avr, (avr_cycle_count_t) (1.5 * b->bit_cycles), soft_sample, b);
+	}
+	else
+	{
+		double t = (double) (b->avr->cycle - b->soft_start) / b->bit_cycles;
+		double err = (t - (long) (t + 0.5)) * b->bit_cycles;
+		double span = b->avr->cycle - b->soft_edge;
+		long bits = (long) (span / b->bit_cycles + 0.5);
+
+		if (err < 0)
+			err = -err;
+		if (err > b->max_edge_error)
+			b->max_edge_error = err;
+		if (bits > 0)
+		{
+			if (b->min_bit == 0 || span / bits < b->min_bit)
+				b->min_bit = span / bits;
+			if (span / bits > b->max_bit)
+				b->max_bit = span / bits;
+		}
+		b->soft_edge = b->avr->cycle;
+	}
+}
+
+/*
+ * Function: trace_write
+ * ---------------------
+ *   GPIOR0 write handler. Accounts main loop cycles between two trace
+ *   points to the state written first, excluding ISR cycles.
+ *
+ *   returns:	none
+ */
+static void trace_write(avr_t *avr, avr_io_addr_t addr, uint8_t v, void *param)
+{
+	struct bench *b = param;
+
+	avr->data[addr] = v;
+	if (v == TRACE_IDLE)
+	{
+		uint8_t state = b->trace_state;
+		uint8_t res = avr->data[GPIOR1_ADDR];
+		avr_cycle_count_t cycles;
+
+		if (state == TRACE_IDLE)
+			return;
+		cycles = avr->cycle - b->trace_start - (b->isr_cycles - b->trace_isr);
+		if (state == TRACE_HANDOFF)
+		{
+			acc_add(&b->states[ST_HANDOFF], cycles);
+		}
+		else if (state == TRACE_UBX)
+		{
+			acc_add(&b->states[ST_UBX], cycles);
+		}
+		else if (state == TRACE_RENDER)
+		{
+			acc_add(&b->states[ST_RENDER], cycles);
+		}
+		else if (state == TRACE_TELEMETRY)
+		{
+			acc_add(&b->states[ST_TELEMETRY], cycles);
+		}
+		else
+		{
+			if (res < sizeof(b->results) / sizeof(b->results[0]))
+				b->results[res]++;
+			acc_add(&b->states[res == VX8_NONE || res == VX8_FIELD ? state : ST_RESET], cycles);
+		}
+		avr->data[GPIOR1_ADDR] = VX8_NONE;
+	}
+	b->trace_state = v;
+	b->trace_start = avr->cycle;
+	b->trace_isr = b->isr_cycles;
+}
+
+static void rx_pending(struct avr_irq_t *irq, uint32_t value, void *param)
+{
+	struct bench *b = param;
+
+	(void) irq;
+	if (value && !b->rx_pending_set)
+	{
+		b->rx_pending = b->avr->cycle;
+		b->rx_pending_set = 1;
+	}
+}
+
+static void rx_running(struct avr_irq_t *irq, uint32_t value, void *param)
+{
+	struct bench *b = param;
+
+	(void) irq;
+	if (value)
+	{
+		b->rx_isr_count++;
+		b->isr_start = b->avr->cycle;
+		if (b->rx_pending_set)
+			acc_add(&b->rx_latency, b->avr->cycle - b->rx_pending);
+		b->rx_pending_set = 0;
+	}
+	else
+	{
+		b->isr_cycles += b->avr->cycle - b->isr_start;
+	}
+}
+
+static void tx_running(struct avr_irq_t *irq, uint32_t value, void *param)
+{
+	struct bench *b = param;
+
+	(void) irq;
+	if (value)
+		b->isr_start = b->avr->cycle;
+	else
+		b->isr_cycles += b->avr->cycle - b->isr_start;
+}
+
+/*
+ * Function: find_symbol
+ * ---------------------
+ *   Looks up a data symbol in the symbol table of a 32 bit ELF file.
+ *
+ *   returns:	1 and its data space address and size if found, 0 otherwise.
+ */
+static int find_symbol(const char *file, const char *name, uint32_t *addr, uint32_t *size)
+{
+	FILE *f = fopen(file, "rb");
+	Elf32_Ehdr eh;
+	Elf32_Shdr *sh = NULL;
+	int found = 0;
+
+	if (f == NULL)
+		return 0;
+	if (fread(&eh, sizeof(eh), 1, f) != 1 || memcmp(eh.e_ident, ELFMAG, SELFMAG) != 0)
+		goto out;
+	sh = calloc(eh.e_shnum, sizeof(*sh));
+	fseek(f, eh.e_shoff, SEEK_SET);
+	if (fread(sh, sizeof(*sh), eh.e_shnum, f) != eh.e_shnum)
+		goto out;
+	for (unsigned i = 0; i < eh.e_shnum && !found; i++)
+	{
+		Elf32_Shdr *strtab = &sh[sh[i].sh_link];
+		char *str;
+
+		if (sh[i].sh_type != SHT_SYMTAB)
+			continue;
+		str = malloc(strtab->sh_size);
+		fseek(f, strtab->sh_offset, SEEK_SET);
+		if (fread(str, 1, strtab->sh_size, f) == strtab->sh_size)
+		{
+			for (unsigned j = 0; j < sh[i].sh_size / sizeof(Elf32_Sym); j++)
+			{
+				Elf32_Sym sym;
+				fseek(f, sh[i].sh_offset + j * sizeof(sym), SEEK_SET);
+				if (fread(&sym, sizeof(sym), 1, f) != 1)
+					break;
+				if (sym.st_name < strtab->sh_size && strcmp(str + sym.st_name, name) == 0)
+				{
+					*addr = sym.st_value - DATA_OFFSET;
+					*size = sym.st_size;
+					found = 1;
+					break;
+				}
+			}
+		}
+		free(str);
+	}
+out:
+	free(sh);
+	fclose(f);
+	return found;
+}
+
+static uint8_t *read_input(int count, char *files[], size_t *len)
+{
+	uint8_t *data = NULL;
+
+	*len = 0;
+	for (int i = 0; i < count; i++)
+	{
+		FILE *f = fopen(files[i], "rb");
+		long size;
+
+		if (f == NULL)
+		{
+			perror(files[i]);
+			exit(1);
+		}
+		fseek(f, 0, SEEK_END);
+		size = ftell(f);
+		fseek(f, 0, SEEK_SET);
+		data = realloc(data, *len + size);
+		*len += fread(data + *len, 1, size, f);
+		fclose(f);
+	}
+	return data;
+}
+
+static double cycles_ms(avr_cycle_count_t cycles, uint32_t frequency)
+{
+	return cycles ? cycles * 1000.0 / frequency : -1.0;
+}
+
+static void print_acc(FILE *f, const char *name, const struct stat_acc *acc, double scale, const char *sep)
+{
+	fprintf(f, "\t\t\"%s\": { \"count\": %lu, \"avg\": %.2f, \"max\": %.2f }%s\n", name,
+			acc->count, acc->count ? acc->sum * scale / acc->count : 0.0, acc->max * scale, sep);
+}
+
+static void print_samples(FILE *f, const char *name, struct samples *s, double scale, const char *sep)
+{
+	static const unsigned percentiles[] = { 50, 90, 99 };
+
+	fprintf(f, "\t\t\"%s\": { \"count\": %zu", name, s->count);
+	if (s->count)
+	{
+		qsort(s->values, s->count, sizeof(s->values[0]), compare_ll);
+		for (unsigned i = 0; i < sizeof(percentiles) / sizeof(percentiles[0]); i++)
+			fprintf(f, ", \"p%u\": %.2f", percentiles[i],
+					s->values[(s->count - 1) * percentiles[i] / 100] * scale);
+		fprintf(f, ", \"max\": %.2f", s->values[s->count - 1] * scale);
+	}
+	fprintf(f, " }%s\n", sep);
+}
+
+static void report(FILE *f, struct bench *b, const char *elf, uint32_t frequency, unsigned rate, int soft_tx)
+{
+	avr_cycle_count_t total = b->active_cycles + b->sleep_cycles;
+	unsigned epochs = rate ? b->epoch_count + 1 : 1;
+	/* Baud rate USART0 was set up for. */
+	unsigned ubrr = b->avr->data[UBRR0L_ADDR] | (b->avr->data[UBRR0H_ADDR] & 0x0F) << 8;
+	unsigned divider = b->avr->data[UCSR0A_ADDR] & (1 << U2X0_BIT) ? 8 : 16;
+	double usart_baud = (double) frequency / (divider * (ubrr + 1));
+
+	size_t sent_bytes = b->input_pos - b->gps_drop_bytes;
+	unsigned long dropped_usart = sent_bytes > b->rx_isr_count ? sent_bytes - b->rx_isr_count : 0;
+
+	fprintf(f, "{\n");
+	fprintf(f, "\t\"firmware\": \"%s\",\n", elf);
+	fprintf(f, "\t\"frequency\": %u,\n", frequency);
+	fprintf(f, "\t\"input_bytes\": %zu,\n", sent_bytes);
+	fprintf(f, "\t\"gps_dropped_sentences\": %lu,\n", b->gps_drops);
+	fprintf(f, "\t\"cycles_per_byte\": {\n");
+	for (int i = 0; i < ST_COUNT; i++)
+		print_acc(f, state_names[i], &b->states[i], 1.0, i < ST_COUNT - 1 ? "," : "");
+	fprintf(f, "\t},\n");
+	fprintf(f, "\t\"rx_isr_latency_cycles\": {\n");
+	print_acc(f, "USART_RX_vect", &b->rx_latency, 1.0, "");
+	fprintf(f, "\t},\n");
+	fprintf(f, "\t\"sentence_latency_ms\": {\n");
+	print_acc(f, "end_to_end", &b->sentence_latency, 1000.0 / frequency, ",");
+	print_samples(f, "first_byte", &b->first_latency, 1000.0 / frequency, ",");
+	print_samples(f, "last_byte", &b->last_latency, 1000.0 / frequency, "");
+	fprintf(f, "\t},\n");
+	fprintf(f, "\t\"results\": {");
+	for (unsigned i = VX8_FRAME; i < sizeof(b->results) / sizeof(b->results[0]); i++)
+		fprintf(f, " \"%s\": %lu%s", result_names[i], b->results[i],
+				i < sizeof(b->results) / sizeof(b->results[0]) - 1 ? "," : "");
+	fprintf(f, " },\n");
+	fprintf(f, "\t\"dropped_bytes\": { \"usart\": %lu, \"ring_buffer\": %ld },\n", dropped_usart, b->ring_overflows);
+	fprintf(f, "\t\"tx_queue\": { \"high_water\": %ld },\n", b->tx_high_water);
+	fprintf(f, "\t\"usart\": { \"baudrate\": %u, \"actual\": %.0f, \"error_pct\": %.2f },\n",
+			b->baudrate, usart_baud, (usart_baud / b->baudrate - 1.0) * 100.0);
+	if (soft_tx)
+		fprintf(f, "\t\"soft_tx\": { \"baudrate\": %u, \"bytes\": %lu, \"framing_errors\": %lu, "
+				"\"max_edge_error_cycles\": %.1f, \"max_edge_error_pct\": %.2f,\n"
+				"\t\t\"bit_cycles\": %.2f, \"min_bit_cycles\": %.2f, \"max_bit_cycles\": %.2f, "
+				"\"min_bit_error_pct\": %.2f, \"max_bit_error_pct\": %.2f },\n",
+				BAUDRATE, b->soft_bytes, b->framing_errors, b->max_edge_error,
+				b->max_edge_error * 100.0 / b->bit_cycles, b->bit_cycles, b->min_bit, b->max_bit,
+				(b->min_bit / b->bit_cycles - 1.0) * 100.0, (b->max_bit / b->bit_cycles - 1.0) * 100.0);
+	if (b->pps_pin)
+	{
+		fprintf(f, "\t\"pps\": { \"pulses\": %lu, \"untimed\": %lu, \"late_frames\": %ld,\n", b->pps_pulses,
+				b->pps_untimed, b->pps_late);
+		print_acc(f, "error_ms", &b->pps_error, 1000.0 / frequency, ",");
+		print_acc(f, "first_sentence_ms", &b->pps_phase, 1000.0 / frequency, "");
+		fprintf(f, "\t},\n");
+	}
+	fprintf(f, "\t\"sentences\": { \"sent\": %lu, \"missing\": %lu, \"mismatched\": %lu, \"last_known\": %lu, "
+			"\"telemetry\": %lu },\n", b->sent, b->missing, b->mismatched, b->last_known, b->telemetry);
+	fprintf(f, "\t\"ttff_ms\": { \"first_sentence\": %.1f, \"first_fix\": %.1f, \"first_gps_fix\": %.1f },\n",
+			cycles_ms(b->first_sentence, frequency), cycles_ms(b->first_fix, frequency),
+			cycles_ms(b->first_gps_fix, frequency));
+	/* The main loop of the original sketch polled the USART and never slept. */
+	fprintf(f, "\t\"cpu\": { \"epoch_rate\": %u, \"epochs\": %u, \"active_cycles_per_epoch\": %.0f, "
+			"\"sleep_cycles_per_epoch\": %.0f, \"duty_cycle\": %.4f, \"awake_saved_vs_busy_poll_pct\": %.1f }\n",
+			rate, rate ? epochs : 0, (double) b->active_cycles / epochs, (double) b->sleep_cycles / epochs,
+			total ? (double) b->active_cycles / total : 0.0, total ? 100.0 * b->sleep_cycles / total : 0.0);
+	fprintf(f, "}\n");
+}
+
+int main(int argc, char *argv[])
+{
+	struct bench b;
+	elf_firmware_t fw;
+	uint32_t frequency = 16000000;
+	unsigned rate = 0;
+	const char *out_file = NULL;
+	const char *eeprom_in = NULL;
+	const char *eeprom_out = NULL;
+	uint8_t eeprom[EEPROM_SIZE];
+	avr_eeprom_desc_t ee = { .ee = eeprom, .offset = 0, .size = EEPROM_SIZE };
+	const char *elf;
+	int soft_tx = 0;
+	int pps = 0;
+	uint32_t flags = 0;
+	uint32_t addr, size;
+	avr_irq_t *irq;
+	int opt, state;
+	FILE *out = stdout;
+
+	memset(&b, 0, sizeof(b));
+	b.baudrate = BAUDRATE;
+	while ((opt = getopt(argc, argv, "f:o:r:b:supe:E:")) != -1)
+	{
+		switch (opt)
+		{
+		case 'f':
+			frequency = strtoul(optarg, NULL, 0);
+			break;
+		case 'b':
+			b.baudrate = strtoul(optarg, NULL, 0);
+			break;
+		case 's':
+			soft_tx = 1;
+			break;
+		case 'u':
+			b.ubx_input = 1;
+			break;
+		case 'p':
+			pps = 1;
+			break;
+		case 'r':
+			rate = strtoul(optarg, NULL, 0);
+			break;
+		case 'o':
+			out_file = optarg;
+			break;
+		case 'e':
+			eeprom_in = optarg;
+			break;
+		case 'E':
+			eeprom_out = optarg;
+			break;
+		default:
+			goto usage;
+		}
+	}
+	if (argc - optind < 2)
+		goto usage;
+	elf = argv[optind];
+	if (b.baudrate == 0 || (pps && rate == 0))
+		goto usage;
+
+	memset(&fw, 0, sizeof(fw));
+	b.trace_state = TRACE_IDLE;
+	b.input = read_input(argc - optind - 1, argv + optind + 1, &b.input_len);
+	vx8_init(&b.host, &b.host_frame);
+	ubx_init(&b.host_ubx);
+
+	if (elf_read_firmware(elf, &fw) != 0)
+	{
+		fprintf(stderr, "%s: can't read firmware\n", elf);
+		return 1;
+	}
+	b.avr = avr_make_mcu_by_name("atmega328p");
+	if (b.avr == NULL)
+	{
+		fprintf(stderr, "atmega328p isn't supported by simavr\n");
+		return 1;
+	}
+	avr_init(b.avr);
+	fw.frequency = frequency;
+	avr_load_firmware(b.avr, &fw);
+	b.avr->frequency = frequency;
+	if (eeprom_in)
+	{
+		/* Erased EEPROM reads 0xFF. */
+		FILE *f = fopen(eeprom_in, "rb");
+		memset(eeprom, 0xFF, sizeof(eeprom));
+		if (f == NULL)
+		{
+			perror(eeprom_in);
+			return 1;
+		}
+		if (fread(eeprom, 1, sizeof(eeprom), f) == 0)
+			fprintf(stderr, "%s: empty, using erased EEPROM\n", eeprom_in);
+		fclose(f);
+		avr_ioctl(b.avr, AVR_IOCTL_EEPROM_SET, &ee);
+	}
+
+	/* The bytes are compared here, don't echo them to stdout. */
+	avr_ioctl(b.avr, AVR_IOCTL_UART_GET_FLAGS('0'), &flags);
+	flags &= ~AVR_UART_FLAG_STDIO;
+	avr_ioctl(b.avr, AVR_IOCTL_UART_SET_FLAGS('0'), &flags);
+
+	b.uart_in = avr_io_getirq(b.avr, AVR_IOCTL_UART_GETIRQ('0'), UART_IRQ_INPUT);
+	irq = avr_io_getirq(b.avr, AVR_IOCTL_UART_GETIRQ('0'), UART_IRQ_OUTPUT);
+	avr_irq_register_notify(irq, uart_output, &b);
+	irq = avr_get_interrupt_irq(b.avr, USART_RX_VECT);
+	avr_irq_register_notify(irq + AVR_INT_IRQ_PENDING, rx_pending, &b);
+	avr_irq_register_notify(irq + AVR_INT_IRQ_RUNNING, rx_running, &b);
+	irq = avr_get_interrupt_irq(b.avr, USART_UDRE_VECT);
+	avr_irq_register_notify(irq + AVR_INT_IRQ_RUNNING, tx_running, &b);
+	irq = avr_get_interrupt_irq(b.avr, TIMER1_COMPA_VECT);
+	avr_irq_register_notify(irq + AVR_INT_IRQ_RUNNING, tx_running, &b);
+	avr_register_io_write(b.avr, GPIOR0_ADDR, trace_write, &b);
+	b.bit_cycles = (double) frequency / BAUDRATE;
+	b.soft_level = 1;
+	b.soft_bit = -1;
+	if (soft_tx)
+	{
+		irq = avr_io_getirq(b.avr, AVR_IOCTL_IOPORT_GETIRQ(SOFT_TX_PORT), SOFT_TX_PIN);
+		avr_irq_register_notify(irq, soft_edge, &b);
+	}
+
+	/* Start feeding after the firmware had time to initialize. */
+	b.byte_cycles = (avr_cycle_count_t) frequency * BITS_PER_BYTE / b.baudrate;
+	b.out_byte_cycles = (avr_cycle_count_t) frequency * BITS_PER_BYTE / BAUDRATE;
+	b.window_start = 10 * b.out_byte_cycles;
+	b.window_end = (avr_cycle_count_t) -1;
+	if (rate)
+	{
+		split_epochs(&b);
+		b.epoch_cycles = frequency / rate;
+		b.window_end = b.window_start + (b.epoch_count + 1) * b.epoch_cycles;
+	}
+	avr_cycle_timer_register(b.avr, b.window_start, feed_byte, &b);
+	if (pps)
+	{
+		b.pps_pin = avr_io_getirq(b.avr, AVR_IOCTL_IOPORT_GETIRQ(PPS_PORT), PPS_PIN);
+		avr_cycle_timer_register(b.avr, b.window_start, pps_pulse, &b);
+	}
+
+	do
+	{
+		int sleeping = b.avr->state == cpu_Sleeping;
+		avr_cycle_count_t cycle = b.avr->cycle;
+
+		state = avr_run(b.avr);
+		count_cycles(&b, cycle, b.avr->cycle, sleeping);
+		if (b.input_pos < b.input_len)
+			continue;
+		if (rate ? b.avr->cycle >= b.window_end : b.avr->cycle - b.last_output > IDLE_BYTES * b.out_byte_cycles)
+			break;
+	} while (state != cpu_Done && state != cpu_Crashed);
+
+	b.ring_overflows = -1;
+	if (find_symbol(elf, "rx_ring", &addr, &size))
+	{
+		/* overflows is the last member of struct ring_buffer. */
+		b.ring_overflows = b.avr->data[addr + size - 1];
+	}
+	b.tx_high_water = -1;
+	if (find_symbol(elf, "tx_high_water", &addr, &size))
+	{
+		b.tx_high_water = b.avr->data[addr];
+	}
+	b.pps_late = -1;
+	if (find_symbol(elf, "pps", &addr, &size))
+	{
+		/* late is the last member of struct pps, little-endian. */
+		b.pps_late = b.avr->data[addr + size - 2] | b.avr->data[addr + size - 1] << 8;
+	}
+	while (b.head)
+	{
+		struct expected *e = b.head;
+		b.head = e->next;
+		b.missing++;
+		free(e);
+	}
+
+	if (eeprom_out)
+	{
+		FILE *f = fopen(eeprom_out, "wb");
+		if (f == NULL || avr_ioctl(b.avr, AVR_IOCTL_EEPROM_GET, &ee) < 0
+				|| fwrite(eeprom, 1, sizeof(eeprom), f) != sizeof(eeprom))
+		{
+			perror(eeprom_out);
+			return 1;
+		}
+		fclose(f);
+	}
+
+	if (out_file && (out = fopen(out_file, "w")) == NULL)
+	{
+		perror(out_file);
+		return 1;
+	}
+	report(out, &b, elf, frequency, rate, soft_tx);
+	if (out != stdout)
+		fclose(out);
+	if (state == cpu_Crashed)
+	{
+		fprintf(stderr, "%s: simulation crashed\n", elf);
+		return 1;
+	}
+	return b.missing || b.mismatched || b.framing_errors ? 2 : 0;
+
+usage:
+	fprintf(stderr, "usage: %s [-f frequency] [-r epoch_rate] [-b input_baudrate] [-s] [-u] [-p] [-e eeprom.bin] "
+			"[-E eeprom.bin] [-o result.json] vx8_gps.elf capture...\n", argv[0]);
+	return 1;
+}
@@ -0,0 +1,430 @@
+/*
+ * bench_bridge.c
+ *
+ *  Created on: 16 Oct 2026
+ *  Author: Dmitry Melnichansky / 4Z7DTF
+ *
+ *  Host benchmark of the serial bridge with ptys, like the ones socat
+ *  creates, for the GPS and each sink. The bridge runs in a thread.
+ *  For 1 to 64 sinks:
+ *  - latency: the captures are written line by line and after every line
+ *    which gives a frame all sinks are read until they have it. The frame
+ *    must be the one vx8_feed() gives, the time from writing the line to
+ *    the last sink having the frame is reported as percentiles;
+ *  - throughput: the captures are written repeatedly as fast as the pty
+ *    takes them while all sinks are read. The queues are made long enough
+ *    for the whole run, so the sentences per second in and the frames per
+ *    second out show what the bridge can do, not how fast the benchmark
+ *    reads; the frames dropped must be 0.
+ *  Then one of 4 sinks isn't read at all: the other 3 must still get every
+ *  frame and the stuck one must drop its oldest frames. When the GPS ends
+ *  the stuck sink must be closed after drain_ms, so the bridge returns.
+ *
+ *  Build and run:
+ *    make bench
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <pty.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include "../src/vx8_bridge.h"
+
+#if !defined(__linux__) || defined(VX8_CUT_THROUGH)
+int main(void)
+{
+	printf("bench_bridge: needs Linux and isn't available with VX8_CUT_THROUGH\n");
+	return 0;
+}
+#else
+
+#define MAX_SINKS 64
+#define MAX_LINES 4096
+#define LATENCY_FRAMES 1000
+#define THROUGHPUT_REPEAT 20
+#define STUCK_REPEAT 50
+#define STUCK_DRAIN_MS 200
+
+struct line
+{
+	const uint8_t *start;
+	size_t len;
+	uint8_t frame[VX8_BUFFER_SIZE];
+	uint8_t frame_len;
+};
+
+struct setup
+{
+	int source; /* Written by the benchmark. */
+	int source_port; /* Read by the bridge. */
+	int sinks[MAX_SINKS]; /* Read by the benchmark. */
+	int sink_ports[MAX_SINKS]; /* Written by the bridge. */
+	unsigned count;
+	struct vx8_bridge bridge;
+	pthread_t thread;
+};
+
+struct feeder
+{
+	int fd;
+	unsigned repeat;
+};
+
+static uint8_t capture[1 << 20];
+static size_t capture_len;
+static struct line lines[MAX_LINES];
+static unsigned line_count;
+static size_t frames_len; /* Bytes of the frames of one pass over the captures. */
+static unsigned frame_count;
+static uint8_t *received[MAX_SINKS];
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int compare_double(const void *a, const void *b)
+{
+	double x = *(const double *) a;
+	double y = *(const double *) b;
+	return (x > y) - (x < y);
+}
+
+/* Splits the captures into lines with the frame each one gives. */
+static void split(void)
+{
+	struct vx8 ctx;
+	struct vx8_frame frame;
+	size_t start = 0;
+
+	vx8_init(&ctx, &frame);
+	for (size_t i = 0; i < capture_len && line_count < MAX_LINES; i++)
+	{
+		struct line *l = &lines[line_count];
+		if (vx8_feed(&ctx, capture[i]) == VX8_FRAME)
+		{
+			memcpy(l->frame, frame.buffer, frame.len);
+			l->frame_len = frame.len;
+		}
+		if (capture[i] == '\n' || i == capture_len - 1)
+		{
+			l->start = capture + start;
+			l->len = i + 1 - start;
+			frames_len += l->frame_len;
+			frame_count += l->frame_len > 0;
+			line_count++;
+			start = i + 1;
+		}
+	}
+}
+
+static int open_pty(int *master, int *slave)
+{
+	struct termios tio;
+
+	if (openpty(master, slave, NULL, NULL, NULL) != 0)
+	{
+		perror("openpty");
+		return 0;
+	}
+	tcgetattr(*slave, &tio);
+	cfmakeraw(&tio);
+	tcsetattr(*slave, TCSANOW, &tio);
+	return 1;
+}
+
+static void *run_bridge(void *arg)
+{
+	struct setup *s = arg;
+	vx8_bridge_run(&s->bridge);
+	return NULL;
+}
+
+static int start(struct setup *s, unsigned count, unsigned queue_size, unsigned drain_ms)
+{
+	memset(s, 0, sizeof(*s));
+	s->count = count;
+	if (!open_pty(&s->source, &s->source_port))
+	{
+		return 0;
+	}
+	for (unsigned i = 0; i < count; i++)
+	{
+		if (!open_pty(&s->sinks[i], &s->sink_ports[i]))
+		{
+			return 0;
+		}
+	}
+	if (vx8_bridge_init(&s->bridge, s->source_port, s->sink_ports, count, queue_size) != 0)
+	{
+		perror("vx8_bridge_init");
+		return 0;
+	}
+	s->bridge.drain_ms = drain_ms;
+	pthread_create(&s->thread, NULL, run_bridge, s);
+	return 1;
+}
+
+/* Closing the GPS side of the source pty ends the bridge. The sink
+ * counters stay until vx8_bridge_close().
+ */
+static void stop(struct setup *s)
+{
+	close(s->source);
+	pthread_join(s->thread, NULL);
+	close(s->source_port);
+	for (unsigned i = 0; i < s->count; i++)
+	{
+		close(s->sinks[i]);
+		close(s->sink_ports[i]);
+	}
+}
+
+static void write_all(int fd, const uint8_t *p, size_t len)
+{
+	while (len > 0)
+	{
+		ssize_t n = write(fd, p, len);
+		if (n < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			perror("write");
+			exit(1);
+		}
+		p += n;
+		len -= (size_t) n;
+	}
+}
+
+/* Reads len bytes from the sink into buffer. */
+static int read_frame(int fd, uint8_t *buffer, size_t len)
+{
+	size_t got = 0;
+
+	while (got < len)
+	{
+		struct pollfd pfd = { fd, POLLIN, 0 };
+		ssize_t n;
+		if (poll(&pfd, 1, 1000) <= 0)
+		{
+			return 0;
+		}
+		n = read(fd, buffer + got, len - got);
+		if (n <= 0)
+		{
+			return 0;
+		}
+		got += (size_t) n;
+	}
+	return 1;
+}
+
+static void *feed(void *arg)
+{
+	struct feeder *f = arg;
+	for (unsigned r = 0; r < f->repeat; r++)
+	{
+		write_all(f->fd, capture, capture_len);
+	}
+	return NULL;
+}
+
+/* Reads the sinks from first on until each has len bytes or nothing comes
+ * for a second.
+ */
+static void read_sinks(struct setup *s, unsigned first, size_t len, size_t got[])
+{
+	struct pollfd pfd[MAX_SINKS];
+
+	for (;;)
+	{
+		unsigned n = 0;
+		for (unsigned i = first; i < s->count; i++)
+		{
+			if (got[i] < len)
+			{
+				pfd[n].fd = s->sinks[i];
+				pfd[n].events = POLLIN;
+				n++;
+			}
+		}
+		if (n == 0 || poll(pfd, n, 1000) <= 0)
+		{
+			return;
+		}
+		for (unsigned i = first, j = 0; i < s->count; i++)
+		{
+			if (got[i] >= len)
+			{
+				continue;
+			}
+			if (pfd[j++].revents & POLLIN)
+			{
+				ssize_t r = read(s->sinks[i], received[i] + got[i], len - got[i]);
+				got[i] += r > 0 ? (size_t) r : 0;
+			}
+		}
+	}
+}
+
+static int bench(unsigned count)
+{
+	static double latency[LATENCY_FRAMES];
+	struct setup s;
+	struct feeder f;
+	pthread_t thread;
+	size_t got[MAX_SINKS] = { 0 };
+	size_t total = frames_len * THROUGHPUT_REPEAT;
+	unsigned long long written = 0;
+	unsigned long long dropped = 0;
+	unsigned n = 0;
+	double t;
+
+	if (!start(&s, count, frame_count * THROUGHPUT_REPEAT, VX8_BRIDGE_DRAIN_MS))
+	{
+		return 0;
+	}
+	/* Latency */
+	while (n < LATENCY_FRAMES)
+	{
+		for (unsigned i = 0; i < line_count && n < LATENCY_FRAMES; i++)
+		{
+			uint8_t buffer[VX8_BUFFER_SIZE];
+
+			t = now();
+			write_all(s.source, lines[i].start, lines[i].len);
+			if (lines[i].frame_len == 0)
+			{
+				continue;
+			}
+			for (unsigned k = 0; k < count; k++)
+			{
+				if (!read_frame(s.sinks[k], buffer, lines[i].frame_len)
+						|| memcmp(buffer, lines[i].frame, lines[i].frame_len) != 0)
+				{
+					printf("MISMATCH %u sinks: sink %u, line %u\n", count, k, i);
+					return 0;
+				}
+			}
+			latency[n++] = now() - t;
+		}
+	}
+	qsort(latency, n, sizeof(latency[0]), compare_double);
+
+	/* Throughput */
+	f.fd = s.source;
+	f.repeat = THROUGHPUT_REPEAT;
+	t = now();
+	pthread_create(&thread, NULL, feed, &f);
+	read_sinks(&s, 0, total, got);
+	pthread_join(thread, NULL);
+	t = now() - t;
+	stop(&s);
+	for (unsigned k = 0; k < count; k++)
+	{
+		written += s.bridge.sinks[k].frames;
+		dropped += s.bridge.sinks[k].dropped;
+	}
+	vx8_bridge_close(&s.bridge);
+	printf("%6u %10.1f %10.1f %10.1f %12.0f %12.0f %8llu\n", count, latency[n / 2] * 1e6, latency[n * 99 / 100] * 1e6,
+			latency[n - 1] * 1e6, line_count * THROUGHPUT_REPEAT / t, (written - (unsigned long long) n * count) / t, dropped);
+	return dropped == 0;
+}
+
+/* One sink of 4 isn't read, the others are read after every frame. */
+static int stuck(void)
+{
+	struct setup s;
+	const struct vx8_bridge_sink *sink;
+	double t;
+	int ok = 1;
+
+	if (!start(&s, 4, VX8_BRIDGE_QUEUE, STUCK_DRAIN_MS))
+	{
+		return 0;
+	}
+	for (unsigned r = 0; r < STUCK_REPEAT && ok; r++)
+	{
+		for (unsigned i = 0; i < line_count && ok; i++)
+		{
+			uint8_t buffer[VX8_BUFFER_SIZE];
+
+			write_all(s.source, lines[i].start, lines[i].len);
+			for (unsigned k = 1; k < 4 && ok && lines[i].frame_len; k++)
+			{
+				ok = read_frame(s.sinks[k], buffer, lines[i].frame_len)
+						&& memcmp(buffer, lines[i].frame, lines[i].frame_len) == 0;
+			}
+		}
+	}
+	/* The GPS ends while the stuck sink still holds its queue. */
+	t = now();
+	stop(&s);
+	t = now() - t;
+	sink = &s.bridge.sinks[0];
+	printf("stuck sink: %llu frames written, %llu dropped, at most %u of %u queued, closed after %.0fms; "
+			"other sinks: %s\n", sink->frames, sink->dropped, sink->max_count, VX8_BRIDGE_QUEUE, t * 1e3,
+			ok ? "all frames" : "MISMATCH");
+	for (unsigned k = 1; k < 4; k++)
+	{
+		ok = ok && s.bridge.sinks[k].dropped == 0 && !s.bridge.sinks[k].closed;
+	}
+	ok = ok && sink->dropped > 0 && sink->max_count <= VX8_BRIDGE_QUEUE && sink->closed
+			&& t * 1e3 < STUCK_DRAIN_MS * 2;
+	vx8_bridge_close(&s.bridge);
+	return ok;
+}
+
+int main(int argc, char *argv[])
+{
+	static const unsigned counts[] = { 1, 2, 4, 8, 16, 32, 64 };
+
+	for (int i = 1; i < argc; i++)
+	{
+		FILE *in = fopen(argv[i], "rb");
+		if (in == NULL)
+		{
+			perror(argv[i]);
+			return 1;
+		}
+		capture_len += fread(capture + capture_len, 1, sizeof(capture) - capture_len, in);
+		fclose(in);
+	}
+	if (capture_len == 0)
+	{
+		fprintf(stderr, "usage: bench_bridge capture...\n");
+		return 1;
+	}
+	split();
+	for (unsigned i = 0; i < MAX_SINKS; i++)
+	{
+		received[i] = malloc(frames_len * THROUGHPUT_REPEAT);
+	}
+	signal(SIGPIPE, SIG_IGN);
+
+	printf("%6s %10s %10s %10s %12s %12s %8s\n", "sinks", "p50 us", "p99 us", "max us", "sentences/s",
+			"frames/s out", "dropped");
+	for (unsigned i = 0; i < sizeof(counts) / sizeof(counts[0]); i++)
+	{
+		if (!bench(counts[i]))
+		{
+			return 1;
+		}
+	}
+	printf("(latency from writing a sentence to the GPS pty to the last sink having it)\n");
+	return stuck() ? 0 : 1;
+}
+
+#endif /* __linux__ && !VX8_CUT_THROUGH */
@@ -0,0 +1,289 @@
+/*
+ * bench_bulk.c
+ *
+ *  Created on: 16 Oct 2026
+ *  Author: Dmitry Melnichansky / 4Z7DTF
+ *
+ *  Host benchmark of the bulk transform. The captures given on the command
+ *  line are repeated into a large log and converted byte by byte with
+ *  vx8_feed(), which is the reference, and with vx8_bulk_convert() and
+ *  every kernel the CPU has. The output and the result counts must be
+ *  the same. They are also compared on a damaged copy of the log, with
+ *  bytes changed, dropped and duplicated and random buffer boundaries, so
+ *  the fallback to the transform and the carry-over between buffers are
+ *  checked too. GGA sentences converted to 87 to 92 bytes check the
+ *  overflow limit of VX8_BUFFER_SIZE. Then the throughput of each is
+ *  reported in GB/s.
+ *
+ *  Build and run:
+ *    make bench
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../src/vx8_bulk.h"
+
+#ifdef VX8_CUT_THROUGH
+int main(void)
+{
+	printf("bench_bulk: not available with VX8_CUT_THROUGH\n");
+	return 0;
+}
+#else
+
+#define LOG_SIZE (64UL << 20)
+#define DAMAGED_SIZE (4UL << 20)
+#define RUNS 3
+/* Fix quality widths of the boundary sentences: converted to 87 to 92 bytes. */
+#define BOUNDARY_COUNT 6
+#define BOUNDARY_SENT 4
+
+struct result
+{
+	uint8_t *out;
+	size_t len;
+	unsigned long long counts[VX8_RESULT_COUNT];
+};
+
+static uint8_t *log_data;
+static size_t log_len;
+static uint8_t *damaged;
+static size_t damaged_len;
+static unsigned long rnd_state = 1;
+
+static unsigned long rnd(unsigned long range)
+{
+	rnd_state = rnd_state * 1103515245UL + 12345UL;
+	return (rnd_state >> 8) % range;
+}
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int load(int argc, char *argv[])
+{
+	static uint8_t capture[1 << 20];
+	size_t capture_len = 0;
+
+	for (int i = 1; i < argc; i++)
+	{
+		FILE *in = fopen(argv[i], "rb");
+		if (in == NULL)
+		{
+			perror(argv[i]);
+			return 0;
+		}
+		capture_len += fread(capture + capture_len, 1, sizeof(capture) - capture_len, in);
+		fclose(in);
+	}
+	if (capture_len == 0)
+	{
+		fprintf(stderr, "usage: bench_bulk capture...\n");
+		return 0;
+	}
+	log_data = malloc(LOG_SIZE);
+	damaged = malloc(DAMAGED_SIZE);
+	for (log_len = 0; log_len + capture_len <= LOG_SIZE; log_len += capture_len)
+	{
+		memcpy(log_data + log_len, capture, capture_len);
+	}
+	/* Every 200 bytes on average one byte is changed, dropped or repeated. */
+	damaged_len = 0;
+	for (size_t i = 0; i < log_len && damaged_len < DAMAGED_SIZE - 1; i++)
+	{
+		static const uint8_t noise[] = { '$', '*', ',', '.', '\r', '\n', '0', 'A', 'x' };
+		switch (rnd(600))
+		{
+		case 0:
+			damaged[damaged_len++] = noise[rnd(sizeof(noise))];
+			break;
+		case 1:
+			break;
+		case 2:
+			damaged[damaged_len++] = log_data[i];
+			damaged[damaged_len++] = log_data[i];
+			break;
+		default:
+			damaged[damaged_len++] = log_data[i];
+		}
+	}
+	return 1;
+}
+
+static void reference(const uint8_t *in, size_t len, struct result *r)
+{
+	struct vx8 ctx;
+	struct vx8_frame frame;
+
+	memset(r->counts, 0, sizeof(r->counts));
+	r->len = 0;
+	vx8_init(&ctx, &frame);
+	for (size_t i = 0; i < len; i++)
+	{
+		uint8_t res = vx8_feed(&ctx, in[i]);
+		if (res == VX8_NONE)
+		{
+			continue;
+		}
+		r->counts[res]++;
+		if (res == VX8_FRAME)
+		{
+			memcpy(r->out + r->len, frame.buffer, frame.len);
+			r->len += frame.len;
+		}
+	}
+}
+
+/* max_block: largest buffer given to vx8_bulk_convert(), 0 for all at once. */
+static void bulk(uint8_t kernel, const uint8_t *in, size_t len, size_t max_block, struct result *r)
+{
+	static struct vx8_bulk b;
+	size_t done = 0;
+
+	vx8_bulk_init(&b, kernel);
+	r->len = 0;
+	while (done < len)
+	{
+		size_t block = max_block ? 1 + rnd(max_block) : len;
+		size_t out_len;
+		if (block > len - done)
+		{
+			block = len - done;
+		}
+		done += vx8_bulk_convert(&b, in + done, block, r->out + r->len, len * 2 + 1024 - r->len, &out_len);
+		r->len += out_len;
+	}
+	memcpy(r->counts, b.counts, sizeof(r->counts));
+}
+
+/* GGA sentences around the longest frame, VX8_BUFFER_SIZE bytes. */
+static size_t make_boundary(uint8_t *buf)
+{
+	static const char quality[] = "123456";
+	size_t len = 0;
+
+	for (int i = 1; i <= BOUNDARY_COUNT; i++)
+	{
+		char body[96];
+		uint8_t checksum = 0;
+		int n = snprintf(body, sizeof(body), "GPGGA,142449.000,3226.0583,N,03454.9160,E,%.*s,03,8.1,82.1,M,18.2,M,,0000",
+				i, quality);
+		for (int j = 0; j < n; j++)
+		{
+			checksum ^= (uint8_t) body[j];
+		}
+		len += sprintf((char *) buf + len, "$%s*%02X\r\n", body, checksum);
+	}
+	return len;
+}
+
+static int same(const char *name, const struct result *a, const struct result *b)
+{
+	if (a->len != b->len || memcmp(a->out, b->out, a->len) != 0)
+	{
+		size_t i = 0;
+		while (i < a->len && i < b->len && a->out[i] == b->out[i])
+		{
+			i++;
+		}
+		printf("MISMATCH %s: output differs at byte %zu\n", name, i);
+		return 0;
+	}
+	if (memcmp(a->counts, b->counts, sizeof(a->counts)) != 0)
+	{
+		printf("MISMATCH %s: result counts differ\n", name);
+		return 0;
+	}
+	return 1;
+}
+
+int main(int argc, char *argv[])
+{
+	struct result ref;
+	struct result res;
+	uint8_t boundary[BOUNDARY_COUNT * 96];
+	size_t boundary_len;
+	double best;
+	int ok = 1;
+
+	if (!load(argc, argv))
+	{
+		return 1;
+	}
+	ref.out = malloc(LOG_SIZE * 2 + 1024);
+	res.out = malloc(LOG_SIZE * 2 + 1024);
+
+	boundary_len = make_boundary(boundary);
+	reference(boundary, boundary_len, &ref);
+	if (ref.counts[VX8_FRAME] != BOUNDARY_SENT || ref.counts[VX8_REJECT_OVERFLOW] != BOUNDARY_COUNT - BOUNDARY_SENT)
+	{
+		printf("MISMATCH vx8_feed: %llu of %d boundary sentences sent\n", ref.counts[VX8_FRAME], BOUNDARY_COUNT);
+		return 1;
+	}
+	for (uint8_t k = VX8_BULK_SCALAR; k <= VX8_BULK_SSE2; k++)
+	{
+		static struct vx8_bulk probe;
+		if (!vx8_bulk_init(&probe, k))
+		{
+			continue;
+		}
+		reference(boundary, boundary_len, &ref);
+		bulk(k, boundary, boundary_len, 0, &res);
+		ok &= same(vx8_bulk_kernel_name(k), &ref, &res);
+		reference(damaged, damaged_len, &ref);
+		bulk(k, damaged, damaged_len, 0, &res);
+		ok &= same(vx8_bulk_kernel_name(k), &ref, &res);
+		bulk(k, damaged, damaged_len, 300, &res);
+		ok &= same(vx8_bulk_kernel_name(k), &ref, &res);
+	}
+	if (!ok)
+	{
+		return 1;
+	}
+
+	printf("%-10s %10s %10s %8s\n", "transform", "MB", "GB/s", "speedup");
+	best = 1e9;
+	for (int i = 0; i < RUNS; i++)
+	{
+		double t = now();
+		reference(log_data, log_len, &ref);
+		t = now() - t;
+		best = t < best ? t : best;
+	}
+	double ref_time = best;
+	printf("%-10s %10.1f %10.3f %7.2fx\n", "vx8_feed", log_len / 1e6, log_len / ref_time / 1e9, 1.0);
+	for (uint8_t k = VX8_BULK_SCALAR; k <= VX8_BULK_SSE2; k++)
+	{
+		static struct vx8_bulk probe;
+		if (!vx8_bulk_init(&probe, k))
+		{
+			continue;
+		}
+		best = 1e9;
+		for (int i = 0; i < RUNS; i++)
+		{
+			double t = now();
+			bulk(k, log_data, log_len, 0, &res);
+			t = now() - t;
+			best = t < best ? t : best;
+		}
+		if (!same(vx8_bulk_kernel_name(k), &ref, &res))
+		{
+			return 1;
+		}
+		printf("%-10s %10.1f %10.3f %7.2fx\n", vx8_bulk_kernel_name(k), log_len / 1e6, log_len / best / 1e9,
+				ref_time / best);
+	}
+	printf("(%llu sentences sent, %llu rejected, best of %d runs)\n", ref.counts[VX8_FRAME],
+			ref.counts[VX8_REJECT_TYPE] + ref.counts[VX8_REJECT_FIELD] + ref.counts[VX8_REJECT_OVERFLOW]
+					+ ref.counts[VX8_REJECT_CHECKSUM] + ref.counts[VX8_REJECT_SYNC], RUNS);
+	return 0;
+}
+
+#endif /* VX8_CUT_THROUGH */
@@ -0,0 +1,307 @@
+/*
+ * bench_parallel.c
+ *
+ *  Created on: 16 Oct 2026
+ *  Author: Dmitry Melnichansky / 4Z7DTF
+ *
+ *  Host benchmark of the multi-threaded conversion. First the output and
+ *  the result counts of vx8_parallel_convert() are compared with vx8_feed()
+ *  byte by byte on a damaged copy of the captures, with bytes changed,
+ *  dropped and duplicated, for several numbers of threads and chunk sizes
+ *  down to chunks shorter than a sentence. Then a large log, the captures
+ *  repeated or a file given with -f, is converted to /dev/null by one
+ *  vx8_bulk_convert() over the whole buffer, as vx8_convert does without
+ *  -j, and by vx8_parallel_convert() with 1, 2, 4, ... threads and with
+ *  the number of CPUs online. The throughput and the speedup against the
+ *  single-threaded conversion are reported.
+ *
+ *  Build and run:
+ *    make bench
+ *  On a large file, e.g. 10GB made of the captures:
+ *    build/host/bench_parallel -f big.txt -j 32 gps_output/gps_strings_fix.txt
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include "../src/vx8_parallel.h"
+
+#ifdef VX8_CUT_THROUGH
+int main(void)
+{
+	printf("bench_parallel: not available with VX8_CUT_THROUGH\n");
+	return 0;
+}
+#else
+
+#define DAMAGED_SIZE (8UL << 20)
+#define RUNS 3
+#define SINGLE_OUT_SIZE (1 << 20)
+
+struct result
+{
+	uint8_t *out;
+	size_t len;
+	unsigned long long counts[VX8_RESULT_COUNT];
+};
+
+static uint8_t capture[1 << 20];
+static uint8_t single_out[SINGLE_OUT_SIZE];
+static size_t capture_len;
+static unsigned long rnd_state = 1;
+
+static unsigned long rnd(unsigned long range)
+{
+	rnd_state = rnd_state * 1103515245UL + 12345UL;
+	return (rnd_state >> 8) % range;
+}
+
+/* 1, 2, 4, ... threads, with the number of CPUs in between. */
+static unsigned next_threads(unsigned threads, long cpus)
+{
+	unsigned next = 1;
+	while (next <= threads)
+	{
+		next *= 2;
+	}
+	return cpus > threads && cpus < next ? (unsigned) cpus : next;
+}
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* The captures repeated to len bytes, every 200 bytes on average one byte
+ * is changed, dropped or repeated if damage is set.
+ */
+static size_t make_log(uint8_t *log, size_t len, int damage)
+{
+	static const uint8_t noise[] = { '$', '*', ',', '.', '\r', '\n', '0', 'A', 'x' };
+	size_t n = 0;
+
+	for (size_t i = 0; n < len - 1; i = (i + 1) % capture_len)
+	{
+		switch (damage ? rnd(600) : 3)
+		{
+		case 0:
+			log[n++] = noise[rnd(sizeof(noise))];
+			break;
+		case 1:
+			break;
+		case 2:
+			log[n++] = capture[i];
+			log[n++] = capture[i];
+			break;
+		default:
+			log[n++] = capture[i];
+		}
+	}
+	return n;
+}
+
+static void reference(const uint8_t *in, size_t len, struct result *r)
+{
+	struct vx8 ctx;
+	struct vx8_frame frame;
+
+	memset(r->counts, 0, sizeof(r->counts));
+	r->len = 0;
+	vx8_init(&ctx, &frame);
+	for (size_t i = 0; i < len; i++)
+	{
+		uint8_t res = vx8_feed(&ctx, in[i]);
+		if (res == VX8_NONE)
+		{
+			continue;
+		}
+		r->counts[res]++;
+		if (res == VX8_FRAME)
+		{
+			memcpy(r->out + r->len, frame.buffer, frame.len);
+			r->len += frame.len;
+		}
+	}
+}
+
+static int parallel(const uint8_t *in, size_t len, unsigned threads, size_t chunk_size, uint8_t kernel,
+		struct result *r)
+{
+	struct vx8_parallel_stats stats;
+	FILE *out = tmpfile();
+
+	if (out == NULL || vx8_parallel_convert(in, len, fileno(out), threads, chunk_size, kernel, &stats) != 0)
+	{
+		perror("bench_parallel");
+		return 0;
+	}
+	r->len = (size_t) lseek(fileno(out), 0, SEEK_END);
+	lseek(fileno(out), 0, SEEK_SET);
+	if (read(fileno(out), r->out, r->len) != (ssize_t) r->len)
+	{
+		perror("bench_parallel");
+		return 0;
+	}
+	fclose(out);
+	memcpy(r->counts, stats.counts, sizeof(r->counts));
+	return 1;
+}
+
+/* Single-threaded conversion of the whole buffer, without the pool. */
+static void single(const uint8_t *in, size_t len, int out_fd, uint8_t kernel, uint8_t *out, size_t out_size)
+{
+	static struct vx8_bulk b;
+	size_t done = 0;
+
+	vx8_bulk_init(&b, kernel);
+	while (done < len)
+	{
+		size_t out_len;
+		done += vx8_bulk_convert(&b, in + done, len - done, out, out_size, &out_len);
+		if (write(out_fd, out, out_len) != (ssize_t) out_len)
+		{
+			perror("bench_parallel");
+			return;
+		}
+	}
+}
+
+static int same(const struct result *a, const struct result *b)
+{
+	return a->len == b->len && memcmp(a->out, b->out, a->len) == 0
+			&& memcmp(a->counts, b->counts, sizeof(a->counts)) == 0;
+}
+
+int main(int argc, char *argv[])
+{
+	static const unsigned test_threads[] = { 1, 3, 8 };
+	static const size_t test_chunks[] = { 50, 4096, 1 << 20 };
+	static struct vx8_bulk probe;
+	struct vx8_parallel_stats stats;
+	struct result ref;
+	struct result res;
+	const char *name = NULL;
+	size_t log_size = 128UL << 20;
+	unsigned max_threads = 16;
+	long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	uint8_t *log;
+	size_t log_len;
+	uint8_t kernel;
+	int out;
+	double base = 0;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-m") == 0 && i + 1 < argc)
+		{
+			log_size = (size_t) atol(argv[++i]) << 20;
+		}
+		else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc)
+		{
+			name = argv[++i];
+		}
+		else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+		{
+			max_threads = (unsigned) atoi(argv[++i]);
+			max_threads = max_threads ? max_threads : 1;
+		}
+		else
+		{
+			FILE *in = fopen(argv[i], "rb");
+			if (in == NULL)
+			{
+				perror(argv[i]);
+				return 1;
+			}
+			capture_len += fread(capture + capture_len, 1, sizeof(capture) - capture_len, in);
+			fclose(in);
+		}
+	}
+	if (capture_len == 0)
+	{
+		fprintf(stderr, "usage: bench_parallel [-m MB] [-f file] [-j threads] capture...\n");
+		return 1;
+	}
+	vx8_bulk_init(&probe, VX8_BULK_AUTO);
+	kernel = probe.kernel;
+
+	/* Equivalence */
+	log = malloc(DAMAGED_SIZE);
+	ref.out = malloc(DAMAGED_SIZE * 2);
+	res.out = malloc(DAMAGED_SIZE * 2);
+	log_len = make_log(log, DAMAGED_SIZE, 1);
+	reference(log, log_len, &ref);
+	for (unsigned t = 0; t < sizeof(test_threads) / sizeof(test_threads[0]); t++)
+	{
+		for (unsigned c = 0; c < sizeof(test_chunks) / sizeof(test_chunks[0]); c++)
+		{
+			if (!parallel(log, log_len, test_threads[t], test_chunks[c], kernel, &res))
+			{
+				return 1;
+			}
+			if (!same(&ref, &res))
+			{
+				printf("MISMATCH %u threads, %zu byte chunks\n", test_threads[t], test_chunks[c]);
+				return 1;
+			}
+		}
+	}
+	free(log);
+	free(ref.out);
+	free(res.out);
+
+	/* Scaling */
+	if (name)
+	{
+		struct stat st;
+		int fd = open(name, O_RDONLY);
+		if (fd < 0 || fstat(fd, &st) != 0
+				|| (log = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED)
+		{
+			perror(name);
+			return 1;
+		}
+		log_len = st.st_size;
+	}
+	else
+	{
+		log = malloc(log_size);
+		log_len = make_log(log, log_size, 0);
+	}
+	out = open("/dev/null", O_WRONLY);
+	printf("%8s %10s %10s %8s %10s\n", "threads", "MB", "GB/s", "speedup", "efficiency");
+	base = 1e9;
+	for (int i = 0; i < RUNS; i++)
+	{
+		double t = now();
+		single(log, log_len, out, kernel, single_out, SINGLE_OUT_SIZE);
+		t = now() - t;
+		base = t < base ? t : base;
+	}
+	printf("%8s %10.1f %10.3f %7.2fx\n", "single", log_len / 1e6, log_len / base / 1e9, 1.0);
+	for (unsigned threads = 1; threads <= max_threads; threads = next_threads(threads, cpus))
+	{
+		double best = 1e9;
+		for (int i = 0; i < RUNS; i++)
+		{
+			double t = now();
+			vx8_parallel_convert(log, log_len, out, threads, VX8_PARALLEL_CHUNK, kernel, &stats);
+			t = now() - t;
+			best = t < best ? t : best;
+		}
+		printf("%8u %10.1f %10.3f %7.2fx %9.0f%%\n", threads, log_len / 1e6, log_len / best / 1e9, base / best,
+				100.0 * base / best / threads);
+	}
+	printf("(%s kernel, %lu byte chunks, %llu chunks, %ld CPUs online, best of %d runs)\n",
+			vx8_bulk_kernel_name(kernel), VX8_PARALLEL_CHUNK, stats.chunks, cpus, RUNS);
+	return 0;
+}
+
+#endif /* VX8_CUT_THROUGH */
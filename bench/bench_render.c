@@ -0,0 +1,242 @@
+/*
+ * bench_render.c
+ *
+ *  Created on: 16 Oct 2026
+ *  Author: Dmitry Melnichansky / 4Z7DTF
+ *
+ *  Host benchmark of rendering sentences from a fix. Compares
+ *  render_sentence(), which writes every field, with render_cached(),
+ *  which rewrites only the fields changed since the last epoch, on
+ *  sequences of 1Hz epochs: without fix, a stationary fix with position
+ *  noise, a moving fix and the fixes read from the captures given on the
+ *  command line. Both must write the same sentences before they are
+ *  compared.
+ *
+ *  Build and run:
+ *    make bench
+ *
+ *  Time is measured with the time stamp counter on x86 and with
+ *  clock_gettime() in nanoseconds on other hosts.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "../src/vx8_core.h"
+#include "../src/gps_fix.h"
+#include "../src/render.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define TICKS() __rdtsc()
+#define TICK_UNIT "cycles"
+#else
+static unsigned long long ns_now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long long) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+#define TICKS() ns_now()
+#define TICK_UNIT "ns"
+#endif
+
+#define EPOCHS 3600
+#define ROUNDS 20
+
+static struct gps_fix epochs[EPOCHS];
+static unsigned epoch_count;
+static volatile uint8_t sink;
+static unsigned long rnd_state = 1;
+
+static int32_t rnd(int32_t range)
+{
+	rnd_state = rnd_state * 1103515245UL + 12345UL;
+	return (int32_t) ((rnd_state >> 16) % (2 * range + 1)) - range;
+}
+
+static void base_fix(struct gps_fix *fix, unsigned t)
+{
+	memset(fix, 0, sizeof(*fix));
+	fix->year = 2015;
+	fix->month = 12;
+	fix->day = 26;
+	fix->hour = (uint8_t) (14 + t / 3600);
+	fix->min = (uint8_t) (t / 60 % 60);
+	fix->sec = (uint8_t) (t % 60);
+	fix->itow = 0;
+	fix->time_valid = GPS_TIME_VALID_UTC;
+	fix->hdop = 9990;
+}
+
+static void make_no_fix(void)
+{
+	for (epoch_count = 0; epoch_count < EPOCHS; epoch_count++)
+	{
+		base_fix(&epochs[epoch_count], epoch_count);
+	}
+}
+
+/* moving: 0 for a receiver standing still, otherwise about 15 m/s. */
+static void make_fix(int moving)
+{
+	int32_t lat = 324343050;
+	int32_t lon = 349152670;
+	int32_t hmsl = 82100;
+
+	for (epoch_count = 0; epoch_count < EPOCHS; epoch_count++)
+	{
+		struct gps_fix *fix = &epochs[epoch_count];
+		base_fix(fix, epoch_count);
+		fix->fix_type = GPS_FIX_3D;
+		fix->fix_flags = GPS_FIX_OK;
+		fix->num_sv = (uint8_t) (8 + (epoch_count / 300) % 3);
+		fix->hdop = (uint16_t) (150 + (epoch_count / 60) % 4 * 10);
+		if (moving)
+		{
+			lat += 1000 + rnd(50);
+			lon += 1000 + rnd(50);
+			hmsl += rnd(300);
+		}
+		fix->lat = lat + rnd(30);
+		fix->lon = lon + rnd(30);
+		fix->hmsl = hmsl + (moving ? 0 : rnd(400));
+		fix->height = fix->hmsl + 18200;
+		fix->gspeed = moving ? (uint32_t) (1500 + rnd(100)) : (uint32_t) (rnd(3) + 3);
+		fix->heading = moving ? 4500000 + rnd(200000) : 0;
+	}
+}
+
+static int read_capture(const char *path)
+{
+	struct vx8 ctx;
+	struct vx8_frame frame;
+	struct gps_fix fix;
+	FILE *in = fopen(path, "rb");
+	int c;
+
+	if (in == NULL)
+	{
+		perror(path);
+		return 0;
+	}
+	memset(&fix, 0, sizeof(fix));
+	vx8_init(&ctx, &frame);
+	vx8_set_fix(&ctx, &fix);
+	epoch_count = 0;
+	while ((c = getc(in)) != EOF && epoch_count < EPOCHS)
+	{
+		if (vx8_feed(&ctx, (uint8_t) c) == VX8_FRAME && ctx.fix_updated && frame.type == SENTENCE_GGA
+				&& (fix.time_valid & GPS_TIME_VALID_UTC))
+		{
+			epochs[epoch_count++] = fix;
+		}
+	}
+	fclose(in);
+	return 1;
+}
+
+/* Both routines must write the same sentences. */
+static int check(const char *name)
+{
+	struct render_cache cache;
+	struct vx8_frame a;
+	struct vx8_frame b;
+
+	render_cache_init(&cache);
+	for (unsigned e = 0; e < epoch_count; e++)
+	{
+		for (uint8_t i = 0; i < SENTENCE_COUNT; i++)
+		{
+			uint8_t ra = render_sentence(&epochs[e], i, RENDER_VX8, &a);
+			uint8_t rb = render_cached(&cache, &epochs[e], i, &b);
+			if (ra != rb || (ra && (a.len != b.len || memcmp(a.buffer, b.buffer, a.len) != 0)))
+			{
+				printf("MISMATCH %s epoch %u:\n  %.*s  %.*s", name, e, ra ? a.len : 0, a.buffer, rb ? b.len : 0,
+						b.buffer);
+				return 0;
+			}
+		}
+	}
+	return 1;
+}
+
+static double run_full(void)
+{
+	struct vx8_frame frame;
+	unsigned long long start = TICKS();
+
+	for (int r = 0; r < ROUNDS; r++)
+	{
+		for (unsigned e = 0; e < epoch_count; e++)
+		{
+			for (uint8_t i = 0; i < SENTENCE_COUNT; i++)
+			{
+				render_sentence(&epochs[e], i, RENDER_VX8, &frame);
+				sink ^= frame.buffer[frame.len - 3];
+			}
+		}
+	}
+	return (double) (TICKS() - start) / ((double) ROUNDS * epoch_count);
+}
+
+static double run_cached(void)
+{
+	static struct render_cache cache;
+	struct vx8_frame frame;
+	unsigned long long start = TICKS();
+
+	for (int r = 0; r < ROUNDS; r++)
+	{
+		render_cache_init(&cache);
+		for (unsigned e = 0; e < epoch_count; e++)
+		{
+			for (uint8_t i = 0; i < SENTENCE_COUNT; i++)
+			{
+				render_cached(&cache, &epochs[e], i, &frame);
+				sink ^= frame.buffer[frame.len - 3];
+			}
+		}
+	}
+	return (double) (TICKS() - start) / ((double) ROUNDS * epoch_count);
+}
+
+static int bench(const char *name)
+{
+	double full;
+	double cached;
+
+	if (!check(name))
+	{
+		return 0;
+	}
+	if (epoch_count == 0)
+	{
+		printf("%-28s %7u %10s %10s %8s\n", name, 0U, "-", "-", "-");
+		return 1;
+	}
+	full = run_full();
+	cached = run_cached();
+	printf("%-28s %7u %10.1f %10.1f %7.2fx\n", name, epoch_count, full, cached, full / cached);
+	return 1;
+}
+
+int main(int argc, char *argv[])
+{
+	int ok = 1;
+
+	printf("%-28s %7s %10s %10s %8s\n", "epochs", "count", "full", "cached", "speedup");
+	make_no_fix();
+	ok &= bench("no fix");
+	make_fix(0);
+	ok &= bench("stationary fix");
+	make_fix(1);
+	ok &= bench("moving fix");
+	for (int i = 1; i < argc; i++)
+	{
+		const char *name = strrchr(argv[i], '/');
+		ok &= read_capture(argv[i]) && bench(name ? name + 1 : argv[i]);
+	}
+	printf("(%s per epoch of GGA, RMC and ZDA)\n", TICK_UNIT);
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,431 @@
+/*
+ * bench_replay.c
+ *
+ *  Created on: 16 Oct 2026
+ *  Author: Dmitry Melnichansky / 4Z7DTF
+ *
+ *  Timing model of the firmware on the host, for when simavr isn't at
+ *  hand; bench_avr runs the firmware itself (make bench-replay). The
+ *  captures are replayed with the wire timing of the GPS: 10 bits per byte
+ *  at the input baud rate, back to back, split into epochs starting with
+ *  RMC of any talker. Epochs start at the epoch rate, or right after the
+ *  sentence being sent. Like the GPS with a full TX buffer, a sentence
+ *  which can't start before the next epoch is dropped with the rest of its
+ *  epoch, so the input keeps the rate at any baud rate. The model uses the
+ *  firmware's own parts: every byte goes to the RX ring buffer of
+ *  ring_buffer.h when its stop bit ends, the main loop takes it and feeds
+ *  it to the transform, and a complete frame goes to the scheduler with
+ *  the frame pool of firmware.c. The transmitter works like
+ *  USART_UDRE_vect with the double buffered USART: it starts with the
+ *  frame chosen by the scheduler when it is idle, and takes the next frame
+ *  from the scheduler when the last byte of a frame moves to the shift
+ *  register, so frames follow without a gap. The main loop is taken as
+ *  instant unless -c gives the cycles it spends per byte at -f MHz, e.g.
+ *  from the cycles_per_byte of bench_avr. With -t only the sentence types
+ *  of sentences[] are replayed, as sent by a GPS set up by gps_config.c.
+ *  For every rate the report gives the latency from the stop bit of the
+ *  last input byte of a sentence to the stop bit of its first and last
+ *  output byte, the sentences dropped because a newer one of the same type
+ *  came before TX took it (stale), the bytes dropped by the ring buffer,
+ *  the sentences dropped by the GPS and the latest start of an epoch,
+ *  which show where 9600 baud runs out.
+ *
+ *  Build and run:
+ *    make bench
+ *  or
+ *    bench_replay [-r "1 5 10"] [-b input_baudrate] [-f MHz -c cycles_per_byte] [-n repeat] [-t] capture...
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../src/ring_buffer.h"
+#include "../src/scheduler.h"
+#include "../src/sentences.h"
+#include "../src/vx8_core.h"
+
+#ifdef VX8_CUT_THROUGH
+int main(void)
+{
+	printf("bench_replay: not available with VX8_CUT_THROUGH\n");
+	return 0;
+}
+#else
+
+#define OUT_BAUDRATE 9600 /* VX-8 */
+#define BITS_PER_BYTE 10 /* 8N1 */
+#define NS 1000000000ULL
+#define EPOCH_TYPE "RMC"
+#define TALKER_END 3 /* $ and the talker ID, e.g. $GP */
+#define MAX_RATES 8
+#define NEVER UINT64_MAX
+
+/* As in firmware.c: one frame waiting for TX per scheduler slot, one being
+ * sent and one being received.
+ */
+#define FRAME_COUNT (SCHED_TYPES + 2)
+#define NO_FRAME SCHED_NONE
+
+struct samples
+{
+	uint64_t *values;
+	size_t count;
+	size_t size;
+};
+
+struct replay
+{
+	/* Timing, ns */
+	uint64_t in_byte;
+	uint64_t out_byte;
+	uint64_t cost; /* Main loop time per byte. */
+
+	/* Main loop */
+	struct ring_buffer ring;
+	uint64_t arrived[RING_BUFFER_SIZE]; /* Stop bit of the bytes in the ring. */
+	uint64_t cpu; /* Time the main loop is done with the last byte taken. */
+	struct vx8 vx8;
+	struct vx8_frame frames[FRAME_COUNT];
+	uint64_t input_end[FRAME_COUNT];
+	uint8_t rx_frame;
+
+	/* TX */
+	struct scheduler sched;
+	uint8_t tx_frame;
+	uint64_t line_free; /* Stop bit of the last byte taken by TX. */
+	uint64_t tx_next; /* When TX takes the next frame, NEVER when idle. */
+
+	/* Results */
+	struct samples first;
+	struct samples last;
+	unsigned long frames_in;
+	unsigned long sent;
+	unsigned long ring_drops;
+	unsigned tx_high_water;
+	unsigned long gps_drops;
+	uint64_t max_lag;
+};
+
+static uint8_t *input;
+static size_t input_len;
+
+/* Keeps only the lines of the sentence types in sentences[]. */
+static size_t filter_types(uint8_t *buf, size_t len)
+{
+	size_t out = 0;
+	size_t start = 0;
+
+	for (size_t i = 0; i < len; i++)
+	{
+		if (buf[i] != '\n' && i != len - 1)
+		{
+			continue;
+		}
+		if (i - start > 7 && buf[start] == '$' && find_sentence((const char *) &buf[start + 3]) != NO_SENTENCE)
+		{
+			memmove(buf + out, buf + start, i + 1 - start);
+			out += i + 1 - start;
+		}
+		start = i + 1;
+	}
+	return out;
+}
+
+static void samples_add(struct samples *s, uint64_t v)
+{
+	if (s->count == s->size)
+	{
+		s->size = s->size ? s->size * 2 : 1024;
+		s->values = realloc(s->values, s->size * sizeof(s->values[0]));
+	}
+	s->values[s->count++] = v;
+}
+
+static int compare_u64(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *) a;
+	uint64_t y = *(const uint64_t *) b;
+	return (x > y) - (x < y);
+}
+
+/* Percentile of sorted samples in ms. */
+static double percentile(const struct samples *s, unsigned p)
+{
+	return s->count ? s->values[(s->count - 1) * p / 100] / 1e6 : 0.0;
+}
+
+/*
+ * Function: take_frame
+ * --------------------
+ *   TX takes the next frame chosen by the scheduler at time t, like
+ *   tx_next() does. Its bytes follow the byte being sent without a gap.
+ *
+ *   returns:	none
+ */
+static void take_frame(struct replay *r, uint64_t t)
+{
+	uint8_t cur = sched_next(&r->sched);
+	uint64_t start;
+	uint8_t len;
+
+	r->tx_frame = cur;
+	if (cur == NO_FRAME)
+	{
+		r->tx_next = NEVER;
+		return;
+	}
+	len = r->frames[cur].len;
+	start = t > r->line_free ? t : r->line_free;
+	samples_add(&r->first, start + r->out_byte - r->input_end[cur]);
+	samples_add(&r->last, start + len * r->out_byte - r->input_end[cur]);
+	r->sent++;
+	r->line_free = start + len * r->out_byte;
+	/* USART_UDRE_vect finds the frame done when its last byte moves to the
+	 * shift register.
+	 */
+	r->tx_next = start + (len - 1) * r->out_byte;
+}
+
+static void run_tx(struct replay *r, uint64_t t)
+{
+	while (r->tx_next <= t)
+	{
+		take_frame(r, r->tx_next);
+	}
+}
+
+/*
+ * Function: queue_frame
+ * ---------------------
+ *   Hands the complete frame to the scheduler at time t and continues RX
+ *   into a free frame, like queue_frame() of firmware.c.
+ *
+ *   returns:	none
+ */
+static void queue_frame(struct replay *r, uint64_t t)
+{
+	uint8_t depth;
+	uint8_t i = 0;
+
+	run_tx(r, t);
+	r->frames_in++;
+	sched_put(&r->sched, r->frames[r->rx_frame].type, r->rx_frame);
+	if (r->tx_frame == NO_FRAME)
+	{
+		take_frame(r, t);
+	}
+	while (i == r->tx_frame || sched_holds(&r->sched, i))
+	{
+		i++;
+	}
+	r->rx_frame = i;
+	vx8_set_frame(&r->vx8, &r->frames[i]);
+	depth = sched_depth(&r->sched) + (r->tx_frame != NO_FRAME);
+	if (depth > r->tx_high_water)
+	{
+		r->tx_high_water = depth;
+	}
+}
+
+/*
+ * Function: run_main_loop
+ * -----------------------
+ *   Lets the main loop take the bytes it gets to before time t.
+ *
+ *   returns:	none
+ */
+static void run_main_loop(struct replay *r, uint64_t t)
+{
+	uint8_t byte = 0;
+
+	while (r->cpu <= t && ring_count(&r->ring) > 0)
+	{
+		uint64_t arrived = r->arrived[r->ring.tail & RING_BUFFER_MASK];
+		ring_get(&r->ring, &byte);
+		r->cpu += r->cost;
+		if (vx8_feed(&r->vx8, byte) == VX8_FRAME)
+		{
+			r->input_end[r->rx_frame] = arrived;
+			queue_frame(r, r->cpu);
+		}
+	}
+	if (r->cpu < t)
+	{
+		r->cpu = t;
+	}
+}
+
+/* RMC, the first sentence of an epoch of the NEO-6M, from any talker. */
+static int epoch_start(size_t i)
+{
+	return input[i] == '$' && i + TALKER_END + SENTENCE_TYPE_LEN <= input_len
+			&& memcmp(&input[i + TALKER_END], EPOCH_TYPE, SENTENCE_TYPE_LEN) == 0;
+}
+
+static void replay(struct replay *r, unsigned rate, unsigned repeat)
+{
+	uint64_t epoch_time = NS / rate;
+	uint64_t wire = 0; /* Stop bit of the last input byte. */
+	unsigned long epoch = 0;
+	int skip = 0; /* The GPS drops the rest of the epoch. */
+
+	ring_reset(&r->ring);
+	sched_init(&r->sched, OUTPUT_VX8);
+	r->rx_frame = 0;
+	r->tx_frame = NO_FRAME;
+	r->tx_next = NEVER;
+	vx8_init(&r->vx8, &r->frames[0]);
+
+	for (unsigned n = 0; n < repeat; n++)
+	{
+		for (size_t i = 0; i < input_len; i++)
+		{
+			if (input[i] == '$')
+			{
+				/* Epochs start on time, or right after the sentence
+				 * being sent.
+				 */
+				if ((i > 0 || n > 0) && epoch_start(i))
+				{
+					uint64_t start = ++epoch * epoch_time;
+					if (start > wire)
+					{
+						wire = start;
+					}
+					else if (wire - start > r->max_lag)
+					{
+						r->max_lag = wire - start;
+					}
+					skip = 0;
+				}
+				/* A sentence which can't start before the next epoch is
+				 * dropped by the GPS, with the rest of its epoch.
+				 */
+				else if (skip || wire > (epoch + 1) * epoch_time)
+				{
+					skip = 1;
+					r->gps_drops++;
+				}
+			}
+			if (skip)
+			{
+				continue;
+			}
+			wire += r->in_byte;
+			run_main_loop(r, wire);
+			run_tx(r, wire);
+			if (!ring_put(&r->ring, input[i]))
+			{
+				r->ring_drops++;
+				continue;
+			}
+			r->arrived[(uint8_t) (r->ring.head - 1) & RING_BUFFER_MASK] = wire;
+		}
+	}
+	run_main_loop(r, NEVER - 1);
+	run_tx(r, NEVER - 1);
+}
+
+int main(int argc, char *argv[])
+{
+	static uint8_t capture[1 << 20];
+	unsigned rates[MAX_RATES] = { 1, 5, 10 };
+	unsigned rate_count = 3;
+	unsigned long baudrate = 9600;
+	double mhz = 0;
+	double cycles = 0;
+	unsigned repeat = 10;
+	int types = 0;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+		{
+			char *p = argv[++i];
+			char *end;
+			rate_count = 0;
+			while (rate_count < MAX_RATES)
+			{
+				unsigned long rate = strtoul(p, &end, 10);
+				if (end == p)
+				{
+					break;
+				}
+				if (rate > 0)
+				{
+					rates[rate_count++] = (unsigned) rate;
+				}
+				p = end;
+			}
+		}
+		else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc)
+		{
+			baudrate = strtoul(argv[++i], NULL, 10);
+		}
+		else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc)
+		{
+			mhz = atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc)
+		{
+			cycles = atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+		{
+			repeat = (unsigned) atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-t") == 0)
+		{
+			types = 1;
+		}
+		else
+		{
+			FILE *in = fopen(argv[i], "rb");
+			if (in == NULL)
+			{
+				perror(argv[i]);
+				return 1;
+			}
+			input_len += fread(capture + input_len, 1, sizeof(capture) - input_len, in);
+			fclose(in);
+		}
+	}
+	if (input_len == 0 || rate_count == 0 || baudrate == 0 || (cycles > 0 && mhz <= 0))
+	{
+		fprintf(stderr, "usage: bench_replay [-r \"1 5 10\"] [-b input_baudrate] [-f MHz -c cycles_per_byte] "
+				"[-n repeat] [-t] capture...\n");
+		return 1;
+	}
+	input = capture;
+	if (types)
+	{
+		input_len = filter_types(capture, input_len);
+	}
+
+	printf("%4s %7s %7s %7s %7s %7s %8s %8s %8s %8s %8s %5s %8s %7s\n", "Hz", "frames", "sent", "stale", "ring",
+			"first50", "first99", "last50", "last90", "last99", "last max", "queue", "GPS drop", "GPS lag");
+	for (unsigned k = 0; k < rate_count; k++)
+	{
+		static struct replay r;
+
+		free(r.first.values);
+		free(r.last.values);
+		memset(&r, 0, sizeof(r));
+		r.in_byte = NS * BITS_PER_BYTE / baudrate;
+		r.out_byte = NS * BITS_PER_BYTE / OUT_BAUDRATE;
+		r.cost = mhz > 0 ? (uint64_t) (cycles * 1000.0 / mhz) : 0;
+		replay(&r, rates[k], repeat);
+		qsort(r.first.values, r.first.count, sizeof(r.first.values[0]), compare_u64);
+		qsort(r.last.values, r.last.count, sizeof(r.last.values[0]), compare_u64);
+		printf("%4u %7lu %7lu %7u %7lu %7.1f %8.1f %8.1f %8.1f %8.1f %8.1f %5u %8lu %5.0fms\n", rates[k],
+				r.frames_in, r.sent, r.sched.stale, r.ring_drops, percentile(&r.first, 50), percentile(&r.first, 99),
+				percentile(&r.last, 50), percentile(&r.last, 90), percentile(&r.last, 99), percentile(&r.last, 100),
+				r.tx_high_water, r.gps_drops, r.max_lag / 1e6);
+	}
+	printf("(latency in ms from the end of the input sentence, %lu baud in, %u baud out, %s, %s x %u)\n",
+			baudrate, OUT_BAUDRATE, mhz > 0 ? "main loop timed" : "instant main loop",
+			types ? "GGA, RMC and ZDA of the captures" : "captures", repeat);
+	return 0;
+}
+
+#endif /* VX8_CUT_THROUGH */
@@ -0,0 +1,769 @@
+/*
+ * bench_str_func.c
+ *
+ *  Created on: 16 Oct 2026
+ *  Author: Dmitry Melnichansky / 4Z7DTF
+ *
+ *  Microbenchmark and equivalence suite of the field formatting routines
+ *  in str_func.c. Builds for the host and for the ATmega328P.
+ *
+ *  Equivalence: every field layout of sentences[] (the GGA, RMC and ZDA
+ *  decimal and integer widths) is run with every input shape up to
+ *  SHAPE_MAX characters in the integer and the fraction part, with and
+ *  without a decimal point, the empty field included. This covers the
+ *  NEO-6M output, empty fields without a fix and truncated and over-long
+ *  fields. fix_decimal_field_len, fix_int_field_len, format_decimal_field
+ *  and format_int_field are compared with a reference model, bytes after
+ *  the field included, and the XOR returned by the format_* routines with
+ *  the XOR of the reference. add_zeros_left, rm_chars_left,
+ *  add_zeros_right and rm_chars_right are checked on their own for every
+ *  pair of lengths up to KERNEL_LEN_MAX. An optimized version of any of
+ *  them has to pass the same checks. Known limits of the current code:
+ *    - the index of add_zeros_left, rm_chars_left and add_zeros_right is
+ *      int8_t. add_zeros_left does nothing with new_len over 127, and the
+ *      loops of rm_chars_left (new_len 127 and more) and add_zeros_right
+ *      (new_len 128 and more) never end. Lengths are limited by
+ *      VX8_BUFFER_SIZE, which is checked against KERNEL_LEN_MAX below.
+ *    - add_zeros_left and rm_chars_left move new_len + 1 characters: the
+ *      null terminator of the source string is moved with the field, so
+ *      the source must be null terminated at src_len. add_zeros_left
+ *      requires new_len >= src_len and rm_chars_left new_len <= src_len.
+ *    - fix_decimal_field_len moves the integer part first. With a longer
+ *      integer part and a shorter fraction part it writes past the end of
+ *      the new field; the largest overrun is reported.
+ *    - fix_decimal_field_len doesn't add the decimal point to a non-empty
+ *      field without one, format_decimal_field does. The vx8_core.c
+ *      transform uses format_decimal_field.
+ *
+ *  Timing: the field shapes produced by NEO-6M for every layout, with
+ *  empty, truncated and over-long fields. The shifting helpers
+ *  (fix_decimal_field_len, fix_int_field_len) are compared with the single
+ *  pass formatters (format_decimal_field, format_int_field), and the
+ *  kernels called by fix_decimal_field_len are timed one by one with the
+ *  arguments it passes to them. The copy of the input is excluded. The
+ *  host reports nanoseconds per field, measured with clock_gettime(). The
+ *  ATmega328P reports cycles per field counted by Timer1 at F_CPU and
+ *  prints the results to USART0 at 9600 baud.
+ *
+ *  The format_* routines are slower where the field already has the new
+ *  shape ("time 6.3 mtk", "sats 2 full", "dgps id 4 set"): the shifting
+ *  helpers return without writing, and format_* still reads every
+ *  character for the XOR. The shifting helpers leave the checksum to the
+ *  caller. vx8_core.c doesn't call format_* for these fields, the XOR
+ *  taken while the field was received is already the checksum.
+ *
+ *  Build and run:
+ *    make bench
+ *    make bench-str-func-avr    (runs the ATmega328P build in simavr)
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "../src/str_func.h"
+#include "../src/sentences.h"
+#include "../src/vx8_core.h"
+
+#ifdef __AVR__
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#define BAUD 9600
+#include <util/setbaud.h>
+typedef uint16_t bench_t;
+typedef uint32_t bench_sum_t;
+#define BENCH_FMT "%10u"
+#define TICK_UNIT "cycles"
+#else
+#include <time.h>
+typedef double bench_t;
+typedef double bench_sum_t;
+#define BENCH_FMT "%10.1f"
+#define TICK_UNIT "ns"
+#define ITERATIONS 200000
+#endif
+
+#define FIELD_BUF 32
+/* Longest integer and fraction part of the equivalence inputs. */
+#define SHAPE_MAX 16
+/* Longest string passed to the kernels by the equivalence checks. */
+#define KERNEL_LEN_MAX 126
+/* Input, output and reference of the equivalence checks, with room for
+ * the writes after the field.
+ */
+#define CHECK_BUF (KERNEL_LEN_MAX + 10)
+#define CANARY ((char) 0xA5)
+#define LAYOUT_MAX 16
+
+#if VX8_BUFFER_SIZE > KERNEL_LEN_MAX
+#error "Fields longer than KERNEL_LEN_MAX overflow the int8_t index of str_func.c"
+#endif
+
+struct field_case
+{
+	const char *name;
+	const char *input;
+	uint8_t int_len; /* 0 for integer fields */
+	uint8_t frac_len;
+	uint8_t len; /* Integer fields: required length */
+};
+
+static const struct field_case cases[] = {
+	{ "time 6.3", "094053.00", 6, 3, 0 },
+	{ "time 6.3 mtk", "125004.000", 6, 3, 0 },
+	{ "time 6.3 short", "94053.0", 6, 3, 0 },
+	{ "time 6.3 long", "1094053.0000", 6, 3, 0 },
+	{ "lat 4.4", "3204.41475", 4, 4, 0 },
+	{ "lat 4.4 empty", "", 4, 4, 0 },
+	{ "lat 4.4 short", "3204.4", 4, 4, 0 },
+	{ "lat 4.4 long", "13204.414750", 4, 4, 0 },
+	{ "lon 5.4", "03445.96499", 5, 4, 0 },
+	{ "lon 5.4 empty", "", 5, 4, 0 },
+	{ "lon 5.4 short", "3445.9", 5, 4, 0 },
+	{ "hdop 2.1", "1.12", 2, 1, 0 },
+	{ "hdop 2.1 no fix", "99.9", 2, 1, 0 },
+	{ "hdop 2.1 long", "100.00", 2, 1, 0 },
+	{ "alt 5.1", "28.7", 5, 1, 0 },
+	{ "alt 5.1 empty", "", 5, 1, 0 },
+	{ "geoid 4.1", "17.5", 4, 1, 0 },
+	{ "geoid 4.1 empty", "", 4, 1, 0 },
+	{ "dgps age 3.1", "", 3, 1, 0 },
+	{ "dgps age 3.1 set", "1.2", 3, 1, 0 },
+	{ "speed 4.2", "3.876", 4, 2, 0 },
+	{ "speed 4.2 stop", "0.012", 4, 2, 0 },
+	{ "speed 4.2 empty", "", 4, 2, 0 },
+	{ "course 3.2", "110.45", 3, 2, 0 },
+	{ "course 3.2 empty", "", 3, 2, 0 },
+	{ "course 3.2 short", "5.7", 3, 2, 0 },
+	{ "sats 2", "9", 0, 0, 2 },
+	{ "sats 2 full", "09", 0, 0, 2 },
+	{ "sats 2 empty", "", 0, 0, 2 },
+	{ "sats 2 long", "123", 0, 0, 2 },
+	{ "dgps id 4", "", 0, 0, 4 },
+	{ "dgps id 4 set", "0012", 0, 0, 4 },
+	{ "dgps id 4 long", "12345", 0, 0, 4 },
+};
+
+#define CASE_COUNT (sizeof(cases) / sizeof(cases[0]))
+
+/* Routines and kernels called by run_call(). */
+enum kernels
+{
+	K_NONE,
+	K_INT_LEN,
+	K_ADD_ZEROS_LEFT,
+	K_RM_CHARS_LEFT,
+	K_ADD_ZEROS_RIGHT,
+	K_RM_CHARS_RIGHT,
+	K_FIX_INT,
+	K_FIX_DECIMAL,
+	K_FORMAT_INT,
+	K_FORMAT_DECIMAL,
+	K_COUNT
+};
+
+static const char *const kernel_names[K_COUNT] = {
+	"none", "int_len", "add_zeros_left", "rm_chars_left", "add_zeros_right", "rm_chars_right",
+	"fix_int_field_len", "fix_decimal_field_len", "format_int_field", "format_decimal_field",
+};
+
+/* One call of a routine with its arguments and the field it gets. */
+struct call
+{
+	uint8_t kernel;
+	uint8_t src_len;
+	uint8_t new_len; /* Kernels and integer fields */
+	uint8_t int_len; /* Decimal fields */
+	uint8_t frac_len;
+	uint8_t dot;
+	char field[FIELD_BUF];
+};
+
+/* Field layout of sentences[]. int_len is the length of integer fields. */
+struct layout
+{
+	uint8_t kind;
+	uint8_t int_len;
+	uint8_t frac_len;
+};
+
+static volatile uint8_t sink;
+static bench_sum_t kernel_sum[K_COUNT];
+static uint8_t kernel_calls[K_COUNT];
+
+#ifdef __AVR__
+static int uart_putchar(char c, FILE *stream)
+{
+	if (c == '\n')
+	{
+		uart_putchar('\r', stream);
+	}
+	loop_until_bit_is_set(UCSR0A, UDRE0);
+	UDR0 = c;
+	return 0;
+}
+
+static FILE uart_out = FDEV_SETUP_STREAM(uart_putchar, NULL, _FDEV_SETUP_WRITE);
+
+static void avr_init(void)
+{
+	UBRR0H = UBRRH_VALUE;
+	UBRR0L = UBRRL_VALUE;
+#if USE_2X
+	UCSR0A |= (1 << U2X0);
+#else
+	UCSR0A &= ~(1 << U2X0);
+#endif
+	UCSR0C = (1 << UCSZ01) | (1 << UCSZ00);
+	UCSR0B = (1 << TXEN0);
+	stdout = &uart_out;
+	/* Timer1 counts CPU cycles. */
+	TIMSK1 = 0;
+	TCCR1A = 0;
+	TCCR1C = 0;
+	TCCR1B = (1 << CS10);
+}
+#else
+static unsigned long long ns_now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long long) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+#endif
+
+static uint8_t dot_of(const char *s)
+{
+	const char *d = strchr(s, '.');
+	return d ? (uint8_t) (d - s) : VX8_NO_DOT;
+}
+
+static uint8_t is_decimal(const struct field_case *c)
+{
+	return c->int_len || c->frac_len;
+}
+
+static void __attribute__((noinline)) run_call(const struct call *k, char field[])
+{
+	switch (k->kernel)
+	{
+	case K_INT_LEN:
+		sink ^= int_len(field);
+		break;
+	case K_ADD_ZEROS_LEFT:
+		add_zeros_left(field, k->src_len, k->new_len);
+		break;
+	case K_RM_CHARS_LEFT:
+		rm_chars_left(field, k->src_len, k->new_len);
+		break;
+	case K_ADD_ZEROS_RIGHT:
+		add_zeros_right(field, k->src_len, k->new_len);
+		break;
+	case K_RM_CHARS_RIGHT:
+		rm_chars_right(field, k->src_len, k->new_len);
+		break;
+	case K_FIX_INT:
+		fix_int_field_len(field, k->src_len, k->new_len);
+		break;
+	case K_FIX_DECIMAL:
+		fix_decimal_field_len(field, k->src_len, k->int_len, k->frac_len);
+		break;
+	case K_FORMAT_INT:
+		sink ^= format_int_field(field, k->src_len, k->new_len);
+		break;
+	case K_FORMAT_DECIMAL:
+		sink ^= format_decimal_field(field, k->src_len, k->dot, k->int_len, k->frac_len);
+		break;
+	}
+	sink ^= field[0];
+}
+
+/* Time of one call including the copy of its field, in TICK_UNIT. */
+static bench_t time_call(const struct call *k)
+{
+	char field[FIELD_BUF];
+#ifdef __AVR__
+	memcpy(field, k->field, sizeof(field));
+	uint16_t start = TCNT1;
+	run_call(k, field);
+	return TCNT1 - start;
+#else
+	unsigned long long start = ns_now();
+	for (long i = 0; i < ITERATIONS; i++)
+	{
+		memcpy(field, k->field, sizeof(field));
+		run_call(k, field);
+	}
+	return (double) (ns_now() - start) / ITERATIONS;
+#endif
+}
+
+/* Time of the routine alone, the copy and the call excluded. */
+static bench_t time_routine(const struct call *k, bench_t base)
+{
+	bench_t t = time_call(k);
+	return t > base ? t - base : 0;
+}
+
+static void print_speedup(bench_sum_t a, bench_sum_t b)
+{
+#ifdef __AVR__
+	uint32_t x = b ? a * 100 / b : 0;
+	printf(" %4lu.%02lux\n", (unsigned long) (x / 100), (unsigned long) (x % 100));
+#else
+	printf(" %7.2fx\n", b > 0 ? a / b : 0.0);
+#endif
+}
+
+/*
+ * Reference model of the new fields.
+ * Integer field: the last new_len characters of the input, with leading
+ * zeros if it is shorter.
+ * Decimal field: the integer part (before the first decimal point) is
+ * formatted like an integer field of new_int_len, the fraction part is
+ * cut or padded with zeros at the end to new_frac_len. With legacy, a
+ * non-empty field without a decimal point gets none, as
+ * fix_decimal_field_len does.
+ * Returns the length of the new field, out is null terminated.
+ */
+static uint8_t ref_int(char out[], const char in[], uint8_t len, uint8_t new_len)
+{
+	for (uint8_t i = 0; i < new_len; i++)
+	{
+		int16_t j = (int16_t) len - new_len + i;
+		out[i] = j >= 0 ? in[j] : '0';
+	}
+	out[new_len] = '\0';
+	return new_len;
+}
+
+static uint8_t ref_decimal(char out[], const char in[], uint8_t len, uint8_t new_int_len, uint8_t new_frac_len,
+		uint8_t legacy)
+{
+	uint8_t dot = dot_of(in);
+	uint8_t i_len = dot == VX8_NO_DOT ? len : dot;
+	uint8_t f_len = dot == VX8_NO_DOT ? 0 : len - dot - 1;
+	uint8_t n = ref_int(out, in, i_len, new_int_len);
+
+	if (!legacy || dot != VX8_NO_DOT || len == 0)
+	{
+		out[n++] = '.';
+	}
+	for (uint8_t i = 0; i < new_frac_len; i++)
+	{
+		out[n++] = i < f_len ? in[dot + 1 + i] : '0';
+	}
+	out[n] = '\0';
+	return n;
+}
+
+static uint8_t xor_of(const char s[], uint8_t len)
+{
+	uint8_t res = 0;
+	for (uint8_t i = 0; i < len; i++)
+	{
+		res ^= s[i];
+	}
+	return res;
+}
+
+/* Field layouts of sentences[] which change the field. */
+static uint8_t get_layouts(struct layout layouts[])
+{
+	uint8_t n = 0;
+	for (uint8_t s = 0; s < SENTENCE_COUNT; s++)
+	{
+		struct field_spec spec;
+		for (uint8_t f = 1; get_field_spec(s, f, &spec); f++)
+		{
+			uint8_t kind = spec.kind & FIELD_KIND_MASK;
+			uint8_t i;
+			if (kind != FIELD_DECIMAL && kind != FIELD_INT)
+			{
+				continue;
+			}
+			for (i = 0; i < n; i++)
+			{
+				if (layouts[i].kind == kind && layouts[i].int_len == spec.int_len
+						&& layouts[i].frac_len == spec.frac_len)
+				{
+					break;
+				}
+			}
+			if (i == n && n < LAYOUT_MAX)
+			{
+				layouts[n].kind = kind;
+				layouts[n].int_len = spec.int_len;
+				layouts[n].frac_len = spec.frac_len;
+				n++;
+			}
+		}
+	}
+	return n;
+}
+
+static char check_in[CHECK_BUF];
+static char check_out[CHECK_BUF];
+static char check_ref[CHECK_BUF];
+static unsigned long shape_checks;
+static uint8_t fix_overrun; /* Largest write of the fix routines after both the input and the new field. */
+static unsigned long fix_no_dot; /* Fields fix_decimal_field_len leaves without a decimal point. */
+
+static void make_shape(uint8_t i_len, uint8_t has_dot, uint8_t f_len)
+{
+	uint8_t n = 0;
+	memset(check_in, CANARY, sizeof(check_in));
+	for (uint8_t i = 0; i < i_len; i++)
+	{
+		check_in[n++] = '1' + i % 9;
+	}
+	if (has_dot)
+	{
+		check_in[n++] = '.';
+	}
+	for (uint8_t i = 0; i < f_len; i++)
+	{
+		check_in[n++] = '9' - i % 9;
+	}
+	check_in[n] = '\0';
+}
+
+static void print_shape(const char *routine, const struct layout *l, uint8_t len)
+{
+	printf("MISMATCH %s %u.%u: \"%s\" -> \"%.*s\", expected \"%s\"\n", routine, l->int_len, l->frac_len,
+			check_in, len, check_out, check_ref);
+}
+
+/* Checks one input shape against the reference with all the routines of the layout. */
+static uint8_t check_shape(const struct layout *l)
+{
+	uint8_t len = strlen(check_in);
+	uint8_t dot = dot_of(check_in);
+	uint8_t new_len;
+	uint8_t end;
+	uint8_t ok = 1;
+
+	shape_checks++;
+	if (int_len(check_in) != (dot == VX8_NO_DOT ? len : dot))
+	{
+		printf("MISMATCH int_len: \"%s\"\n", check_in);
+		return 0;
+	}
+
+	memcpy(check_out, check_in, sizeof(check_out));
+	if (l->kind == FIELD_DECIMAL)
+	{
+		new_len = ref_decimal(check_ref, check_in, len, l->int_len, l->frac_len, 0);
+		ok &= format_decimal_field(check_out, len, dot, l->int_len, l->frac_len) == xor_of(check_ref, new_len);
+	}
+	else
+	{
+		new_len = ref_int(check_ref, check_in, len, l->int_len);
+		ok &= format_int_field(check_out, len, l->int_len) == xor_of(check_ref, new_len);
+	}
+	/* The format routines write the new field and nothing else. */
+	ok &= memcmp(check_out, check_ref, new_len) == 0;
+	ok &= memcmp(&check_out[new_len], &check_in[new_len], sizeof(check_out) - new_len) == 0;
+	if (!ok)
+	{
+		print_shape(l->kind == FIELD_DECIMAL ? "format_decimal_field" : "format_int_field", l, new_len);
+		return 0;
+	}
+
+	memcpy(check_out, check_in, sizeof(check_out));
+	if (l->kind == FIELD_DECIMAL)
+	{
+		new_len = ref_decimal(check_ref, check_in, len, l->int_len, l->frac_len, 1);
+		fix_decimal_field_len(check_out, len, l->int_len, l->frac_len);
+		if (new_len != l->int_len + 1 + l->frac_len)
+		{
+			fix_no_dot++;
+		}
+	}
+	else
+	{
+		new_len = ref_int(check_ref, check_in, len, l->int_len);
+		fix_int_field_len(check_out, len, l->int_len);
+	}
+	/* The fix routines null terminate the new field. Moved characters may
+	 * be left after it, and after the end of the input, but no further
+	 * than len + new_len.
+	 */
+	ok &= memcmp(check_out, check_ref, new_len + 1) == 0;
+	end = len > new_len ? len : new_len;
+	for (uint8_t i = end + 1; i < sizeof(check_out); i++)
+	{
+		if (check_out[i] != check_in[i])
+		{
+			ok &= i <= len + new_len;
+			if (i - end > fix_overrun)
+			{
+				fix_overrun = i - end;
+			}
+		}
+	}
+	if (!ok)
+	{
+		print_shape(l->kind == FIELD_DECIMAL ? "fix_decimal_field_len" : "fix_int_field_len", l, new_len + 1);
+		return 0;
+	}
+	return 1;
+}
+
+/* Every input shape for every layout. */
+static uint8_t check_layouts(const struct layout layouts[], uint8_t n)
+{
+	for (uint8_t l = 0; l < n; l++)
+	{
+		for (uint8_t i = 0; i <= SHAPE_MAX; i++)
+		{
+			for (uint8_t d = 0; d <= 1; d++)
+			{
+				for (uint8_t f = 0; f <= (d ? SHAPE_MAX : 0); f++)
+				{
+					make_shape(i, d, f);
+					if (!check_shape(&layouts[l]))
+					{
+						return 0;
+					}
+				}
+			}
+		}
+	}
+	return 1;
+}
+
+static unsigned long kernel_checks;
+
+static uint8_t check_kernel(uint8_t kernel, uint8_t src_len, uint8_t new_len)
+{
+	struct call k = { 0 };
+	memset(check_in, CANARY, sizeof(check_in));
+	for (uint8_t i = 0; i < src_len; i++)
+	{
+		check_in[i] = 'A' + i % 26;
+	}
+	check_in[src_len] = '\0';
+	memcpy(check_ref, check_in, sizeof(check_ref));
+	switch (kernel)
+	{
+	case K_ADD_ZEROS_LEFT:
+		memset(check_ref, '0', new_len - src_len);
+		memcpy(&check_ref[new_len - src_len], check_in, src_len + 1);
+		break;
+	case K_RM_CHARS_LEFT:
+		memcpy(check_ref, &check_in[src_len - new_len], new_len + 1);
+		break;
+	case K_ADD_ZEROS_RIGHT:
+		memset(&check_ref[src_len], '0', new_len - src_len);
+		check_ref[new_len] = '\0';
+		break;
+	case K_RM_CHARS_RIGHT:
+		check_ref[new_len] = '\0';
+		break;
+	}
+	memcpy(check_out, check_in, sizeof(check_out));
+	k.kernel = kernel;
+	k.src_len = src_len;
+	k.new_len = new_len;
+	run_call(&k, check_out);
+	kernel_checks++;
+	if (memcmp(check_out, check_ref, sizeof(check_out)) != 0)
+	{
+		printf("MISMATCH %s(%u, %u)\n", kernel_names[kernel], src_len, new_len);
+		return 0;
+	}
+	return 1;
+}
+
+/* Every pair of lengths the kernels accept, up to KERNEL_LEN_MAX. */
+static uint8_t check_kernels(void)
+{
+	for (uint8_t s = 0; s <= KERNEL_LEN_MAX; s++)
+	{
+		for (uint8_t n = 0; n <= KERNEL_LEN_MAX; n++)
+		{
+			uint8_t ok = 1;
+			if (n >= s)
+			{
+				ok &= check_kernel(K_ADD_ZEROS_LEFT, s, n);
+				ok &= check_kernel(K_ADD_ZEROS_RIGHT, s, n);
+			}
+			if (n <= s)
+			{
+				ok &= check_kernel(K_RM_CHARS_LEFT, s, n);
+				ok &= check_kernel(K_RM_CHARS_RIGHT, s, n);
+			}
+			if (!ok)
+			{
+				return 0;
+			}
+		}
+	}
+	return 1;
+}
+
+static uint8_t case_has_layout(const struct field_case *c, const struct layout *l)
+{
+	if (l->kind == FIELD_DECIMAL)
+	{
+		return c->int_len == l->int_len && c->frac_len == l->frac_len;
+	}
+	return !is_decimal(c) && c->len == l->int_len;
+}
+
+/* Every layout has to be timed. */
+static uint8_t check_cases(const struct layout layouts[], uint8_t n)
+{
+	uint8_t ok = 1;
+	for (uint8_t l = 0; l < n; l++)
+	{
+		uint8_t i = 0;
+		while (i < CASE_COUNT && !case_has_layout(&cases[i], &layouts[l]))
+		{
+			i++;
+		}
+		if (i == CASE_COUNT)
+		{
+			printf("No timing case for layout %u.%u\n", layouts[l].int_len, layouts[l].frac_len);
+			ok = 0;
+		}
+	}
+	return ok;
+}
+
+static void add_kernel_time(struct call *k, bench_t base)
+{
+	kernel_sum[k->kernel] += time_routine(k, base);
+	kernel_calls[k->kernel]++;
+}
+
+/* Times the kernels in the order fix_decimal_field_len and
+ * fix_int_field_len call them, each with the field as the previous
+ * kernel left it.
+ */
+static void time_kernels(const struct field_case *c, bench_t base)
+{
+	struct call k = { 0 };
+	uint8_t len = strlen(c->input);
+	uint8_t i_len = len;
+	uint8_t f_len = 0;
+	uint8_t new_int_len = is_decimal(c) ? c->int_len : c->len;
+
+	strcpy(k.field, c->input);
+	if (is_decimal(c))
+	{
+		if (len > 0)
+		{
+			k.kernel = K_INT_LEN;
+			add_kernel_time(&k, base);
+			i_len = int_len(k.field);
+			if (i_len < len)
+			{
+				f_len = len - i_len - 1;
+			}
+		}
+		else
+		{
+			strcpy(k.field, ".");
+			len = 1;
+		}
+	}
+	if (i_len != new_int_len)
+	{
+		k.kernel = new_int_len > i_len ? K_ADD_ZEROS_LEFT : K_RM_CHARS_LEFT;
+		k.src_len = len;
+		k.new_len = len - i_len + new_int_len;
+		add_kernel_time(&k, base);
+		run_call(&k, k.field);
+		len = k.new_len;
+	}
+	if (is_decimal(c) && f_len != c->frac_len)
+	{
+		k.kernel = c->frac_len > f_len ? K_ADD_ZEROS_RIGHT : K_RM_CHARS_RIGHT;
+		k.src_len = len;
+		k.new_len = len - f_len + c->frac_len;
+		add_kernel_time(&k, base);
+	}
+}
+
+/* simavr stops at sleep with interrupts disabled. */
+static int done(int res)
+{
+#ifdef __AVR__
+	loop_until_bit_is_set(UCSR0A, UDRE0);
+	cli();
+	sleep_mode();
+#endif
+	return res;
+}
+
+int main(void)
+{
+	struct layout layouts[LAYOUT_MAX];
+	struct call none = { 0 };
+	bench_sum_t old_sum = 0, new_sum = 0;
+	bench_t base;
+	uint8_t n;
+
+#ifdef __AVR__
+	avr_init();
+#endif
+	n = get_layouts(layouts);
+	printf("layouts:");
+	for (uint8_t l = 0; l < n; l++)
+	{
+		if (layouts[l].kind == FIELD_DECIMAL)
+		{
+			printf(" %u.%u", layouts[l].int_len, layouts[l].frac_len);
+		}
+		else
+		{
+			printf(" %u", layouts[l].int_len);
+		}
+	}
+	printf("\n");
+	if (!check_cases(layouts, n) || !check_layouts(layouts, n) || !check_kernels())
+	{
+		return done(1);
+	}
+	printf("equivalence: %lu fields, %lu kernel calls equal to the reference\n", shape_checks, kernel_checks);
+	printf("fix_decimal_field_len: %u bytes written after the input and the new field at most, %lu fields left without "
+			"a decimal point\n\n", fix_overrun, fix_no_dot);
+
+	base = time_call(&none);
+	printf("%-18s %-12s %10s %10s %8s\n", "field", "input", "fix", "format", "speedup");
+	for (uint8_t i = 0; i < CASE_COUNT; i++)
+	{
+		const struct field_case *c = &cases[i];
+		struct call k = { 0 };
+		bench_t old_t, new_t;
+
+		k.src_len = strlen(c->input);
+		k.new_len = c->len;
+		k.int_len = c->int_len;
+		k.frac_len = c->frac_len;
+		k.dot = dot_of(c->input);
+		strcpy(k.field, c->input);
+		k.kernel = is_decimal(c) ? K_FIX_DECIMAL : K_FIX_INT;
+		old_t = time_routine(&k, base);
+		k.kernel = is_decimal(c) ? K_FORMAT_DECIMAL : K_FORMAT_INT;
+		new_t = time_routine(&k, base);
+		old_sum += old_t;
+		new_sum += new_t;
+		printf("%-18s %-12s " BENCH_FMT " " BENCH_FMT, c->name, c->input, old_t, new_t);
+		print_speedup(old_t, new_t);
+		time_kernels(c, base);
+	}
+	printf("%-18s %-12s " BENCH_FMT " " BENCH_FMT, "average", "", (bench_t) (old_sum / CASE_COUNT),
+			(bench_t) (new_sum / CASE_COUNT));
+	print_speedup(old_sum, new_sum);
+
+	printf("\n%-18s %6s %10s\n", "kernel", "calls", "per call");
+	for (uint8_t i = K_INT_LEN; i <= K_RM_CHARS_RIGHT; i++)
+	{
+		printf("%-18s %6u " BENCH_FMT "\n", kernel_names[i], kernel_calls[i],
+				kernel_calls[i] ? (bench_t) (kernel_sum[i] / kernel_calls[i]) : (bench_t) 0);
+	}
+	printf("(%s per field, copy of the input excluded)\n", TICK_UNIT);
+	return done(0);
+}
@@ -0,0 +1,249 @@
+/*
+ * bench_track_log.c
+ *
+ *  Created on: 16 Oct 2026
+ *  Author: Dmitry Melnichansky / 4Z7DTF
+ *
+ *  Host benchmark of the track log encoding. The captures given on the
+ *  command line are converted like the firmware built with VX8_TRACK_LOG
+ *  does, and a synthetic day of 1Hz fixes (stops, walking and driving
+ *  with turns) is logged directly. For each the log is written to a store
+ *  in memory, decoded back and compared with the logged points.
+ *
+ *  Reported per track:
+ *    bytes/fix   record bytes per logged fix
+ *    nmea/fix    bytes of the raw NMEA input per fix, for the synthetic
+ *                track GGA and RMC rendered as the NEO-6M sends them
+ *    ratio       raw NMEA bytes / log bytes written to the store
+ *    write amp   bytes written to the store / record bytes, the padding
+ *                at the end of the pages
+ *    days        days of 1Hz fixes a 16MB flash holds at this rate
+ *
+ *  Build and run:
+ *    make bench
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../src/vx8_core.h"
+#include "../src/gps_fix.h"
+#include "../src/render.h"
+#include "../src/sentences.h"
+#include "../src/track_log.h"
+
+#define STORE_PAGES 4096 /* 1MB */
+#define FLASH_BYTES (16UL * 1024 * 1024)
+#define DAY_S 86400UL
+#define MAX_POINTS (DAY_S + 1)
+#define M_PER_DEG 111320.0
+
+static uint8_t store_data[STORE_PAGES][TRACK_PAGE_SIZE];
+static struct track_point logged[MAX_POINTS]; /* Points expected from the decoder. */
+static unsigned long logged_count;
+
+static uint8_t mem_read(uint32_t page, uint16_t offset, uint8_t *data, uint16_t len)
+{
+	memcpy(data, &store_data[page][offset], len);
+	return 1;
+}
+
+static uint8_t mem_write(uint32_t page, const uint8_t *data)
+{
+	memcpy(store_data[page], data, TRACK_PAGE_SIZE);
+	return 1;
+}
+
+static const struct track_store mem_store = { STORE_PAGES, mem_read, mem_write };
+
+static void start(struct track_log *log)
+{
+	memset(store_data, TRACK_END, sizeof(store_data));
+	logged_count = 0;
+	track_log_init(log, &mem_store);
+}
+
+static void add(struct track_log *log, const struct gps_fix *fix)
+{
+	struct track_point point;
+
+	if (track_log_add(log, fix) == TRACK_LOG_ADDED && track_point_from_fix(&point, fix))
+	{
+		logged[logged_count++] = point;
+	}
+}
+
+/* Decodes the store, every point must be the logged one. */
+static int verify(const struct track_log *log)
+{
+	struct track_reader r;
+	unsigned long n = 0;
+
+	for (uint32_t page = 0; page < log->page; page++)
+	{
+		track_reader_init(&r, store_data[page], TRACK_PAGE_SIZE);
+		while (track_reader_next(&r))
+		{
+			if (n >= logged_count || memcmp(&r.point, &logged[n], sizeof(r.point)) != 0)
+			{
+				printf("MISMATCH at point %lu, page %u\n", n, (unsigned) page);
+				return 0;
+			}
+			n++;
+		}
+	}
+	if (n != logged_count)
+	{
+		printf("MISMATCH: %lu points decoded, %lu logged\n", n, logged_count);
+		return 0;
+	}
+	return 1;
+}
+
+static int report(const char *name, struct track_log *log, unsigned long nmea_bytes)
+{
+	unsigned long written;
+
+	track_log_flush(log);
+	if (!verify(log))
+	{
+		return 0;
+	}
+	written = log->pages_written * TRACK_PAGE_SIZE;
+	if (log->records == 0)
+	{
+		printf("%-28s %7lu %9s %9s %8s %9s %8s\n", name, 0UL, "-", "-", "-", "-", "-");
+		return 1;
+	}
+	printf("%-28s %7lu %9.2f %9.1f %7.1fx %9.3f %8.0f\n", name, (unsigned long) log->records,
+			(double) log->record_bytes / log->records, (double) nmea_bytes / log->records,
+			(double) nmea_bytes / written, (double) written / log->record_bytes,
+			FLASH_BYTES / ((double) written / log->records) / DAY_S);
+	return 1;
+}
+
+static int bench_capture(const char *path)
+{
+	static struct track_log log;
+	struct vx8 ctx;
+	struct vx8_frame frame;
+	struct gps_fix fix;
+	unsigned long bytes = 0;
+	FILE *in = fopen(path, "rb");
+	const char *name = strrchr(path, '/');
+	int c;
+
+	if (in == NULL)
+	{
+		perror(path);
+		return 0;
+	}
+	start(&log);
+	memset(&fix, 0, sizeof(fix));
+	vx8_init(&ctx, &frame);
+	vx8_set_fix(&ctx, &fix);
+	while ((c = getc(in)) != EOF)
+	{
+		bytes++;
+		if (vx8_feed(&ctx, (uint8_t) c) == VX8_FRAME && ctx.fix_updated && frame.type == SENTENCE_GGA)
+		{
+			add(&log, &fix);
+		}
+	}
+	fclose(in);
+	return report(name ? name + 1 : path, &log, bytes);
+}
+
+static unsigned long rnd_state = 1;
+
+/* Uniform in [-1, 1). */
+static double rnd(void)
+{
+	rnd_state = rnd_state * 1103515245UL + 12345UL;
+	return ((rnd_state >> 16) & 0x7FFF) / 16384.0 - 1.0;
+}
+
+/*
+ * Function: bench_day
+ * -------------------
+ *   Logs a synthetic day: segments of 5 to 60 minutes of standing still,
+ *   walking at 1.4 m/s or driving at 10 to 30 m/s, with a slowly turning
+ *   heading and a little noise on position and altitude.
+ */
+static int bench_day(void)
+{
+	static struct track_log log;
+	struct gps_fix fix;
+	struct vx8_frame frame;
+	unsigned long nmea = 0;
+	double lat = 32.434305;
+	double lon = 34.915267;
+	double alt = 82.1;
+	double heading = 45.0;
+	double turn = 0;
+	double speed = 0;
+	double target = 0;
+	unsigned long segment_end = 0;
+
+	start(&log);
+	memset(&fix, 0, sizeof(fix));
+	fix.year = 2026;
+	fix.month = 10;
+	fix.day = 16;
+	fix.time_valid = GPS_TIME_VALID_UTC;
+	fix.fix_type = GPS_FIX_3D;
+	fix.fix_flags = GPS_FIX_OK;
+	fix.num_sv = 8;
+	fix.hdop = 150;
+	for (unsigned long t = 0; t < DAY_S; t++)
+	{
+		if (t == segment_end)
+		{
+			int mode = (int) ((rnd() + 1.0) * 1.5);
+			target = mode == 0 ? 0 : mode == 1 ? 1.4 : 20.0 + 10.0 * rnd();
+			segment_end = t + 1950 + (unsigned long) (1650 * rnd());
+		}
+		speed += (target - speed) * 0.1;
+		turn = turn * 0.95 + rnd() * (speed > 5 ? 0.5 : 2.0);
+		heading = fmod(heading + (speed > 0.5 ? turn : 0) + 360.0, 360.0);
+		lat += speed * cos(heading * M_PI / 180) / M_PER_DEG;
+		lon += speed * sin(heading * M_PI / 180) / (M_PER_DEG * cos(lat * M_PI / 180));
+		alt += speed * 0.01 * rnd();
+
+		fix.hour = (uint8_t) (t / 3600);
+		fix.min = (uint8_t) (t / 60 % 60);
+		fix.sec = (uint8_t) (t % 60);
+		fix.lat = (int32_t) lround((lat + rnd() * 2e-6) * 1e7);
+		fix.lon = (int32_t) lround((lon + rnd() * 2e-6) * 1e7);
+		fix.hmsl = (int32_t) lround((alt + rnd() * 0.3) * 1000);
+		fix.height = fix.hmsl + 18200;
+		fix.gspeed = speed < 0.1 ? 0 : (uint32_t) lround(speed * 100);
+		fix.heading = (int32_t) lround(heading * 1e5);
+		add(&log, &fix);
+		if (render_sentence(&fix, SENTENCE_GGA, RENDER_NMEA, &frame))
+		{
+			nmea += frame.len;
+		}
+		if (render_sentence(&fix, SENTENCE_RMC, RENDER_NMEA, &frame))
+		{
+			nmea += frame.len;
+		}
+	}
+	return report("synthetic day", &log, nmea);
+}
+
+int main(int argc, char *argv[])
+{
+	int ok = 1;
+
+	printf("%-28s %7s %9s %9s %8s %9s %8s\n", "track", "fixes", "bytes/fix", "nmea/fix", "ratio", "write amp",
+			"days");
+	for (int i = 1; i < argc; i++)
+	{
+		ok &= bench_capture(argv[i]);
+	}
+	ok &= bench_day();
+	printf("(%u byte pages, days of 1Hz fixes in a 16MB flash)\n", TRACK_PAGE_SIZE);
+	return ok ? 0 : 1;
+}
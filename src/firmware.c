@@ -0,0 +1,1079 @@
+/*
+ * firmware.c
+ *
+ *  Created on: 16 Oct 2026
+ *  Author: Dmitry Melnichansky / 4Z7DTF
+ *
+ *  USART, frame pool and LED routines moved from main.c. Received bytes
+ *  are queued by USART_RX_vect and fed to the transform by firmware_poll().
+ *  Complete frames go to the output scheduler, which keeps the newest
+ *  frame of each type. USART_UDRE_vect takes them in priority order and
+ *  sends them back to back.
+ *  With VX8_CUT_THROUGH defined there is no frame pool. Fields released
+ *  by the transform are sent from its only frame and the next byte is fed
+ *  after they are sent. Received bytes wait in the ring buffer meanwhile.
+ *  With VX8_SOFT_TX defined the output is sent by the Timer1 software UART
+ *  on the same pin at 9600 baud and the USART only receives, at
+ *  GPS_BAUDRATE. Both transmitters take the bytes from tx_next().
+ *  With VX8_UBX_INPUT defined the GPS sends UBX NAV messages instead of
+ *  NMEA. They are decoded by ubx.c and at the end of every epoch the
+ *  sentences are rendered from the fix by render.c into free frames.
+ *  Every sentence is kept as a template in render_cache and only its
+ *  changed fields are rewritten in the next epoch.
+ *  With VX8_GPS_CONFIG defined the GPS is configured by gps_config.c
+ *  before the USART is initialized.
+ *  With VX8_LAST_FIX defined valid fixes are saved by last_fix.c. The
+ *  saved position is sent to the GPS as aiding by gps_config.c and, with
+ *  VX8_LAST_FIX_OUTPUT, to VX-8 at boot as a flagged last-known position.
+ *  With VX8_TELEMETRY defined the parser results, dropped bytes and frames
+ *  and the sentence latency are counted by telemetry.c and sent as $PVX8S
+ *  after a frame hand-off. The time a sentence started is the time its $
+ *  was received, found from the backlog of the RX ring buffer when the
+ *  main loop takes the $, so the RX interrupt does not read the clock.
+ *  With VX8_PPS defined the GPS time pulse is captured by pps.c. TX takes
+ *  no new frame from the pulse until PPS_PHASE_MS after it. Then the main
+ *  loop sets the milliseconds of the held sentences to the time their last
+ *  byte will be sent and pps.c wakes it to start TX at a whole millisecond
+ *  after the pulse.
+ *  With VX8_NMEA_OUTPUT defined every sentence is also sent as standard
+ *  NMEA by the second software UART channel. The fix is read from the
+ *  fields while the transform converts them, or taken from the UBX epoch,
+ *  and rendered in the NMEA dialect into a frame pool with its own
+ *  scheduler, so the input is parsed once and the outputs have their own
+ *  rate dividers.
+ *  With VX8_TRACK_LOG defined every valid fix is added to the track log
+ *  at its GGA, or at the end of the UBX epoch, and the log pages are
+ *  written to the SPI flash by the main loop. A page write holds the main
+ *  loop for the SPI transfer of the page, the RX ring buffer takes the
+ *  bytes received meanwhile.
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include <util/atomic.h>
+#include "../src/firmware.h"
+#include "../src/ring_buffer.h"
+#include "../src/scheduler.h"
+#include "../src/vx8_core.h"
+#if defined(VX8_UBX_INPUT) || defined(VX8_LAST_FIX) || defined(VX8_PPS) || defined(VX8_NMEA_OUTPUT) \
+		|| defined(VX8_TRACK_LOG)
+#include "../src/render.h"
+#include "../src/sentences.h"
+#endif
+#ifdef VX8_UBX_INPUT
+#include "../src/ubx.h"
+#endif
+#ifdef VX8_LAST_FIX
+#include "../src/last_fix.h"
+#endif
+#if defined(VX8_SOFT_TX) || defined(VX8_NMEA_OUTPUT)
+#include "../src/soft_uart.h"
+#endif
+#ifdef VX8_GPS_CONFIG
+#include "../src/gps_config.h"
+#endif
+#ifdef VX8_TELEMETRY
+#include "../src/telemetry.h"
+#endif
+#ifdef VX8_PPS
+#include "../src/pps.h"
+#endif
+#if defined(VX8_TELEMETRY) || defined(VX8_PPS)
+#include "../src/timer1.h"
+#endif
+#ifdef VX8_TRACK_LOG
+#include "../src/spi_flash.h"
+#include "../src/track_log.h"
+#endif
+
+/* Baud rate of the GPS receiver. Without VX8_SOFT_TX the USART sends to
+ * VX-8 at the same rate, which must be 9600.
+ */
+#ifndef GPS_BAUDRATE
+#define GPS_BAUDRATE 9600
+#endif
+#if !defined(VX8_SOFT_TX) && GPS_BAUDRATE != 9600
+#error "GPS_BAUDRATE other than 9600 requires VX8_SOFT_TX"
+#endif
+#if defined(VX8_UBX_INPUT) && defined(VX8_CUT_THROUGH)
+#error "VX8_UBX_INPUT renders complete sentences, VX8_CUT_THROUGH isn't supported"
+#endif
+#if defined(VX8_LAST_FIX) && defined(VX8_CUT_THROUGH)
+#error "VX8_LAST_FIX reads complete sentences, VX8_CUT_THROUGH isn't supported"
+#endif
+#if defined(VX8_LAST_FIX_OUTPUT) && !defined(VX8_LAST_FIX)
+#error "VX8_LAST_FIX_OUTPUT requires VX8_LAST_FIX"
+#endif
+#if defined(VX8_TELEMETRY) && defined(VX8_CUT_THROUGH)
+#error "VX8_TELEMETRY sends complete frames, VX8_CUT_THROUGH isn't supported"
+#endif
+#if defined(VX8_PPS) && defined(VX8_CUT_THROUGH)
+#error "VX8_PPS holds complete frames, VX8_CUT_THROUGH isn't supported"
+#endif
+#if defined(VX8_NMEA_OUTPUT) && defined(VX8_CUT_THROUGH)
+#error "VX8_NMEA_OUTPUT reads complete sentences, VX8_CUT_THROUGH isn't supported"
+#endif
+#if defined(VX8_NMEA_OUTPUT) && defined(VX8_PPS)
+#error "VX8_NMEA_OUTPUT and VX8_PPS both use Timer1 compare unit B"
+#endif
+#if defined(VX8_TRACK_LOG) && defined(VX8_CUT_THROUGH)
+#error "VX8_TRACK_LOG reads complete sentences, VX8_CUT_THROUGH isn't supported"
+#endif
+#define BAUD GPS_BAUDRATE
+#ifdef VX8_TELEMETRY
+#define RX_BYTE_TICKS (TIMER1_HZ * 10 / GPS_BAUDRATE) /* 10 bits per byte */
+#endif
+#ifdef VX8_PPS
+#define OUT_BAUDRATE 9600 /* VX-8 */
+#define RELEASE_MARGIN_MS 2 /* Time to set the held sentences before TX starts. */
+#endif
+#define BAUD_TOL 3 /* 115200 baud is 2.1% off at 16MHz. */
+#include <util/setbaud.h>
+/* setbaud.h only warns when the baud rate is out of tolerance, the USART
+ * wouldn't receive reliably, so stop the build. */
+#if USE_2X
+#define BAUD_DIVISOR 8UL
+#else
+#define BAUD_DIVISOR 16UL
+#endif
+#if 100 * F_CPU > (100 + BAUD_TOL) * BAUD_DIVISOR * (UBRR_VALUE + 1) * BAUD || \
+	100 * F_CPU < (100 - BAUD_TOL) * BAUD_DIVISOR * (UBRR_VALUE + 1) * BAUD
+#error "GPS_BAUDRATE is more than BAUD_TOL percent off at this F_CPU"
+#endif
+
+/* Led output pin definitions. All the LEDs are connected to PORTD. */
+#ifdef ARDUINO
+/* Arduino Nano: pins 7, 5, 4 and 2. */
+#define GGA_GREEN 0B10000000 /* GGA sentence valid */
+#define GGA_RED 0B00100000 /* GGA sentence invalid */
+#define RMC_GREEN 0B00010000 /* RMC sentence valid */
+#define RMC_RED 0B00000100 /* RMC sentence invalid */
+#else
+/* Stand-alone ATmega328P board: PD7-PD4. */
+#define GGA_GREEN 0B10000000 /* GGA sentence valid */
+#define GGA_RED 0B01000000 /* GGA sentence invalid */
+#define RMC_GREEN 0B00100000 /* RMC sentence valid */
+#define RMC_RED 0B00010000 /* RMC sentence invalid */
+#endif
+#ifdef VX8_NMEA_OUTPUT
+#define ALL_OFF 0B00001011 /* All LEDs off, PD3 is the NMEA output. */
+#else
+#define ALL_OFF 0B00000011 /* All LEDs off */
+#endif
+
+/* Number of frames in the pool: one waiting for TX per scheduler slot,
+ * one being sent and one being received. There is always a free frame
+ * for RX.
+ */
+#define FRAME_COUNT (SCHED_TYPES + 2)
+#define NMEA_FRAME_COUNT (SENTENCE_COUNT + 2)
+#define NO_FRAME SCHED_NONE
+#define NO_TX 0xFF
+
+/* Benchmark trace. With VX8_TRACE defined the main loop writes the state
+ * of the transform to GPIOR0 before feeding a byte, the result of
+ * vx8_feed() to GPIOR1 after it and TRACE_IDLE to GPIOR0 when done. Frame
+ * hand-off is marked with TRACE_HANDOFF. With VX8_UBX_INPUT feeding is
+ * marked with TRACE_UBX and rendering with TRACE_RENDER, the telemetry
+ * sentence with TRACE_TELEMETRY. bench/bench_avr.c watches these writes
+ * in simavr to attribute cycles to the states. The registers are not used
+ * otherwise.
+ */
+#ifdef VX8_TRACE
+#define TRACE(x) (GPIOR0 = (x))
+#define TRACE_RESULT(x) (GPIOR1 = (x))
+#else
+#define TRACE(x)
+#define TRACE_RESULT(x)
+#endif
+#define TRACE_HANDOFF 0x10
+#define TRACE_UBX 0x20
+#define TRACE_RENDER 0x21
+#define TRACE_TELEMETRY 0x30
+#define TRACE_IDLE 0xFF
+
+#ifndef VX8_CUT_THROUGH
+static void queue_frame(void);
+#ifdef VX8_UBX_INPUT
+static void render_epoch(void);
+#endif
+#ifdef VX8_TELEMETRY
+static void send_telemetry(void);
+#endif
+#ifdef VX8_PPS
+static void release_epoch(void);
+static void start_epoch(void);
+#endif
+#ifdef VX8_NMEA_OUTPUT
+static void queue_nmea(const struct gps_fix *, uint8_t);
+static uint8_t nmea_tx_next(uint8_t *);
+#endif
+static uint8_t free_frame(void);
+#endif
+static void start_tx(void);
+static uint8_t tx_next(uint8_t *);
+static void tx_output_start(void);
+static uint8_t poll_pending(void);
+static void leds_off(void);
+static void show_leds(uint8_t);
+static void usart_init(void);
+
+#ifdef VX8_UBX_INPUT
+struct ubx ubx; /* UBX input context. */
+struct render_cache render_cache; /* Sentences of the last epoch. */
+#else
+struct vx8 vx8; /* Transform context. */
+#if defined(VX8_LAST_FIX) || defined(VX8_NMEA_OUTPUT) || defined(VX8_TRACK_LOG)
+struct gps_fix fix; /* Fix read from the converted fields by vx8_core.c. */
+#endif
+#endif
+struct ring_buffer rx_ring; /* Bytes received by USART_RX_vect and not processed yet. */
+
+#ifdef VX8_CUT_THROUGH
+struct vx8_frame frame; /* Part of the sentence not sent yet. */
+volatile uint8_t tx_pos; /* Number of bytes taken for TX, NO_TX if TX is idle. */
+#else
+struct vx8_frame frames[FRAME_COUNT]; /* Frame pool shared by RX and TX. */
+uint8_t rx_frame; /* Index of the frame being received. */
+
+/* TX variables */
+struct scheduler sched; /* Frames waiting for TX. */
+volatile uint8_t tx_frame; /* Frame being sent, NO_FRAME if TX is idle. */
+uint8_t tx_high_water; /* Largest number of frames waiting for TX or being sent. */
+#ifdef VX8_TELEMETRY
+uint32_t frame_start[FRAME_COUNT]; /* Time the $ of each frame was received. */
+uint32_t rx_start; /* Time the $ of the frame being received was received. */
+#endif
+#ifdef VX8_NMEA_OUTPUT
+struct vx8_frame nmea_frames[NMEA_FRAME_COUNT]; /* Frame pool of the standard NMEA output. */
+struct scheduler nmea_sched; /* NMEA frames waiting for TX. */
+volatile uint8_t nmea_tx_frame; /* NMEA frame being sent, NO_FRAME if idle. */
+#endif
+#endif
+
+#ifdef VX8_GPS_CONFIG
+uint8_t gps_config_result; /* Result of the boot time GPS configuration. */
+#endif
+#ifdef VX8_TRACK_LOG
+struct track_log track; /* Track log in the SPI flash. */
+#endif
+
+/*
+ * Function: firmware_init
+ * -----------------------
+ *   Initializes LED pins, USART and the transform. Interrupts are enabled
+ *   by the caller.
+ *
+ *   returns:	none
+ */
+void firmware_init(void)
+{
+#if defined(VX8_LAST_FIX) && (defined(VX8_GPS_CONFIG) || defined(VX8_LAST_FIX_OUTPUT))
+	struct gps_fix last;
+	uint8_t have_last;
+#endif
+
+	DDRD = DDRD | 0B11111100;
+	PORTD &= ALL_OFF;
+	set_sleep_mode(SLEEP_MODE_IDLE);
+	ring_reset(&rx_ring);
+#ifdef VX8_CUT_THROUGH
+	tx_pos = NO_TX;
+	frame.len = 0;
+	vx8_init(&vx8, &frame);
+#else
+	rx_frame = 0;
+	tx_frame = NO_FRAME;
+	tx_high_water = 0;
+	sched_init(&sched, OUTPUT_VX8);
+#ifdef VX8_NMEA_OUTPUT
+	sched_init(&nmea_sched, OUTPUT_NMEA);
+	nmea_tx_frame = NO_FRAME;
+#endif
+#ifdef VX8_UBX_INPUT
+	ubx_init(&ubx);
+	render_cache_init(&render_cache);
+#else
+	vx8_init(&vx8, &frames[rx_frame]);
+#if defined(VX8_LAST_FIX) || defined(VX8_NMEA_OUTPUT) || defined(VX8_TRACK_LOG)
+	vx8_set_fix(&vx8, &fix);
+#endif
+#endif
+#endif
+#ifdef VX8_LAST_FIX
+	last_fix_init();
+#if defined(VX8_GPS_CONFIG) || defined(VX8_LAST_FIX_OUTPUT)
+	have_last = last_fix_get(&last);
+#endif
+#endif
+#ifdef VX8_TRACK_LOG
+	spi_flash_init();
+	track_log_init(&track, &spi_flash_store);
+#endif
+#ifdef VX8_GPS_CONFIG
+#ifdef VX8_LAST_FIX
+	gps_config_result = gps_config(GPS_BAUDRATE, have_last ? &last : 0);
+#else
+	gps_config_result = gps_config(GPS_BAUDRATE, 0);
+#endif
+#endif
+	usart_init();
+#ifdef VX8_SOFT_TX
+	soft_uart_init(SOFT_UART_VX8, tx_next);
+#endif
+#ifdef VX8_NMEA_OUTPUT
+	soft_uart_init(SOFT_UART_NMEA, nmea_tx_next);
+#endif
+#if defined(VX8_TELEMETRY) || defined(VX8_PPS)
+	timer1_clock_init();
+#endif
+#ifdef VX8_TELEMETRY
+	telemetry_init();
+	rx_start = timer1_now();
+#endif
+#ifdef VX8_PPS
+	pps_init();
+#endif
+#ifdef VX8_LAST_FIX_OUTPUT
+	/* Sent when interrupts are enabled. */
+	if (have_last)
+	{
+		render_sentence(&last, SENTENCE_GGA, RENDER_VX8, &frames[rx_frame]);
+		queue_frame();
+		render_sentence(&last, SENTENCE_RMC, RENDER_VX8, &frames[rx_frame]);
+		queue_frame();
+	}
+#endif
+#ifdef VX8_GPS_CONFIG
+	/* Both red LEDs stay on until the first sentence if it failed. */
+	if (gps_config_result != GPS_CONFIG_OK)
+	{
+		PORTD |= GGA_RED | RMC_RED;
+	}
+#endif
+}
+
+/*
+ * Function: firmware_poll
+ * -----------------------
+ *   One iteration of the main loop. Feeds one received byte to the
+ *   transform, or to the UBX input. A complete frame is handed to the
+ *   output scheduler and RX continues into a free frame.
+ *
+ *   returns:	none
+ */
+#ifdef VX8_CUT_THROUGH
+void firmware_poll(void)
+{
+	uint8_t byte;
+
+	/* Feeding the next byte moves the frame contents. Wait until the
+	 * released bytes are sent.
+	 */
+	if (tx_pos != NO_TX)
+	{
+		return;
+	}
+
+	if (ring_get(&rx_ring, &byte))
+	{
+		uint8_t res;
+		TRACE(vx8.state);
+		res = vx8_feed(&vx8, byte);
+		if (frame.len)
+		{
+			start_tx();
+		}
+		if (res == VX8_FRAME)
+		{
+			leds_off();
+		}
+		if (vx8.leds)
+		{
+			show_leds(vx8.leds);
+			vx8.leds = 0;
+		}
+		TRACE_RESULT(res);
+		TRACE(TRACE_IDLE);
+	}
+}
+#elif defined(VX8_UBX_INPUT)
+void firmware_poll(void)
+{
+	uint8_t byte;
+
+#ifdef VX8_LAST_FIX
+	last_fix_poll();
+#endif
+#ifdef VX8_TRACK_LOG
+	spi_flash_poll();
+#endif
+#ifdef VX8_PPS
+	if (pps.release)
+	{
+		release_epoch();
+	}
+	if (pps.start)
+	{
+		start_epoch();
+	}
+#endif
+	if (ring_get(&rx_ring, &byte))
+	{
+		uint8_t res;
+		TRACE(TRACE_UBX);
+		res = ubx_feed(&ubx, byte);
+#ifdef VX8_TELEMETRY
+		telemetry_count(res);
+#endif
+		TRACE(TRACE_IDLE);
+		if (res == UBX_EPOCH)
+		{
+#ifdef VX8_TELEMETRY
+			/* The epoch starts with its last message. */
+			rx_start = timer1_now() - ring_count(&rx_ring) * RX_BYTE_TICKS;
+#endif
+			TRACE(TRACE_RENDER);
+			render_epoch();
+			TRACE(TRACE_IDLE);
+#ifdef VX8_TELEMETRY
+			send_telemetry();
+#endif
+		}
+	}
+}
+
+/*
+ * Function: render_epoch
+ * ----------------------
+ *   Renders every sentence from the fix of the epoch into the RX frame and
+ *   queues it. The LEDs show the fix status until the next epoch.
+ *
+ *   returns:	none
+ */
+static void render_epoch(void)
+{
+	for (uint8_t i = 0; i < SENTENCE_COUNT; i++)
+	{
+		if (render_cached(&render_cache, &ubx.fix, i, &frames[rx_frame]))
+		{
+			queue_frame();
+		}
+	}
+	show_leds(render_leds(&ubx.fix));
+#ifdef VX8_NMEA_OUTPUT
+	for (uint8_t i = 0; i < SENTENCE_COUNT; i++)
+	{
+		queue_nmea(&ubx.fix, i);
+	}
+#endif
+#ifdef VX8_LAST_FIX
+	last_fix_update(&ubx.fix);
+#endif
+#ifdef VX8_TRACK_LOG
+	track_log_add(&track, &ubx.fix);
+#endif
+}
+#else
+void firmware_poll(void)
+{
+	uint8_t byte;
+
+#ifdef VX8_LAST_FIX
+	last_fix_poll();
+#endif
+#ifdef VX8_TRACK_LOG
+	spi_flash_poll();
+#endif
+#ifdef VX8_PPS
+	if (pps.release)
+	{
+		release_epoch();
+	}
+	if (pps.start)
+	{
+		start_epoch();
+	}
+#endif
+	if (ring_get(&rx_ring, &byte))
+	{
+		uint8_t res;
+		TRACE(vx8.state);
+#ifdef VX8_TELEMETRY
+		if (byte == '$')
+		{
+			rx_start = timer1_now() - ring_count(&rx_ring) * RX_BYTE_TICKS;
+		}
+#endif
+		res = vx8_feed(&vx8, byte);
+#ifdef VX8_TELEMETRY
+		telemetry_count(res);
+#endif
+		if (vx8.leds)
+		{
+			show_leds(vx8.leds);
+			vx8.leds = 0;
+		}
+		TRACE_RESULT(res);
+		TRACE(TRACE_IDLE);
+		if (res == VX8_FRAME)
+		{
+			TRACE(TRACE_HANDOFF);
+#if defined(VX8_LAST_FIX) || defined(VX8_NMEA_OUTPUT) || defined(VX8_TRACK_LOG)
+			if (vx8.fix_updated)
+			{
+				if (frames[rx_frame].type == SENTENCE_GGA)
+				{
+#ifdef VX8_LAST_FIX
+					last_fix_update(&fix);
+#endif
+#ifdef VX8_TRACK_LOG
+					track_log_add(&track, &fix);
+#endif
+				}
+#ifdef VX8_NMEA_OUTPUT
+				queue_nmea(&fix, frames[rx_frame].type);
+#endif
+			}
+#endif
+			queue_frame();
+			TRACE(TRACE_IDLE);
+#ifdef VX8_TELEMETRY
+			send_telemetry();
+#endif
+		}
+	}
+}
+#endif
+
+#ifndef VX8_CUT_THROUGH
+/*
+ * Function: queue_frame
+ * ---------------------
+ *   Hands the complete frame to the scheduler and continues RX into a free
+ *   frame. Starts TX if it is idle, otherwise the transmitter takes the
+ *   frame when it is done with the current one.
+ *
+ *   returns:	none
+ */
+static void queue_frame(void)
+{
+	uint8_t depth;
+
+#ifdef VX8_TELEMETRY
+	frame_start[rx_frame] = rx_start;
+#endif
+#ifdef VX8_PPS
+	if (pps.released && frames[rx_frame].type < SENTENCE_COUNT)
+	{
+		pps.late++;
+	}
+#endif
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		sched_put(&sched, frames[rx_frame].type, rx_frame);
+		if (tx_frame == NO_FRAME)
+		{
+			start_tx();
+		}
+		rx_frame = free_frame();
+		depth = firmware_tx_queue_depth();
+	}
+#ifndef VX8_UBX_INPUT
+	vx8_set_frame(&vx8, &frames[rx_frame]);
+#endif
+	if (depth > tx_high_water)
+	{
+		tx_high_water = depth;
+	}
+	leds_off();
+}
+
+#ifdef VX8_TELEMETRY
+/*
+ * Function: send_telemetry
+ * ------------------------
+ *   Renders the next page of the telemetry sentence into the RX frame and
+ *   queues it when telemetry.c asks for it. A page waits while the one
+ *   before it is still queued, so both pages are sent.
+ *
+ *   returns:	none
+ */
+static void send_telemetry(void)
+{
+	if (telemetry_due() && sched.pending[SCHED_TELEMETRY] == SCHED_NONE)
+	{
+		TRACE(TRACE_TELEMETRY);
+		telemetry_render(&frames[rx_frame], rx_ring.overflows, sched.stale, sched.skipped);
+		frames[rx_frame].type = SCHED_TELEMETRY;
+		rx_start = timer1_now();
+		queue_frame();
+		TRACE(TRACE_IDLE);
+	}
+}
+#endif
+
+#ifdef VX8_NMEA_OUTPUT
+/*
+ * Function: queue_nmea
+ * --------------------
+ *   Renders the sentence from the fix in the NMEA dialect into a free
+ *   frame of the NMEA pool and hands it to the NMEA scheduler. Starts the
+ *   NMEA channel if it is idle. Nothing is sent before the fix has a date.
+ *
+ *   fix: the fix, updated from the sentence
+ *   sentence: index of the sentence in sentences[]
+ *
+ *   returns:	none
+ */
+static void queue_nmea(const struct gps_fix *fix, uint8_t sentence)
+{
+	uint8_t i = 0;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		while (i == nmea_tx_frame || sched_holds(&nmea_sched, i))
+		{
+			i++;
+		}
+	}
+	/* The free frame isn't touched by the NMEA channel. */
+	if (!render_sentence(fix, sentence, RENDER_NMEA, &nmea_frames[i]))
+	{
+		return;
+	}
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		sched_put(&nmea_sched, sentence, i);
+	}
+	soft_uart_start(SOFT_UART_NMEA);
+}
+
+/*
+ * Function: nmea_tx_next
+ * ----------------------
+ *   Takes the next byte of the NMEA output, like tx_next() does for VX-8.
+ *   Called from TIMER1_COMPB_vect.
+ *
+ *   byte: the byte to send
+ *
+ *   returns:	1 if a byte was taken, 0 if no frame is waiting.
+ */
+static uint8_t nmea_tx_next(uint8_t *byte)
+{
+	uint8_t cur = nmea_tx_frame;
+
+	if (cur == NO_FRAME || nmea_frames[cur].pos >= nmea_frames[cur].len)
+	{
+		cur = sched_next(&nmea_sched);
+		nmea_tx_frame = cur;
+		if (cur == NO_FRAME)
+		{
+			return 0;
+		}
+		nmea_frames[cur].pos = 0;
+	}
+	*byte = nmea_frames[cur].buffer[nmea_frames[cur].pos++];
+	return 1;
+}
+#endif
+
+#ifdef VX8_PPS
+/*
+ * Function: release_epoch
+ * -----------------------
+ *   Prepares the frames held since the time pulse. The milliseconds of
+ *   their time fields are set to the time from the pulse to the end of
+ *   their last byte, with TX starting RELEASE_MARGIN_MS from now, and
+ *   pps.c is set to wake the main loop then. If a frame from before the
+ *   pulse is still being sent, TX continues with the held frames at once
+ *   and their time isn't set.
+ *
+ *   returns:	none
+ */
+static void release_epoch(void)
+{
+	uint8_t order[SCHED_TYPES];
+	uint8_t count;
+	uint8_t sending;
+	uint16_t start;
+	uint32_t bytes = 0;
+
+	pps.release = 0;
+	pps.released = 1;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		sending = tx_frame != NO_FRAME;
+		if (sending)
+		{
+			pps.hold = 0;
+		}
+	}
+	if (sending)
+	{
+		return;
+	}
+	start = pps_elapsed_ms() + RELEASE_MARGIN_MS;
+	count = sched_order(&sched, order);
+	for (uint8_t i = 0; i < count; i++)
+	{
+		struct vx8_frame *frame = &frames[order[i]];
+		bytes += frame->len;
+		render_set_ms(frame, (uint16_t) (start + (bytes * 10000UL + OUT_BAUDRATE / 2) / OUT_BAUDRATE));
+	}
+	pps_start_at(start);
+}
+
+/*
+ * Function: start_epoch
+ * ---------------------
+ *   Starts sending the held frames at the time set by release_epoch().
+ *
+ *   returns:	none
+ */
+static void start_epoch(void)
+{
+	pps.start = 0;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		if (tx_frame == NO_FRAME)
+		{
+			start_tx();
+		}
+	}
+}
+#endif
+#endif
+
+/*
+ * Function: firmware_sleep
+ * ------------------------
+ *   Puts the MCU to IDLE sleep if firmware_poll() has nothing to do. USART
+ *   keeps running in IDLE mode and its interrupts wake the MCU. The check
+ *   is done with interrupts disabled. sleep_cpu() executes before any
+ *   interrupt enabled by sei() is serviced, so a byte received after the
+ *   check wakes the MCU immediately.
+ *
+ *   returns:	none
+ */
+void firmware_sleep(void)
+{
+	cli();
+	if (!poll_pending())
+	{
+		sleep_enable();
+		sei();
+		sleep_cpu();
+		sleep_disable();
+	}
+	sei();
+}
+
+/*
+ * Function: poll_pending
+ * ----------------------
+ *   Checks whether firmware_poll() can make progress without waiting for
+ *   an interrupt. Called with interrupts disabled.
+ *
+ *   returns:	1 if there is work for firmware_poll(), 0 otherwise.
+ */
+#ifdef VX8_CUT_THROUGH
+static uint8_t poll_pending(void)
+{
+	return tx_pos == NO_TX && ring_count(&rx_ring) != 0;
+}
+#else
+static uint8_t poll_pending(void)
+{
+#ifdef VX8_PPS
+	if (pps.release || pps.start)
+	{
+		return 1;
+	}
+#endif
+	return ring_count(&rx_ring) != 0;
+}
+#endif
+
+#ifdef VX8_CUT_THROUGH
+/*
+ * Function: firmware_tx_queue_depth
+ * ---------------------------------
+ *   There is no TX queue in cut-through mode. Released bytes are sent
+ *   directly from the frame.
+ *
+ *   returns:	1 while released bytes are being sent, 0 otherwise.
+ */
+uint8_t firmware_tx_queue_depth(void)
+{
+	return tx_pos != NO_TX;
+}
+
+/*
+ * Function: start_tx
+ * ------------------
+ *   Starts sending the bytes released by the transform. The transmitter
+ *   takes them with tx_next().
+ *
+ *   returns:	none
+ */
+static void start_tx(void)
+{
+	tx_pos = 0;
+	tx_output_start();
+}
+
+/*
+ * Function: tx_next
+ * -----------------
+ *   Takes the next released byte for the transmitter. Called from its
+ *   interrupt. Marks TX idle when all the bytes are taken.
+ *
+ *   byte: the byte to send
+ *
+ *   returns:	1 if a byte was taken, 0 if TX is done.
+ */
+static uint8_t tx_next(uint8_t *byte)
+{
+	uint8_t pos = tx_pos;
+	if (pos >= frame.len)
+	{
+		tx_pos = NO_TX;
+		return 0;
+	}
+	*byte = frame.buffer[pos];
+	tx_pos = pos + 1;
+	return 1;
+}
+#else
+/*
+ * Function: firmware_tx_queue_depth
+ * ---------------------------------
+ *   Number of complete frames waiting for TX, including the one being
+ *   sent. tx_high_water holds the largest value seen.
+ *
+ *   returns:	the queue depth, 0 to SCHED_TYPES + 1.
+ */
+uint8_t firmware_tx_queue_depth(void)
+{
+	uint8_t depth;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		depth = sched_depth(&sched) + (tx_frame != NO_FRAME);
+	}
+	return depth;
+}
+
+/*
+ * Function: free_frame
+ * --------------------
+ *   Finds a frame which is neither being sent nor waiting for TX. Called
+ *   with interrupts disabled.
+ *
+ *   returns:	index of the free frame.
+ */
+static uint8_t free_frame(void)
+{
+	uint8_t i = 0;
+	while (i == tx_frame || sched_holds(&sched, i))
+	{
+		i++;
+	}
+	return i;
+}
+
+/*
+ * Function: start_tx
+ * ------------------
+ *   Starts sending the next frame chosen by the scheduler. Must be called
+ *   with TX idle and interrupts disabled. The transmitter takes the rest
+ *   of the frame and the frames after it with tx_next().
+ *
+ *   returns:	none
+ */
+static void start_tx(void)
+{
+	tx_output_start();
+}
+
+/*
+ * Function: tx_next
+ * -----------------
+ *   Takes the next byte of the frame being sent for the transmitter.
+ *   Called from its interrupt. At the end of the frame releases it and
+ *   continues with the next frame chosen by the scheduler without a gap.
+ *
+ *   byte: the byte to send
+ *
+ *   returns:	1 if a byte was taken, 0 if no frame is waiting.
+ */
+static uint8_t tx_next(uint8_t *byte)
+{
+	uint8_t cur = tx_frame;
+	struct vx8_frame *buf;
+
+	if (cur == NO_FRAME || frames[cur].pos >= frames[cur].len)
+	{
+#ifdef VX8_PPS
+		if (pps.hold)
+		{
+			tx_frame = NO_FRAME;
+			return 0;
+		}
+#endif
+		cur = sched_next(&sched);
+		tx_frame = cur;
+		if (cur == NO_FRAME)
+		{
+			return 0;
+		}
+		frames[cur].pos = 0;
+	}
+	buf = &frames[cur];
+	*byte = buf->buffer[buf->pos++];
+#ifdef VX8_TELEMETRY
+	if (buf->pos == buf->len && buf->type != SCHED_TELEMETRY)
+	{
+		telemetry_sent(frame_start[cur]);
+	}
+#endif
+	return 1;
+}
+#endif
+
+/*
+ * Function: tx_output_start
+ * -------------------------
+ *   Starts the transmitter if tx_next() has a byte for it.
+ *
+ *   returns:	none
+ */
+#ifdef VX8_SOFT_TX
+static void tx_output_start(void)
+{
+	soft_uart_start(SOFT_UART_VX8);
+}
+#else
+static void tx_output_start(void)
+{
+	uint8_t byte;
+	if (tx_next(&byte))
+	{
+		UDR0 = byte;
+		UCSR0B |= (1 << UDRIE0); /* Enable buffer empty interrupt */
+	}
+}
+#endif
+
+/*
+ * Function: leds_off
+ * ------------------
+ *   Turns all the LEDs off. With VX8_SOFT_TX the software UART interrupt
+ *   writes PORTD too, so the read-modify-write is atomic.
+ *
+ *   returns:	none
+ */
+static void leds_off(void)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		PORTD &= ALL_OFF;
+	}
+}
+
+/*
+ * Function: show_leds
+ * -------------------
+ *   Turns on the LEDs of the given VX8_LED_* events. The LEDs are turned
+ *   off when the next frame is handed to TX.
+ *
+ *   returns:	none
+ */
+static void show_leds(uint8_t leds)
+{
+	if (leds & VX8_LED_GGA_GREEN)
+		PORTD |= GGA_GREEN;
+	if (leds & VX8_LED_GGA_RED)
+		PORTD |= GGA_RED;
+	if (leds & VX8_LED_RMC_GREEN)
+		PORTD |= RMC_GREEN;
+	if (leds & VX8_LED_RMC_RED)
+		PORTD |= RMC_RED;
+}
+
+/* UART routines */
+/*
+ * Function: usart_init
+ * --------------------
+ *   Initializes UART, enables RX, TX unless VX8_SOFT_TX is defined and
+ *   interrupts.
+ *
+ *   returns:	none
+ */
+static void usart_init(void)
+{
+	/* Set baud rate */
+	UBRR0H = UBRRH_VALUE;
+	UBRR0L = UBRRL_VALUE;
+#if USE_2X
+	UCSR0A |= (1 << U2X0);
+#else
+	UCSR0A &= ~(1 << U2X0);
+#endif
+	/* Set frame format to 8 data bits, no parity, 1 stop bit */
+	UCSR0C |= (1 << UCSZ01) | (1 << UCSZ00);
+	/* Enable reception and transmission */
+#ifdef VX8_SOFT_TX
+	UCSR0B |= (1 << RXEN0);
+#else
+	UCSR0B |= (1 << RXEN0) | (1 << TXEN0);
+#endif
+	/* Enable RX Complete interrupt */
+	UCSR0B |= (1 << RXCIE0);
+}
+
+/*
+ * Function: ISR(USART_RX_vect)
+ * ----------------------------
+ *   RX Complete interrupt service routine. Adds the received byte to
+ *   the RX ring buffer. If the buffer is full the byte is dropped and
+ *   counted in rx_ring.overflows. With VX8_TELEMETRY bytes lost by the
+ *   USART before this interrupt read them are counted too.
+ *
+ *   returns:	none
+ */
+ISR(USART_RX_vect)
+{
+#ifdef VX8_TELEMETRY
+	if (UCSR0A & (1 << DOR0))
+	{
+		telemetry.overruns++;
+	}
+#endif
+	ring_put(&rx_ring, UDR0);
+}
+
+/*
+ * Function: ISR(USART_UDRE_vect)
+ * ------------------------------
+ *   UART Data Register Empty service routine. Sends the next byte taken
+ *   by tx_next(). If there is none, disables UART Data Register Empty
+ *   interrupt.
+ *
+ *   returns:	none
+ */
+#ifndef VX8_SOFT_TX
+ISR(USART_UDRE_vect)
+{
+	uint8_t byte;
+	if (tx_next(&byte))
+	{
+		UDR0 = byte;
+	}
+	else
+	{
+		UCSR0B &= ~(1 << UDRIE0); /* Disable UDR0 empty interrupt */
+	}
+}
+#endif
@@ -0,0 +1,30 @@
+/*
+ * firmware.h
+ *
+ *  Created on: 16 Oct 2026
+ *  Author: Dmitry Melnichansky / 4Z7DTF
+ *
+ *  AVR part of the firmware shared by the stand-alone ATmega328P build
+ *  (main.c) and the Arduino sketch: USART, RX ring buffer, frame pool and
+ *  status LEDs around the hardware independent transform in vx8_core.c.
+ */
+
+#ifndef FIRMWARE_H_
+#define FIRMWARE_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void firmware_init(void);
+void firmware_poll(void);
+void firmware_sleep(void);
+uint8_t firmware_tx_queue_depth(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FIRMWARE_H_ */
@@ -0,0 +1,357 @@
+/*
+ * gps_config.c
+ *
+ *  Created on: 16 Oct 2026
+ *  Author: Dmitry Melnichansky / 4Z7DTF
+ *
+ *  Runs before interrupts are enabled and uses USART0 by polling. The
+ *  baud rate of the GPS is found by polling CFG-RATE at each of the
+ *  supported rates until a valid UBX frame comes back. Then CFG-MSG
+ *  enables the messages used by the firmware and disables the rest of the
+ *  default output, CFG-RATE sets the navigation rate and CFG-PRT sets the
+ *  baud rate and protocols of the GPS UART. Every command is retried
+ *  until it is acknowledged. The acknowledgement of CFG-PRT may be lost
+ *  in the baud rate change, so it is checked by polling again at the new
+ *  rate. A position saved before power-off is sent last as UBX-AID-INI.
+ */
+
+#ifdef VX8_GPS_CONFIG
+
+#include <string.h>
+#include <avr/io.h>
+#include <util/delay.h>
+#include "../src/gps_config.h"
+#include "../src/progmem.h"
+#include "../src/ubx.h"
+
+#define RETRIES 3
+#define ACK_TIMEOUT_MS 250
+#define POLL_STEP_US 10
+#define BAUD_TOLERANCE 32 /* Largest baud rate error: 1/32, about 3% */
+
+#define UBX_CLASS_NMEA 0xF0
+#define NMEA_GGA 0x00
+#define NMEA_GLL 0x01
+#define NMEA_GSA 0x02
+#define NMEA_GSV 0x03
+#define NMEA_RMC 0x04
+#define NMEA_VTG 0x05
+#define NMEA_ZDA 0x08
+
+#define UBX_PORT_UART1 1
+#define UBX_PORT_MODE_8N1 0x000008D0UL
+#define UBX_PROTO_UBX 0x0001
+#define UBX_PROTO_NMEA 0x0002
+#define UBX_TIME_REF_GPS 1
+#define UBX_AID_INI_POS 0x01 /* Position is valid. */
+#define UBX_AID_INI_LLA 0x20 /* Position is latitude, longitude and altitude. */
+#define AID_POS_ACC_CM 10000000UL /* 100km, the receiver may have been moved. */
+
+/* Baud rates tried when looking for the GPS, the factory default first. */
+static const uint32_t baud_rates[] PROGMEM = { 9600, 38400, 115200, 57600, 19200, 4800 };
+
+/* CFG-MSG payloads: class, ID and rate on the port the command came from. */
+static const uint8_t msg_rates[][3] PROGMEM = {
+#ifdef VX8_UBX_INPUT
+	{ UBX_CLASS_NAV, UBX_NAV_POSLLH, 1 },
+	{ UBX_CLASS_NAV, UBX_NAV_DOP, 1 },
+	{ UBX_CLASS_NAV, UBX_NAV_SOL, 1 },
+	{ UBX_CLASS_NAV, UBX_NAV_VELNED, 1 },
+	{ UBX_CLASS_NAV, UBX_NAV_TIMEUTC, 1 },
+#else
+	{ UBX_CLASS_NMEA, NMEA_GGA, 1 },
+	{ UBX_CLASS_NMEA, NMEA_RMC, 1 },
+	{ UBX_CLASS_NMEA, NMEA_ZDA, 1 },
+	{ UBX_CLASS_NMEA, NMEA_GLL, 0 },
+	{ UBX_CLASS_NMEA, NMEA_GSA, 0 },
+	{ UBX_CLASS_NMEA, NMEA_GSV, 0 },
+	{ UBX_CLASS_NMEA, NMEA_VTG, 0 },
+#endif
+};
+
+#ifdef VX8_UBX_INPUT
+#define OUT_PROTO UBX_PROTO_UBX
+#else
+#define OUT_PROTO UBX_PROTO_NMEA
+#endif
+
+static uint8_t set_baud(uint32_t);
+static uint32_t detect_baud(struct ubx *);
+static uint8_t probe(struct ubx *);
+static uint8_t command(struct ubx *, uint8_t, const uint8_t *, uint8_t);
+static uint8_t wait_response(struct ubx *, uint8_t, uint8_t);
+static void send(uint8_t, uint8_t, const uint8_t *, uint8_t);
+static void send_aid(const struct gps_fix *);
+static void put_byte(uint8_t);
+static void put_u32(uint8_t *, uint32_t);
+
+/*
+ * Function: gps_config
+ * --------------------
+ *   Configures the GPS and leaves USART0 disabled. Called before
+ *   usart_init().
+ *
+ *   baud: baud rate to set in the GPS
+ *   aid: position sent as UBX-AID-INI after the configuration, or 0
+ *
+ *   returns:	one of gps_config_results values.
+ */
+uint8_t gps_config(uint32_t baud, const struct gps_fix *aid)
+{
+	struct ubx ctx;
+	uint8_t payload[20];
+	uint8_t result = GPS_CONFIG_OK;
+	uint32_t found;
+
+	ubx_init(&ctx);
+	UCSR0C = (1 << UCSZ01) | (1 << UCSZ00);
+	UCSR0B = (1 << RXEN0) | (1 << TXEN0);
+
+	found = detect_baud(&ctx);
+	if (found == 0)
+	{
+		UCSR0B = 0;
+		return GPS_CONFIG_NO_GPS;
+	}
+
+	for (uint8_t i = 0; i < sizeof(msg_rates) / sizeof(msg_rates[0]); i++)
+	{
+		memcpy_P(payload, msg_rates[i], sizeof(msg_rates[i]));
+		if (!command(&ctx, UBX_CFG_MSG, payload, sizeof(msg_rates[i])))
+		{
+			result = GPS_CONFIG_NAK;
+		}
+	}
+
+	/* measRate in ms, navRate in measurement cycles and timeRef */
+	payload[0] = (uint8_t) (1000 / GPS_RATE_HZ);
+	payload[1] = (uint8_t) ((1000 / GPS_RATE_HZ) >> 8);
+	payload[2] = 1;
+	payload[3] = 0;
+	payload[4] = UBX_TIME_REF_GPS;
+	payload[5] = 0;
+	if (!command(&ctx, UBX_CFG_RATE, payload, 6))
+	{
+		result = GPS_CONFIG_NAK;
+	}
+
+	/* UART1 in 8N1 mode at the new baud rate. Only UBX input is accepted,
+	 * so the sentences sent to VX-8 are ignored. */
+	memset(payload, 0, sizeof(payload));
+	payload[0] = UBX_PORT_UART1;
+	put_u32(payload + 4, UBX_PORT_MODE_8N1);
+	put_u32(payload + 8, baud);
+	payload[12] = (uint8_t) UBX_PROTO_UBX;
+	payload[14] = (uint8_t) OUT_PROTO;
+	for (uint8_t i = 0; i < RETRIES; i++)
+	{
+		set_baud(found);
+		send(UBX_CLASS_CFG, UBX_CFG_PRT, payload, sizeof(payload));
+		wait_response(&ctx, UBX_CLASS_CFG, UBX_CFG_PRT);
+		if (set_baud(baud) && probe(&ctx))
+		{
+			if (aid)
+			{
+				send_aid(aid);
+			}
+			UCSR0B = 0;
+			return result;
+		}
+	}
+	UCSR0B = 0;
+	return GPS_CONFIG_BAUD;
+}
+
+/*
+ * Function: set_baud
+ * ------------------
+ *   Sets the USART0 baud rate in double speed mode.
+ *
+ *   returns:	1 if the rate was set, 0 if the error would be too large
+ *   			at this clock frequency.
+ */
+static uint8_t set_baud(uint32_t baud)
+{
+	uint16_t ubrr = (uint16_t) ((F_CPU + 4 * baud) / (8 * baud) - 1);
+	uint32_t actual = F_CPU / (8 * (ubrr + 1UL));
+	uint32_t error = actual > baud ? actual - baud : baud - actual;
+
+	if (error > baud / BAUD_TOLERANCE)
+	{
+		return 0;
+	}
+	UCSR0A |= (1 << U2X0);
+	UBRR0H = (uint8_t) (ubrr >> 8);
+	UBRR0L = (uint8_t) ubrr;
+	return 1;
+}
+
+/*
+ * Function: detect_baud
+ * ---------------------
+ *   Probes the supported baud rates until the GPS responds.
+ *
+ *   returns:	the baud rate of the GPS, 0 if it doesn't respond.
+ */
+static uint32_t detect_baud(struct ubx *ctx)
+{
+	for (uint8_t i = 0; i < RETRIES; i++)
+	{
+		for (uint8_t j = 0; j < sizeof(baud_rates) / sizeof(baud_rates[0]); j++)
+		{
+			uint32_t baud = pgm_read_dword(&baud_rates[j]);
+			if (set_baud(baud) && probe(ctx))
+			{
+				return baud;
+			}
+		}
+	}
+	return 0;
+}
+
+/*
+ * Function: probe
+ * ---------------
+ *   Polls CFG-RATE and waits for a valid UBX frame, which shows that the
+ *   baud rate is right.
+ *
+ *   returns:	1 if a frame was received, 0 otherwise.
+ */
+static uint8_t probe(struct ubx *ctx)
+{
+	ubx_init(ctx);
+	while (UCSR0A & (1 << RXC0))
+	{
+		(void) UDR0;
+	}
+	send(UBX_CLASS_CFG, UBX_CFG_RATE, 0, 0);
+	return wait_response(ctx, 0, 0) != UBX_NONE;
+}
+
+/*
+ * Function: command
+ * -----------------
+ *   Sends a CFG command until it is acknowledged or rejected, at most
+ *   RETRIES times.
+ *
+ *   returns:	1 if the command was acknowledged, 0 otherwise.
+ */
+static uint8_t command(struct ubx *ctx, uint8_t msg_id, const uint8_t *payload, uint8_t len)
+{
+	for (uint8_t i = 0; i < RETRIES; i++)
+	{
+		uint8_t res;
+		send(UBX_CLASS_CFG, msg_id, payload, len);
+		res = wait_response(ctx, UBX_CLASS_CFG, msg_id);
+		if (res != UBX_NONE)
+		{
+			return res == UBX_ACK;
+		}
+	}
+	return 0;
+}
+
+/*
+ * Function: wait_response
+ * -----------------------
+ *   Feeds the received bytes to the UBX parser for up to ACK_TIMEOUT_MS
+ *   until the acknowledgement of the given message arrives. With class 0
+ *   any complete frame with a valid checksum is accepted.
+ *
+ *   returns:	UBX_ACK or UBX_NAK, or the result of the accepted frame,
+ *   			UBX_NONE on timeout.
+ */
+static uint8_t wait_response(struct ubx *ctx, uint8_t msg_class, uint8_t msg_id)
+{
+	for (uint16_t i = 0; i < ACK_TIMEOUT_MS * (1000 / POLL_STEP_US); i++)
+	{
+		if (UCSR0A & (1 << RXC0))
+		{
+			uint8_t res = ubx_feed(ctx, UDR0);
+			if (msg_class == 0)
+			{
+				if (res != UBX_NONE && res != UBX_REJECT_CHECKSUM)
+				{
+					return res;
+				}
+			}
+			else if ((res == UBX_ACK || res == UBX_NAK) && ctx->payload[0] == msg_class
+					&& ctx->payload[1] == msg_id)
+			{
+				return res;
+			}
+		}
+		_delay_us(POLL_STEP_US);
+	}
+	return UBX_NONE;
+}
+
+/*
+ * Function: send_aid
+ * ------------------
+ *   Sends the position as UBX-AID-INI in latitude, longitude and altitude
+ *   format with AID_POS_ACC_CM accuracy. Time isn't sent, there is no
+ *   clock running while the power is off. AID-INI isn't acknowledged.
+ *
+ *   returns:	none
+ */
+static void send_aid(const struct gps_fix *fix)
+{
+	uint8_t payload[48];
+
+	memset(payload, 0, sizeof(payload));
+	put_u32(payload, (uint32_t) fix->lat);
+	put_u32(payload + 4, (uint32_t) fix->lon);
+	put_u32(payload + 8, (uint32_t) (fix->height / 10));
+	put_u32(payload + 12, AID_POS_ACC_CM);
+	put_u32(payload + 44, UBX_AID_INI_POS | UBX_AID_INI_LLA);
+	send(UBX_CLASS_AID, UBX_AID_INI, payload, sizeof(payload));
+}
+
+/*
+ * Function: send
+ * --------------
+ *   Sends a UBX message with its checksum.
+ *
+ *   returns:	none
+ */
+static void send(uint8_t msg_class, uint8_t msg_id, const uint8_t *payload, uint8_t len)
+{
+	uint8_t ck_a = 0;
+	uint8_t ck_b = 0;
+	uint8_t header[4] = { msg_class, msg_id, len, 0 };
+
+	put_byte(UBX_SYNC_CHAR_1);
+	put_byte(UBX_SYNC_CHAR_2);
+	for (uint8_t i = 0; i < sizeof(header) + len; i++)
+	{
+		uint8_t byte = i < sizeof(header) ? header[i] : payload[i - sizeof(header)];
+		put_byte(byte);
+		ck_a += byte;
+		ck_b += ck_a;
+	}
+	put_byte(ck_a);
+	put_byte(ck_b);
+	/* The baud rate may be changed right after the message. */
+	while (!(UCSR0A & (1 << TXC0)))
+		;
+}
+
+static void put_byte(uint8_t byte)
+{
+	while (!(UCSR0A & (1 << UDRE0)))
+		;
+	UCSR0A |= (1 << TXC0);
+	UDR0 = byte;
+}
+
+static void put_u32(uint8_t *p, uint32_t v)
+{
+	for (uint8_t i = 0; i < 4; i++)
+	{
+		p[i] = (uint8_t) v;
+		v >>= 8;
+	}
+}
+
+#endif /* VX8_GPS_CONFIG */
@@ -0,0 +1,35 @@
+/*
+ * gps_config.h
+ *
+ *  Created on: 16 Oct 2026
+ *  Author: Dmitry Melnichansky / 4Z7DTF
+ *
+ *  Boot time configuration of the u-blox receiver, built with
+ *  VX8_GPS_CONFIG. The GPS RX input has to be connected to the TXD pin
+ *  together with the VX-8 input. VX-8 ignores the UBX commands sent at
+ *  boot, and the GPS is set to ignore the NMEA sentences sent to VX-8.
+ */
+
+#ifndef GPS_CONFIG_H_
+#define GPS_CONFIG_H_
+
+#include <stdint.h>
+#include "../src/gps_fix.h"
+
+/* Navigation rate set by CFG-RATE. */
+#ifndef GPS_RATE_HZ
+#define GPS_RATE_HZ 1
+#endif
+
+/* Results of gps_config(). */
+enum gps_config_results
+{
+	GPS_CONFIG_OK, /* All the commands were acknowledged. */
+	GPS_CONFIG_NO_GPS, /* No UBX response at any of the baud rates. */
+	GPS_CONFIG_NAK, /* A command was rejected or not acknowledged. */
+	GPS_CONFIG_BAUD, /* No response after the baud rate change. */
+};
+
+uint8_t gps_config(uint32_t baud, const struct gps_fix *aid);
+
+#endif /* GPS_CONFIG_H_ */
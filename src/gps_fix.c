@@ -0,0 +1,313 @@
+/*
+ * gps_fix.c
+ *
+ *  Created on: 16 Oct 2026
+ *  Author: Dmitry Melnichansky / 4Z7DTF
+ *
+ *  Reads the fix from the fields of the sentences as the transform writes
+ *  them to the VX-8 frame, so the sentence isn't parsed a second time. GGA
+ *  gives the time, position and fix quality, RMC the date and motion and
+ *  ZDA the date. The fix is updated sentence by sentence, so the date of
+ *  a GGA sentence is the one of the RMC or ZDA before it.
+ */
+
+#include "../src/gps_fix.h"
+#include "../src/progmem.h"
+#include "../src/sentences.h"
+
+#define DOT '.'
+
+#define DEG_SCALE 10000000L /* Angles of gps_fix are in 1e-7 degrees. */
+
+/* Days before the first day of each month in a common year. */
+static const uint16_t month_days[] PROGMEM = { 0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334 };
+
+/* Fields a sentence needs to update the fix, including the type: up to
+ * the geoid separation of GGA, the date of RMC and the year of ZDA. */
+static const uint8_t min_fields[SENTENCE_COUNT] PROGMEM = { 12, 10, 5 };
+
+static uint8_t two_digits(const char *);
+static int32_t number(const char *, uint8_t, uint8_t);
+static int32_t angle(const char *, uint8_t);
+static int32_t hemisphere(int32_t, const char *, uint8_t);
+static void quality(struct gps_fix *, char);
+static void parse_time(struct gps_fix *, const char *, uint8_t);
+
+/*
+ * Function: gps_fix_field
+ * -----------------------
+ *   Updates the fix from one field of a sentence, as the transform writes
+ *   it to the VX-8 frame. Only the milliseconds of itow are known from the
+ *   sentences, they are kept for render.c. The fields are collected in a
+ *   copy of the fix, which is taken only if the sentence ends well.
+ *
+ *   fix: the copy of the fix to update
+ *   type: the sentence type, index in sentences[]
+ *   field: the field number, 1 for the field after the type
+ *   p: the field
+ *   len: length of the field
+ *
+ *   returns:	none
+ */
+void gps_fix_field(struct gps_fix *fix, uint8_t type, uint8_t field, const char *p, uint8_t len)
+{
+	switch (type)
+	{
+	case SENTENCE_GGA:
+		switch (field)
+		{
+		case 1:
+			parse_time(fix, p, len);
+			break;
+		case 2:
+			fix->lat = angle(p, len);
+			break;
+		case 3:
+			fix->lat = hemisphere(fix->lat, p, len);
+			break;
+		case 4:
+			fix->lon = angle(p, len);
+			break;
+		case 5:
+			fix->lon = hemisphere(fix->lon, p, len);
+			break;
+		case 6:
+			quality(fix, len ? *p : 0);
+			break;
+		case 7:
+			fix->num_sv = (uint8_t) number(p, len, 0);
+			break;
+		case 8:
+			fix->hdop = (uint16_t) number(p, len, 2);
+			break;
+		case 9:
+			fix->hmsl = number(p, len, 3);
+			break;
+		case 11:
+			fix->height = fix->hmsl + number(p, len, 3);
+			break;
+		}
+		break;
+	case SENTENCE_RMC:
+		switch (field)
+		{
+		case 1:
+			parse_time(fix, p, len);
+			break;
+		case 3:
+			fix->lat = angle(p, len);
+			break;
+		case 4:
+			fix->lat = hemisphere(fix->lat, p, len);
+			break;
+		case 5:
+			fix->lon = angle(p, len);
+			break;
+		case 6:
+			fix->lon = hemisphere(fix->lon, p, len);
+			break;
+		case 7:
+			/* 0.01 knots to cm/s */
+			fix->gspeed = ((uint32_t) number(p, len, 2) * 1852 + 1800) / 3600;
+			break;
+		case 8:
+			/* 0.01 to 1e-5 degrees */
+			fix->heading = number(p, len, 2) * 1000;
+			break;
+		case 9:
+			if (len >= 6)
+			{
+				fix->day = two_digits(p);
+				fix->month = two_digits(p + 2);
+				fix->year = 2000 + two_digits(p + 4);
+			}
+			break;
+		}
+		break;
+	case SENTENCE_ZDA:
+		switch (field)
+		{
+		case 1:
+			parse_time(fix, p, len);
+			break;
+		case 2:
+			fix->day = (uint8_t) number(p, len, 0);
+			break;
+		case 3:
+			fix->month = (uint8_t) number(p, len, 0);
+			break;
+		case 4:
+			fix->year = (uint16_t) number(p, len, 0);
+			break;
+		}
+		break;
+	}
+}
+
+/*
+ * Function: gps_fix_end
+ * ---------------------
+ *   Checks that a complete sentence had all the fields the fix is read
+ *   from. time_valid is set once the date is known.
+ *
+ *   fix: the copy of the fix updated by gps_fix_field()
+ *   type: the sentence type, index in sentences[]
+ *   fields: number of fields including the type
+ *
+ *   returns:	1 if the copy can be taken as the fix, 0 otherwise.
+ */
+uint8_t gps_fix_end(struct gps_fix *fix, uint8_t type, uint8_t fields)
+{
+	if (type >= SENTENCE_COUNT || fields < pgm_read_byte(&min_fields[type]))
+	{
+		return 0;
+	}
+	if (fix->year)
+	{
+		fix->time_valid |= GPS_TIME_VALID_UTC;
+	}
+	return 1;
+}
+
+/*
+ * Function: gps_fix_days
+ * ----------------------
+ *   returns:	days since 2000-01-01, good until 2099.
+ */
+uint16_t gps_fix_days(uint16_t year, uint8_t month, uint8_t day)
+{
+	uint16_t y = year - 2000;
+	uint16_t days = y * 365 + (y + 3) / 4 + pgm_read_word(&month_days[month - 1]) + day - 1;
+
+	if (month > 2 && (y & 3) == 0)
+	{
+		days++;
+	}
+	return days;
+}
+
+static uint8_t two_digits(const char *p)
+{
+	return (uint8_t) ((p[0] - '0') * 10 + (p[1] - '0'));
+}
+
+/*
+ * Function: number
+ * ----------------
+ *   Reads a decimal number. Fractional digits beyond frac_len are
+ *   truncated.
+ *
+ *   len: length of the number
+ *   frac_len: number of fractional digits of the result
+ *
+ *   returns:	the number multiplied by 10^frac_len.
+ */
+static int32_t number(const char *p, uint8_t len, uint8_t frac_len)
+{
+	const char *end = p + len;
+	int32_t value = 0;
+	uint8_t negative = 0;
+	uint8_t frac = 0;
+	uint8_t dot = 0;
+
+	if (len && *p == '-')
+	{
+		negative = 1;
+		p++;
+	}
+	for (; p < end; p++)
+	{
+		if (*p == DOT)
+		{
+			dot = 1;
+		}
+		else if (!dot || frac++ < frac_len)
+		{
+			value = value * 10 + (*p - '0');
+		}
+	}
+	for (; frac < frac_len; frac++)
+	{
+		value *= 10;
+	}
+	return negative ? -value : value;
+}
+
+/*
+ * Function: angle
+ * ---------------
+ *   Reads latitude or longitude in degrees and minutes with 4 decimals.
+ *   The degrees are rounded up to 1e-7 so that render.c, which truncates,
+ *   writes the same minutes again.
+ *
+ *   returns:	the angle in 1e-7 degrees, north or east.
+ */
+static int32_t angle(const char *p, uint8_t len)
+{
+	uint32_t v = (uint32_t) number(p, len, 4);
+	uint32_t deg = v / 1000000UL;
+	uint32_t min = v - deg * 1000000UL; /* 1e-4 minutes */
+
+	return (int32_t) (deg * DEG_SCALE + (min * 100 + 5) / 6);
+}
+
+/*
+ * Function: hemisphere
+ * --------------------
+ *   Applies the N, S, E or W field following an angle.
+ *
+ *   value: the angle read by angle()
+ *
+ *   returns:	the angle, negative for S and W.
+ */
+static int32_t hemisphere(int32_t value, const char *p, uint8_t len)
+{
+	return len && (*p == 'S' || *p == 'W') ? -value : value;
+}
+
+/*
+ * Function: quality
+ * -----------------
+ *   Sets the fix type and flags from the GGA fix quality.
+ *
+ *   q: the fix quality digit, 0 if the field is empty
+ *
+ *   returns:	none
+ */
+static void quality(struct gps_fix *fix, char q)
+{
+	switch (q)
+	{
+	case '0':
+		fix->fix_type = GPS_FIX_NONE;
+		fix->fix_flags = 0;
+		break;
+	case '2':
+		fix->fix_type = GPS_FIX_3D;
+		fix->fix_flags = GPS_FIX_OK | GPS_FIX_DIFF;
+		break;
+	case '6':
+		fix->fix_type = GPS_FIX_3D;
+		fix->fix_flags = GPS_FIX_OK | GPS_FIX_LAST_KNOWN;
+		break;
+	default:
+		fix->fix_type = GPS_FIX_3D;
+		fix->fix_flags = GPS_FIX_OK;
+		break;
+	}
+}
+
+/*
+ * Function: parse_time
+ * --------------------
+ *   Reads UTC time hhmmss.sss, as the transform writes the time field.
+ *
+ *   returns:	none
+ */
+static void parse_time(struct gps_fix *fix, const char *p, uint8_t len)
+{
+	fix->hour = two_digits(p);
+	fix->min = two_digits(p + 2);
+	fix->sec = two_digits(p + 4);
+	fix->itow = (uint32_t) number(p + 6, len - 6, 3);
+}
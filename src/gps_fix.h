@@ -0,0 +1,67 @@
+/*
+ * gps_fix.h
+ *
+ *  Created on: 16 Oct 2026
+ *  Author: Dmitry Melnichansky / 4Z7DTF
+ *
+ *  Navigation solution of one GPS epoch in binary form, as reported by
+ *  u-blox UBX NAV messages. Filled by ubx.c, or from the fields of the
+ *  VX-8 sentences by gps_fix_field() while vx8_core.c converts them, and
+ *  rendered to VX-8 and NMEA sentences by render.c.
+ */
+
+#ifndef GPS_FIX_H_
+#define GPS_FIX_H_
+
+#include <stdint.h>
+
+/* gps_fix.fix_type values (gpsFix of NAV-SOL). */
+#define GPS_FIX_NONE 0x00
+#define GPS_FIX_2D 0x02
+#define GPS_FIX_3D 0x03
+
+/* gps_fix.fix_flags bits (flags of NAV-SOL). */
+#define GPS_FIX_OK 0x01 /* Fix within the receiver limits. */
+#define GPS_FIX_DIFF 0x02 /* Differential corrections applied. */
+#define GPS_FIX_LAST_KNOWN 0x80 /* Not from NAV-SOL: position saved before power-off. */
+
+/* gps_fix.time_valid bits (valid of NAV-TIMEUTC). */
+#define GPS_TIME_VALID_UTC 0x04
+
+struct gps_fix
+{
+	uint32_t itow; /* GPS time of week of the epoch, ms. */
+	int32_t lat; /* Latitude, 1e-7 degrees. */
+	int32_t lon; /* Longitude, 1e-7 degrees. */
+	int32_t height; /* Height above ellipsoid, mm. */
+	int32_t hmsl; /* Height above mean sea level, mm. */
+	uint32_t gspeed; /* Ground speed, cm/s. */
+	int32_t heading; /* Heading of motion, 1e-5 degrees. */
+	uint16_t hdop; /* Horizontal DOP, 0.01. */
+	uint16_t year;
+	uint8_t month;
+	uint8_t day;
+	uint8_t hour;
+	uint8_t min;
+	uint8_t sec;
+	uint8_t time_valid;
+	uint8_t fix_type;
+	uint8_t fix_flags;
+	uint8_t num_sv; /* Satellites used in the solution. */
+};
+
+void gps_fix_field(struct gps_fix *fix, uint8_t type, uint8_t field, const char *p, uint8_t len);
+uint8_t gps_fix_end(struct gps_fix *fix, uint8_t type, uint8_t fields);
+uint16_t gps_fix_days(uint16_t year, uint8_t month, uint8_t day);
+
+/*
+ * Function: gps_fix_ok
+ * --------------------
+ *   returns:	1 if the position is a valid 2D or 3D fix, 0 otherwise.
+ */
+static inline uint8_t gps_fix_ok(const struct gps_fix *fix)
+{
+	return (fix->fix_flags & GPS_FIX_OK) && (fix->fix_type == GPS_FIX_2D || fix->fix_type == GPS_FIX_3D);
+}
+
+#endif /* GPS_FIX_H_ */
@@ -0,0 +1,233 @@
+/*
+ * last_fix.c
+ *
+ *  Created on: 16 Oct 2026
+ *  Author: Dmitry Melnichansky / 4Z7DTF
+ *
+ *  The records are written to the slots in turn, each with a sequence
+ *  number and a checksum, so a slot is rewritten only every
+ *  LAST_FIX_SLOTS saves. At most one save is made per LAST_FIX_PERIOD_MIN
+ *  minutes of GPS time, which keeps the 100000 write cycles of the EEPROM
+ *  for decades. The newest valid record is found at boot. A record torn
+ *  by power loss fails its checksum and the one before it is used.
+ *  One byte is written per call of last_fix_poll() when the EEPROM is
+ *  ready, so the main loop isn't blocked for the 3.4ms of a byte write.
+ *  EE_READY_vect wakes the MCU for the next byte.
+ */
+
+#ifdef VX8_LAST_FIX
+
+#include <stddef.h>
+#include <string.h>
+#include <avr/eeprom.h>
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#include "../src/last_fix.h"
+
+#define NO_SLOT 0xFF
+#define CHECKSUM_SEED 0x4C /* Zeroed and erased records don't pass. */
+
+struct last_fix_record
+{
+	uint16_t seq; /* Incremented by every save. */
+	int32_t lat; /* 1e-7 degrees */
+	int32_t lon; /* 1e-7 degrees */
+	int32_t height; /* Height above ellipsoid, mm. */
+	int32_t hmsl; /* Height above mean sea level, mm. */
+	uint16_t year;
+	uint8_t month;
+	uint8_t day;
+	uint8_t hour;
+	uint8_t min;
+	uint8_t sec;
+	uint8_t ck_a;
+	uint8_t ck_b;
+};
+
+static struct last_fix_record slots[LAST_FIX_SLOTS] EEMEM;
+
+static struct last_fix_record record; /* Newest record, being written if write_pos < sizeof(record). */
+static uint8_t slot; /* Slot of the newest record, NO_SLOT if none. */
+static uint8_t write_pos; /* Next byte of record to write. */
+static uint32_t saved_minute; /* GPS time of the newest record. */
+
+static uint8_t checksum(struct last_fix_record *, uint8_t);
+static uint32_t minutes(uint16_t, uint8_t, uint8_t, uint8_t, uint8_t);
+
+/*
+ * Function: last_fix_init
+ * -----------------------
+ *   Finds the newest valid record in EEPROM.
+ *
+ *   returns:	none
+ */
+void last_fix_init(void)
+{
+	struct last_fix_record r;
+
+	slot = NO_SLOT;
+	write_pos = sizeof(record);
+	for (uint8_t i = 0; i < LAST_FIX_SLOTS; i++)
+	{
+		eeprom_read_block(&r, &slots[i], sizeof(r));
+		if (!checksum(&r, 0) || r.month < 1 || r.month > 12)
+		{
+			continue;
+		}
+		if (slot == NO_SLOT || (int16_t) (r.seq - record.seq) > 0)
+		{
+			record = r;
+			slot = i;
+		}
+	}
+	if (slot != NO_SLOT)
+	{
+		saved_minute = minutes(record.year, record.month, record.day, record.hour, record.min);
+	}
+}
+
+/*
+ * Function: last_fix_get
+ * ----------------------
+ *   Fills the fix with the saved position and time, flagged with
+ *   GPS_FIX_LAST_KNOWN. Speed, heading, DOP and satellites are zero.
+ *
+ *   returns:	1 if there is a saved position, 0 otherwise.
+ */
+uint8_t last_fix_get(struct gps_fix *fix)
+{
+	if (slot == NO_SLOT)
+	{
+		return 0;
+	}
+	memset(fix, 0, sizeof(*fix));
+	fix->lat = record.lat;
+	fix->lon = record.lon;
+	fix->height = record.height;
+	fix->hmsl = record.hmsl;
+	fix->year = record.year;
+	fix->month = record.month;
+	fix->day = record.day;
+	fix->hour = record.hour;
+	fix->min = record.min;
+	fix->sec = record.sec;
+	fix->time_valid = GPS_TIME_VALID_UTC;
+	fix->fix_type = GPS_FIX_3D;
+	fix->fix_flags = GPS_FIX_OK | GPS_FIX_LAST_KNOWN;
+	return 1;
+}
+
+/*
+ * Function: last_fix_update
+ * -------------------------
+ *   Starts saving the fix to the next slot if it is a valid fix with UTC
+ *   date and time and the last save is LAST_FIX_PERIOD_MIN old. The first
+ *   valid fix is saved if there is no record.
+ *
+ *   returns:	none
+ */
+void last_fix_update(const struct gps_fix *fix)
+{
+	uint32_t now;
+
+	if (write_pos < sizeof(record) || !gps_fix_ok(fix) || (fix->fix_flags & GPS_FIX_LAST_KNOWN)
+			|| !(fix->time_valid & GPS_TIME_VALID_UTC) || fix->year < 2000 || fix->month < 1
+			|| fix->month > 12)
+	{
+		return;
+	}
+	now = minutes(fix->year, fix->month, fix->day, fix->hour, fix->min);
+	/* A clock going backwards saves too. */
+	if (slot != NO_SLOT && now - saved_minute < LAST_FIX_PERIOD_MIN)
+	{
+		return;
+	}
+	record.seq = slot == NO_SLOT ? 0 : record.seq + 1;
+	record.lat = fix->lat;
+	record.lon = fix->lon;
+	record.height = fix->height;
+	record.hmsl = fix->hmsl;
+	record.year = fix->year;
+	record.month = fix->month;
+	record.day = fix->day;
+	record.hour = fix->hour;
+	record.min = fix->min;
+	record.sec = fix->sec;
+	checksum(&record, 1);
+	slot = slot == NO_SLOT || slot == LAST_FIX_SLOTS - 1 ? 0 : slot + 1;
+	saved_minute = now;
+	write_pos = 0;
+}
+
+/*
+ * Function: last_fix_poll
+ * -----------------------
+ *   Writes the next byte of a record being saved if the EEPROM is ready.
+ *   The checksum is written last.
+ *
+ *   returns:	none
+ */
+void last_fix_poll(void)
+{
+	if (write_pos >= sizeof(record) || !eeprom_is_ready())
+	{
+		return;
+	}
+	eeprom_update_byte((uint8_t *) &slots[slot] + write_pos, ((const uint8_t *) &record)[write_pos]);
+	if (++write_pos < sizeof(record))
+	{
+		EECR |= (1 << EERIE);
+	}
+}
+
+/*
+ * Function: ISR(EE_READY_vect)
+ * ----------------------------
+ *   Wakes the main loop when the EEPROM is ready for the next byte.
+ *
+ *   returns:	none
+ */
+ISR(EE_READY_vect)
+{
+	EECR &= ~(1 << EERIE);
+}
+
+/*
+ * Function: checksum
+ * ------------------
+ *   Fletcher checksum of the record, like the one of UBX.
+ *
+ *   set: 1 to store the checksum in the record, 0 to check it
+ *
+ *   returns:	1 if the stored checksum matches.
+ */
+static uint8_t checksum(struct last_fix_record *r, uint8_t set)
+{
+	const uint8_t *p = (const uint8_t *) r;
+	uint8_t ck_a = CHECKSUM_SEED;
+	uint8_t ck_b = 0;
+
+	for (uint8_t i = 0; i < offsetof(struct last_fix_record, ck_a); i++)
+	{
+		ck_a += p[i];
+		ck_b += ck_a;
+	}
+	if (set)
+	{
+		r->ck_a = ck_a;
+		r->ck_b = ck_b;
+	}
+	return r->ck_a == ck_a && r->ck_b == ck_b;
+}
+
+/*
+ * Function: minutes
+ * -----------------
+ *   returns:	minutes since 2000-01-01 00:00, good until 2099.
+ */
+static uint32_t minutes(uint16_t year, uint8_t month, uint8_t day, uint8_t hour, uint8_t min)
+{
+	return gps_fix_days(year, month, day) * 1440UL + hour * 60 + min;
+}
+
+#endif /* VX8_LAST_FIX */
@@ -0,0 +1,32 @@
+/*
+ * last_fix.h
+ *
+ *  Created on: 16 Oct 2026
+ *  Author: Dmitry Melnichansky / 4Z7DTF
+ *
+ *  Last valid position and time kept in EEPROM, built with VX8_LAST_FIX.
+ *  It is sent to the GPS as UBX-AID-INI at boot to shorten the time to
+ *  first fix and, with VX8_LAST_FIX_OUTPUT, to VX-8 as a flagged
+ *  last-known position before the GPS has a fix.
+ */
+
+#ifndef LAST_FIX_H_
+#define LAST_FIX_H_
+
+#include <stdint.h>
+#include "../src/gps_fix.h"
+
+/* Smallest interval between two saves, minutes of GPS time. */
+#ifndef LAST_FIX_PERIOD_MIN
+#define LAST_FIX_PERIOD_MIN 10
+#endif
+
+/* Number of records the writes are spread over. */
+#define LAST_FIX_SLOTS 16
+
+void last_fix_init(void);
+uint8_t last_fix_get(struct gps_fix *fix);
+void last_fix_update(const struct gps_fix *fix);
+void last_fix_poll(void);
+
+#endif /* LAST_FIX_H_ */
@@ -0,0 +1,164 @@
+/*
+ * pps.c
+ *
+ *  Created on: 16 Oct 2026
+ *  Author: Dmitry Melnichansky / 4Z7DTF
+ *
+ *  The rising edge of the time pulse is captured by the Timer1 input
+ *  capture unit with the noise canceller on, so its time doesn't depend on
+ *  interrupt latency. Compare unit B then wakes the MCU at the phase, and
+ *  again at the start time of the output set by the main loop. The phase
+ *  is longer than the 16 bit counter period at most clock rates, so
+ *  TIMER1_COMPB_vect runs once per counter period until the 32 bit clock
+ *  reaches it.
+ */
+
+#ifdef VX8_PPS
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#include "../src/pps.h"
+#include "../src/timer1.h"
+
+#define PHASE_TICKS ((uint32_t) PPS_PHASE_MS * TIMER1_TICKS_PER_MS)
+
+struct pps pps;
+
+static uint32_t due; /* Timer1 time compare unit B waits for. */
+static uint8_t starting; /* due is the start time, not the phase. */
+
+static void reached(void);
+
+/*
+ * Function: pps_init
+ * ------------------
+ *   Sets up ICP1 for the rising edge and enables the capture interrupt.
+ *   The Timer1 clock is started by the caller with timer1_clock_init().
+ *
+ *   returns:	none
+ */
+void pps_init(void)
+{
+	DDRB &= ~(1 << PPS_PIN);
+	pps.hold = 0;
+	pps.release = 0;
+	pps.start = 0;
+	pps.released = 0;
+	pps.edges = 0;
+	pps.late = 0;
+	TCCR1B |= (1 << ICNC1) | (1 << ICES1);
+	TIFR1 = (1 << ICF1);
+	TIMSK1 |= (1 << ICIE1);
+}
+
+/*
+ * Function: pps_elapsed_ms
+ * ------------------------
+ *   returns:	milliseconds since the last pulse.
+ */
+uint16_t pps_elapsed_ms(void)
+{
+	uint32_t edge;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		edge = pps.edge;
+	}
+	return (uint16_t) ((timer1_now() - edge) / TIMER1_TICKS_PER_MS);
+}
+
+/*
+ * Function: pps_start_at
+ * ----------------------
+ *   Sets compare unit B for the start of the output, ms milliseconds after
+ *   the last pulse. The output stays held until then. If the time has
+ *   passed already the compare wouldn't match for a counter period, so
+ *   the output is started at once.
+ *
+ *   ms: time from the pulse
+ *
+ *   returns:	none
+ */
+void pps_start_at(uint16_t ms)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		due = pps.edge + (uint32_t) ms * TIMER1_TICKS_PER_MS;
+		starting = 1;
+		OCR1B = (uint16_t) due;
+		TIFR1 = (1 << OCF1B);
+		TIMSK1 |= (1 << OCIE1B);
+		if ((int32_t) (timer1_extend(TCNT1) - due) >= 0)
+		{
+			reached();
+		}
+	}
+}
+
+/*
+ * Function: ISR(TIMER1_CAPT_vect)
+ * -------------------------------
+ *   Records the time of the pulse, holds the output and sets compare unit
+ *   B for the phase. The noise canceller delays the capture by 4 clock
+ *   cycles, which is less than a timer tick.
+ *
+ *   returns:	none
+ */
+ISR(TIMER1_CAPT_vect)
+{
+	uint32_t edge = timer1_extend(ICR1);
+
+	pps.edge = edge;
+	pps.edges++;
+	pps.hold = 1;
+	pps.release = 0;
+	pps.start = 0;
+	pps.released = 0;
+	due = edge + PHASE_TICKS;
+	starting = 0;
+	OCR1B = (uint16_t) due;
+	TIFR1 = (1 << OCF1B);
+	TIMSK1 |= (1 << OCIE1B);
+}
+
+/*
+ * Function: ISR(TIMER1_COMPB_vect)
+ * --------------------------------
+ *   Waits for the 32 bit clock to reach the compare time.
+ *
+ *   returns:	none
+ */
+ISR(TIMER1_COMPB_vect)
+{
+	if ((int32_t) (timer1_extend(OCR1B) - due) < 0)
+	{
+		return;
+	}
+	reached();
+}
+
+/*
+ * Function: reached
+ * -----------------
+ *   At the phase the main loop sets the time fields of the held frames.
+ *   At the start time the output is no longer held and the main loop
+ *   starts TX. Called with interrupts disabled.
+ *
+ *   returns:	none
+ */
+static void reached(void)
+{
+	TIMSK1 &= ~(1 << OCIE1B);
+	if (starting)
+	{
+		pps.hold = 0;
+		pps.start = 1;
+	}
+	else
+	{
+		pps.release = 1;
+	}
+}
+
+#endif /* VX8_PPS */
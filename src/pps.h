@@ -0,0 +1,50 @@
+/*
+ * pps.h
+ *
+ *  Created on: 16 Oct 2026
+ *  Author: Dmitry Melnichansky / 4Z7DTF
+ *
+ *  GPS time pulse input, built with VX8_PPS. The TIMEPULSE output of the
+ *  NEO-6M is connected to ICP1 and marks the start of every UTC second.
+ *  The sentences of an epoch are held until PPS_PHASE_MS after the pulse
+ *  and then sent back to back, so that the millisecond digits of their
+ *  time fields can be set to the time their last byte is sent. The start
+ *  of the output is timed by compare unit B as well, so the main loop
+ *  sleeps until then.
+ */
+
+#ifndef PPS_H_
+#define PPS_H_
+
+#include <stdint.h>
+
+/* Time from the pulse to the start of output. Must be later than the end
+ * of the last sentence of the epoch received from the GPS.
+ */
+#ifndef PPS_PHASE_MS
+#define PPS_PHASE_MS 600
+#endif
+#if defined(GPS_RATE_HZ) && GPS_RATE_HZ != 1
+#error "VX8_PPS aligns the output to the second, GPS_RATE_HZ must be 1"
+#endif
+
+#define PPS_PIN PB0 /* ICP1, Arduino pin 8. */
+
+struct pps
+{
+	volatile uint32_t edge; /* Timer1 time of the last pulse. */
+	volatile uint8_t hold; /* Output is held until the start time. */
+	volatile uint8_t release; /* The phase was reached, the held frames are waiting. */
+	volatile uint8_t start; /* The start time was reached, TX can start. */
+	uint8_t released; /* Output of this epoch started. */
+	uint16_t edges; /* Pulses received. */
+	uint16_t late; /* Frames queued after the output of their epoch started. */
+};
+
+extern struct pps pps;
+
+void pps_init(void);
+uint16_t pps_elapsed_ms(void);
+void pps_start_at(uint16_t ms);
+
+#endif /* PPS_H_ */
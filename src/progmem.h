@@ -0,0 +1,27 @@
+/*
+ * progmem.h
+ *
+ *  Created on: 16 Oct 2026
+ *  Author: Dmitry Melnichansky / 4Z7DTF
+ *
+ *  Program memory access. Tables are kept in flash on AVR. On other
+ *  targets they are ordinary constant data.
+ */
+
+#ifndef PROGMEM_H_
+#define PROGMEM_H_
+
+#ifdef __AVR__
+#include <avr/pgmspace.h>
+#else
+#include <stdint.h>
+#include <string.h>
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const uint8_t *) (addr))
+#define pgm_read_word(addr) (*(const uint16_t *) (addr))
+#define pgm_read_dword(addr) (*(const uint32_t *) (addr))
+#define pgm_read_ptr(addr) (*(const void * const *) (addr))
+#define memcpy_P(dest, src, n) memcpy((dest), (src), (n))
+#endif
+
+#endif /* PROGMEM_H_ */
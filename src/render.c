@@ -0,0 +1,849 @@
+/*
+ * render.c
+ *
+ *  Created on: 16 Oct 2026
+ *  Author: Dmitry Melnichansky / 4Z7DTF
+ *
+ *  Numbers are written digit by digit by subtracting powers of ten, which
+ *  is cheaper on AVR than a 32 bit division per digit. Position, altitude,
+ *  speed and course are zero when there is no fix, like the fields of an
+ *  NMEA sentence without fix after the transform. A position saved before
+ *  power-off (GPS_FIX_LAST_KNOWN) is flagged as estimated: quality 6 in
+ *  GGA, status V and mode E in RMC.
+ *  The standard NMEA dialect shares the field order and only differs in
+ *  how numbers and missing values are written, so each sentence has one
+ *  writer which takes the dialect.
+ *  A template of render_cached() is a complete VX-8 sentence. Changed
+ *  fields are written over it at their fixed positions and the checksum
+ *  is updated by XORing out the old characters and XORing in the new ones,
+ *  so a no-fix epoch costs the time field and two hex digits, and a
+ *  stationary fix adds little more than its position digits. The template
+ *  is copied to the output frame, it stays the same when the frame is
+ *  changed later, e.g. by render_set_ms().
+ */
+
+#include <string.h>
+#include "../src/render.h"
+#include "../src/progmem.h"
+
+#define COMMA ','
+#define DOT '.'
+#define DOLLAR '$'
+#define ASTERISK '*'
+#define CR 0x0D
+#define LF 0x0A
+
+#define DEG_SCALE 10000000UL /* Angles of gps_fix are in 1e-7 degrees. */
+#define TIME_POS 7 /* Time field after $GPxxx, */
+#define TIME_MS_POS (TIME_POS + 7) /* Milliseconds of the time field: hhmmss.sss */
+#define TIME_LEN 10
+/* Field positions of the VX-8 dialect, each after the one before it. */
+#define GGA_LAT (TIME_POS + 11) /* hhmmss.sss, */
+#define GGA_LON (GGA_LAT + 12) /* ddmm.mmmm,N, */
+#define GGA_QUALITY (GGA_LON + 13) /* dddmm.mmmm,E, */
+#define GGA_SATS (GGA_QUALITY + 2) /* q, */
+#define GGA_HDOP (GGA_SATS + 3) /* nn, */
+#define GGA_ALT (GGA_HDOP + 5) /* hh.h, */
+#define GGA_GEOID (GGA_ALT + 10) /* aaaaa.a,M, */
+#define RMC_STATUS (TIME_POS + 11)
+#define RMC_LAT (RMC_STATUS + 2) /* A, */
+#define RMC_LON (RMC_LAT + 12)
+#define RMC_SPEED (RMC_LON + 13)
+#define RMC_COURSE (RMC_SPEED + 8) /* ssss.ss, */
+#define RMC_DATE (RMC_COURSE + 7) /* ddd.dd, */
+#define RMC_MODE (RMC_DATE + 9) /* ddmmyy,,, */
+#define ZDA_DAY (TIME_POS + 11)
+#define ZDA_MONTH (ZDA_DAY + 3) /* dd, */
+#define ZDA_YEAR (ZDA_MONTH + 3) /* mm, */
+#define LAT_LEN 11
+#define LON_LEN 12
+#define TRAILER_LEN 5 /* *hh CR LF */
+#define MAX_MS 999
+
+static const uint32_t powers_of_ten[] PROGMEM = {
+	1UL, 10UL, 100UL, 1000UL, 10000UL, 100000UL, 1000000UL, 10000000UL, 100000000UL, 1000000000UL
+};
+
+/* Lookup table for converting numerical values to hexadecimal digits. */
+static const char hex_chars[16] = { '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F' };
+
+static char *put_header(char *, uint8_t);
+static char *put_number(char *, int32_t, uint8_t, uint8_t);
+static char *put_value(char *, int32_t, uint8_t, uint8_t, uint8_t);
+static char *put_time(char *, const struct gps_fix *, uint8_t);
+static char *put_angle(char *, int32_t, uint8_t, char, char);
+static char *put_position(char *, const struct gps_fix *, uint8_t);
+static char *put_gga(char *, const struct gps_fix *, uint8_t);
+static char *put_rmc(char *, const struct gps_fix *, uint8_t);
+static char *put_zda(char *, const struct gps_fix *, uint8_t);
+static char quality(const struct gps_fix *, char, char, char, char);
+static uint32_t speed_of(const struct gps_fix *);
+static uint16_t course_of(const struct gps_fix *);
+static void get_state(const struct gps_fix *, struct render_state *);
+static void patch_time(struct render_template *, const struct render_state *);
+static void patch_position(struct render_template *, const struct render_state *, uint8_t);
+static void patch_gga(struct render_template *, const struct render_state *);
+static void patch_rmc(struct render_template *, const struct gps_fix *, const struct render_state *);
+static void patch_zda(struct render_template *, const struct render_state *);
+static void toggle(struct render_template *, uint8_t, uint8_t);
+
+/*
+ * Function: render_sentence
+ * -------------------------
+ *   Writes a complete sentence with checksum and CR LF to the frame.
+ *   Nothing is written without valid UTC time, like sentences with empty
+ *   time are discarded by the transform.
+ *
+ *   fix: the fix
+ *   sentence: index of the sentence in sentences[]
+ *   dialect: RENDER_VX8 or RENDER_NMEA
+ *   frame: where to write the sentence
+ *
+ *   returns:	1 if the sentence was written, 0 otherwise.
+ */
+uint8_t render_sentence(const struct gps_fix *fix, uint8_t sentence, uint8_t dialect, struct vx8_frame *frame)
+{
+	char *p;
+
+	if (!(fix->time_valid & GPS_TIME_VALID_UTC))
+	{
+		return 0;
+	}
+	p = put_header(frame->buffer, sentence);
+	switch (sentence)
+	{
+	case SENTENCE_GGA:
+		p = put_gga(p, fix, dialect);
+		break;
+	case SENTENCE_RMC:
+		p = put_rmc(p, fix, dialect);
+		break;
+	case SENTENCE_ZDA:
+		p = put_zda(p, fix, dialect);
+		break;
+	default:
+		return 0;
+	}
+	render_finish(frame, p);
+	frame->type = sentence;
+	return 1;
+}
+
+/*
+ * Function: render_cache_init
+ * ---------------------------
+ *   Empties the cache, the next sentence of every type is rendered in
+ *   full.
+ *
+ *   returns:	none
+ */
+void render_cache_init(struct render_cache *cache)
+{
+	cache->have_state = 0;
+	for (uint8_t i = 0; i < SENTENCE_COUNT; i++)
+	{
+		cache->templates[i].valid = 0;
+	}
+}
+
+/*
+ * Function: render_cached
+ * -----------------------
+ *   Writes the same VX-8 sentence as render_sentence() does. The first
+ *   sentence of a type is rendered in full into its template, later ones
+ *   only rewrite the fields which changed. The fix is converted to field
+ *   values once for all the sentences of an epoch.
+ *
+ *   cache: templates of the sentences
+ *   fix: the fix
+ *   sentence: index of the sentence in sentences[]
+ *   frame: where to write the sentence
+ *
+ *   returns:	1 if the sentence was written, 0 otherwise.
+ */
+uint8_t render_cached(struct render_cache *cache, const struct gps_fix *fix, uint8_t sentence,
+		struct vx8_frame *frame)
+{
+	struct render_template *t;
+	const struct render_state *state = &cache->state;
+	char *p;
+
+	if (sentence >= SENTENCE_COUNT || !(fix->time_valid & GPS_TIME_VALID_UTC))
+	{
+		return 0;
+	}
+	t = &cache->templates[sentence];
+	if (!cache->have_state || memcmp(fix, &cache->fix, sizeof(*fix)) != 0)
+	{
+		cache->fix = *fix;
+		get_state(fix, &cache->state);
+		cache->have_state = 1;
+	}
+	if (!t->valid)
+	{
+		if (!render_sentence(fix, sentence, RENDER_VX8, &t->frame))
+		{
+			return 0;
+		}
+		t->checksum = 0;
+		toggle(t, 1, t->frame.len - TRAILER_LEN - 1);
+		t->valid = 1;
+	}
+	else
+	{
+		patch_time(t, state);
+		switch (sentence)
+		{
+		case SENTENCE_GGA:
+			patch_gga(t, state);
+			break;
+		case SENTENCE_RMC:
+			patch_rmc(t, fix, state);
+			break;
+		case SENTENCE_ZDA:
+			patch_zda(t, state);
+			break;
+		}
+		p = t->frame.buffer + t->frame.len - TRAILER_LEN + 1;
+		*p++ = hex_chars[(t->checksum & 0xF0) >> 4];
+		*p = hex_chars[t->checksum & 0x0F];
+	}
+	t->state = *state;
+	memcpy(frame, &t->frame, sizeof(*frame));
+	return 1;
+}
+
+/*
+ * Function: render_leds
+ * ---------------------
+ *   returns:	VX8_LED_* events of the GGA and RMC sentences of the fix.
+ */
+uint8_t render_leds(const struct gps_fix *fix)
+{
+	if (gps_fix_ok(fix))
+	{
+		return VX8_LED_GGA_GREEN | VX8_LED_RMC_GREEN;
+	}
+	return VX8_LED_GGA_RED | VX8_LED_RMC_RED;
+}
+
+/*
+ * Function: put_header
+ * --------------------
+ *   Writes $GP, the sentence type and a comma.
+ *
+ *   returns:	pointer after the written characters.
+ */
+static char *put_header(char *p, uint8_t sentence)
+{
+	*p++ = DOLLAR;
+	*p++ = 'G';
+	*p++ = 'P';
+	for (uint8_t i = 0; i < SENTENCE_TYPE_LEN; i++)
+	{
+		*p++ = (char) pgm_read_byte(&sentences[sentence].type[i]);
+	}
+	*p++ = COMMA;
+	return p;
+}
+
+/*
+ * Function: put_number
+ * --------------------
+ *   Writes a number fixed to int_len.frac_len characters with leading
+ *   zeros, or to int_len characters if frac_len is 0. A negative number
+ *   takes one integer character for the sign. Values which don't fit are
+ *   written as all nines.
+ *
+ *   value: the number multiplied by 10^frac_len
+ *   int_len: length of integer part
+ *   frac_len: length of fractional part
+ *
+ *   returns:	pointer after the written characters.
+ */
+static char *put_number(char *p, int32_t value, uint8_t int_len, uint8_t frac_len)
+{
+	uint8_t len = int_len + frac_len;
+	uint32_t v = (uint32_t) value;
+
+	if (value < 0)
+	{
+		*p++ = '-';
+		v = -v;
+		len--;
+		int_len--;
+	}
+	if (v >= pgm_read_dword(&powers_of_ten[len]))
+	{
+		v = pgm_read_dword(&powers_of_ten[len]) - 1;
+	}
+	while (len > 0)
+	{
+		uint32_t power = pgm_read_dword(&powers_of_ten[--len]);
+		char c = '0';
+		while (v >= power)
+		{
+			v -= power;
+			c++;
+		}
+		*p++ = c;
+		if (--int_len == 0 && frac_len)
+		{
+			*p++ = DOT;
+		}
+	}
+	return p;
+}
+
+/*
+ * Function: put_value
+ * -------------------
+ *   Writes a number fixed to int_len.frac_len characters in the VX-8
+ *   dialect. In the NMEA dialect the integer part has no leading zeros.
+ *
+ *   returns:	pointer after the written characters.
+ */
+static char *put_value(char *p, int32_t value, uint8_t int_len, uint8_t frac_len, uint8_t dialect)
+{
+	if (dialect == RENDER_NMEA)
+	{
+		uint32_t v = value < 0 ? -(uint32_t) value : (uint32_t) value;
+		int_len = 1;
+		while (int_len + frac_len < 9 && v >= pgm_read_dword(&powers_of_ten[int_len + frac_len]))
+		{
+			int_len++;
+		}
+		if (value < 0)
+		{
+			int_len++;
+		}
+	}
+	return put_number(p, value, int_len, frac_len);
+}
+
+/*
+ * Function: put_time
+ * ------------------
+ *   Writes UTC time as hhmmss.sss, or hhmmss.ss in the NMEA dialect. The
+ *   milliseconds of GPS and UTC time are the same.
+ *
+ *   returns:	pointer after the written characters.
+ */
+static char *put_time(char *p, const struct gps_fix *fix, uint8_t dialect)
+{
+	uint32_t ms = fix->sec * 1000L + fix->itow % 1000;
+
+	p = put_number(p, fix->hour, 2, 0);
+	p = put_number(p, fix->min, 2, 0);
+	if (dialect == RENDER_NMEA)
+	{
+		return put_number(p, ms / 10, 2, 2);
+	}
+	return put_number(p, ms, 2, 3);
+}
+
+/*
+ * Function: put_angle
+ * -------------------
+ *   Writes latitude or longitude as degrees and minutes with 4 decimals,
+ *   a comma and the hemisphere. The minutes are truncated like the NMEA
+ *   input is.
+ *
+ *   value: the angle in 1e-7 degrees
+ *   deg_len: 2 for latitude, 3 for longitude
+ *   pos: hemisphere of positive angles
+ *   neg: hemisphere of negative angles
+ *
+ *   returns:	pointer after the written characters.
+ */
+static char *put_angle(char *p, int32_t value, uint8_t deg_len, char pos, char neg)
+{
+	uint32_t v = value < 0 ? -(uint32_t) value : (uint32_t) value;
+	uint32_t deg = v / DEG_SCALE;
+	uint32_t min = (v - deg * DEG_SCALE) * 6 / 100; /* 1e-4 minutes */
+
+	p = put_number(p, deg * 1000000UL + min, deg_len + 2, 4);
+	*p++ = COMMA;
+	*p++ = value < 0 ? neg : pos;
+	return p;
+}
+
+/*
+ * Function: put_position
+ * ----------------------
+ *   Writes latitude and longitude with their hemispheres, zero without
+ *   fix in the VX-8 dialect and four empty fields in the NMEA dialect.
+ *
+ *   returns:	pointer after the written characters.
+ */
+static char *put_position(char *p, const struct gps_fix *fix, uint8_t dialect)
+{
+	uint8_t ok = gps_fix_ok(fix);
+
+	if (!ok && dialect == RENDER_NMEA)
+	{
+		*p++ = COMMA;
+		*p++ = COMMA;
+		*p++ = COMMA;
+		return p;
+	}
+	p = put_angle(p, ok ? fix->lat : 0, 2, 'N', 'S');
+	*p++ = COMMA;
+	return put_angle(p, ok ? fix->lon : 0, 3, 'E', 'W');
+}
+
+/*
+ * Function: put_gga
+ * -----------------
+ *   Writes the GGA fields:
+ *   hhmmss.sss,ddmm.mmmm,N,dddmm.mmmm,E,q,nn,hh.h,aaaaa.a,M,gggg.g,M,000.0,0000
+ *   or in the NMEA dialect:
+ *   hhmmss.ss,ddmm.mmmm,N,dddmm.mmmm,E,q,nn,h.hh,a.a,M,g.g,M,,
+ *
+ *   returns:	pointer after the written characters.
+ */
+static char *put_gga(char *p, const struct gps_fix *fix, uint8_t dialect)
+{
+	uint8_t ok = gps_fix_ok(fix);
+
+	p = put_time(p, fix, dialect);
+	*p++ = COMMA;
+	p = put_position(p, fix, dialect);
+	*p++ = COMMA;
+	*p++ = quality(fix, '0', '1', '2', '6');
+	*p++ = COMMA;
+	p = put_number(p, fix->num_sv, 2, 0);
+	*p++ = COMMA;
+	if (dialect == RENDER_NMEA)
+	{
+		p = put_value(p, fix->hdop, 1, 2, dialect);
+		*p++ = COMMA;
+		if (ok)
+		{
+			p = put_value(p, fix->hmsl / 100, 1, 1, dialect);
+			*p++ = COMMA;
+			*p++ = 'M';
+			*p++ = COMMA;
+			p = put_value(p, (fix->height - fix->hmsl) / 100, 1, 1, dialect);
+			*p++ = COMMA;
+			*p++ = 'M';
+		}
+		else
+		{
+			*p++ = COMMA;
+			*p++ = COMMA;
+			*p++ = COMMA;
+		}
+		/* No DGPS data */
+		*p++ = COMMA;
+		*p++ = COMMA;
+		return p;
+	}
+	p = put_number(p, fix->hdop / 10, 2, 1);
+	*p++ = COMMA;
+	p = put_number(p, ok ? fix->hmsl / 100 : 0, 5, 1);
+	*p++ = COMMA;
+	*p++ = 'M';
+	*p++ = COMMA;
+	p = put_number(p, ok ? (fix->height - fix->hmsl) / 100 : 0, 4, 1);
+	*p++ = COMMA;
+	*p++ = 'M';
+	*p++ = COMMA;
+	/* No DGPS data */
+	p = put_number(p, 0, 3, 1);
+	*p++ = COMMA;
+	return put_number(p, 0, 4, 0);
+}
+
+/*
+ * Function: put_rmc
+ * -----------------
+ *   Writes the RMC fields:
+ *   hhmmss.sss,A,ddmm.mmmm,N,dddmm.mmmm,E,ssss.ss,ddd.dd,ddmmyy,,,A
+ *   or in the NMEA dialect, with empty motion fields without fix:
+ *   hhmmss.ss,A,ddmm.mmmm,N,dddmm.mmmm,E,s.ss,d.dd,ddmmyy,,,A
+ *
+ *   returns:	pointer after the written characters.
+ */
+static char *put_rmc(char *p, const struct gps_fix *fix, uint8_t dialect)
+{
+	uint8_t ok = gps_fix_ok(fix);
+
+	p = put_time(p, fix, dialect);
+	*p++ = COMMA;
+	*p++ = ok && !(fix->fix_flags & GPS_FIX_LAST_KNOWN) ? 'A' : 'V';
+	*p++ = COMMA;
+	p = put_position(p, fix, dialect);
+	*p++ = COMMA;
+	if (ok || dialect != RENDER_NMEA)
+	{
+		p = put_value(p, speed_of(fix), 4, 2, dialect);
+		*p++ = COMMA;
+		p = put_value(p, course_of(fix), 3, 2, dialect);
+	}
+	else
+	{
+		*p++ = COMMA;
+	}
+	*p++ = COMMA;
+	p = put_number(p, fix->day, 2, 0);
+	p = put_number(p, fix->month, 2, 0);
+	p = put_number(p, fix->year % 100, 2, 0);
+	*p++ = COMMA;
+	*p++ = COMMA;
+	*p++ = COMMA;
+	*p++ = quality(fix, 'N', 'A', 'D', 'E');
+	return p;
+}
+
+/*
+ * Function: put_zda
+ * -----------------
+ *   Writes the ZDA fields: hhmmss.sss,dd,mm,yyyy,,
+ *
+ *   returns:	pointer after the written characters.
+ */
+static char *put_zda(char *p, const struct gps_fix *fix, uint8_t dialect)
+{
+	p = put_time(p, fix, dialect);
+	*p++ = COMMA;
+	p = put_number(p, fix->day, 2, 0);
+	*p++ = COMMA;
+	p = put_number(p, fix->month, 2, 0);
+	*p++ = COMMA;
+	p = put_number(p, fix->year, 4, 0);
+	*p++ = COMMA;
+	*p++ = COMMA;
+	return p;
+}
+
+/*
+ * Function: quality
+ * -----------------
+ *   Chooses the GGA quality or RMC mode character of the fix.
+ *
+ *   returns:	none_c without fix, last_c for a saved position, diff_c for
+ *   			a differential fix and fix_c otherwise.
+ */
+static char quality(const struct gps_fix *fix, char none_c, char fix_c, char diff_c, char last_c)
+{
+	if (!gps_fix_ok(fix))
+	{
+		return none_c;
+	}
+	if (fix->fix_flags & GPS_FIX_LAST_KNOWN)
+	{
+		return last_c;
+	}
+	return fix->fix_flags & GPS_FIX_DIFF ? diff_c : fix_c;
+}
+
+/*
+ * Function: speed_of
+ * ------------------
+ *   returns:	ground speed in 0.01 knots, 0 without fix.
+ */
+static uint32_t speed_of(const struct gps_fix *fix)
+{
+	if (!gps_fix_ok(fix))
+	{
+		return 0;
+	}
+	/* cm/s to 0.01 knots */
+	return (fix->gspeed * 3600UL + 926) / 1852;
+}
+
+/*
+ * Function: course_of
+ * -------------------
+ *   returns:	course in 0.01 degrees, 0 without fix.
+ */
+static uint16_t course_of(const struct gps_fix *fix)
+{
+	uint32_t course;
+
+	if (!gps_fix_ok(fix) || fix->heading <= 0)
+	{
+		return 0;
+	}
+	/* 1e-5 to 0.01 degrees */
+	course = (uint32_t) fix->heading / 1000;
+	if (course >= 36000)
+	{
+		course -= 36000;
+	}
+	return (uint16_t) course;
+}
+
+/*
+ * Function: get_state
+ * -------------------
+ *   Converts the fix to the values of the VX-8 fields, the same way
+ *   put_gga(), put_rmc() and put_zda() do.
+ *
+ *   returns:	none
+ */
+static void get_state(const struct gps_fix *fix, struct render_state *s)
+{
+	uint8_t ok = gps_fix_ok(fix);
+
+	s->lat = ok ? fix->lat : 0;
+	s->lon = ok ? fix->lon : 0;
+	s->alt = ok ? fix->hmsl / 100 : 0;
+	s->geoid = ok ? (fix->height - fix->hmsl) / 100 : 0;
+	s->speed = speed_of(fix);
+	s->course = course_of(fix);
+	s->hdop = fix->hdop / 10;
+	s->ms = (uint16_t) (fix->sec * 1000U + fix->itow % 1000);
+	s->year = fix->year;
+	s->month = fix->month;
+	s->day = fix->day;
+	s->hour = fix->hour;
+	s->min = fix->min;
+	s->num_sv = fix->num_sv;
+	s->quality = quality(fix, '0', '1', '2', '6');
+}
+
+/*
+ * Function: patch_time
+ * --------------------
+ *   Rewrites the time field of the template if it changed. Only the
+ *   seconds are written when the minute is the same.
+ *
+ *   returns:	none
+ */
+static void patch_time(struct render_template *t, const struct render_state *s)
+{
+	const struct render_state *old = &t->state;
+	char *p = t->frame.buffer + TIME_POS;
+
+	if (s->hour == old->hour && s->min == old->min)
+	{
+		if (s->ms != old->ms)
+		{
+			toggle(t, TIME_POS + 4, TIME_LEN - 4);
+			put_number(p + 4, s->ms, 2, 3);
+			toggle(t, TIME_POS + 4, TIME_LEN - 4);
+		}
+		return;
+	}
+	toggle(t, TIME_POS, TIME_LEN);
+	p = put_number(p, s->hour, 2, 0);
+	p = put_number(p, s->min, 2, 0);
+	put_number(p, s->ms, 2, 3);
+	toggle(t, TIME_POS, TIME_LEN);
+}
+
+/*
+ * Function: patch_position
+ * ------------------------
+ *   Rewrites latitude and longitude with their hemispheres if they
+ *   changed.
+ *
+ *   pos: position of the latitude field
+ *
+ *   returns:	none
+ */
+static void patch_position(struct render_template *t, const struct render_state *s, uint8_t pos)
+{
+	if (s->lat != t->state.lat)
+	{
+		toggle(t, pos, LAT_LEN);
+		put_angle(t->frame.buffer + pos, s->lat, 2, 'N', 'S');
+		toggle(t, pos, LAT_LEN);
+	}
+	pos += LAT_LEN + 1;
+	if (s->lon != t->state.lon)
+	{
+		toggle(t, pos, LON_LEN);
+		put_angle(t->frame.buffer + pos, s->lon, 3, 'E', 'W');
+		toggle(t, pos, LON_LEN);
+	}
+}
+
+/*
+ * Function: patch_gga
+ * -------------------
+ *   Rewrites the changed GGA fields after the time. The DGPS fields are
+ *   always zero.
+ *
+ *   returns:	none
+ */
+static void patch_gga(struct render_template *t, const struct render_state *s)
+{
+	const struct render_state *old = &t->state;
+	char *buffer = t->frame.buffer;
+
+	patch_position(t, s, GGA_LAT);
+	if (s->quality != old->quality)
+	{
+		toggle(t, GGA_QUALITY, 1);
+		buffer[GGA_QUALITY] = s->quality;
+		toggle(t, GGA_QUALITY, 1);
+	}
+	if (s->num_sv != old->num_sv)
+	{
+		toggle(t, GGA_SATS, 2);
+		put_number(buffer + GGA_SATS, s->num_sv, 2, 0);
+		toggle(t, GGA_SATS, 2);
+	}
+	if (s->hdop != old->hdop)
+	{
+		toggle(t, GGA_HDOP, 4);
+		put_number(buffer + GGA_HDOP, s->hdop, 2, 1);
+		toggle(t, GGA_HDOP, 4);
+	}
+	if (s->alt != old->alt)
+	{
+		toggle(t, GGA_ALT, 7);
+		put_number(buffer + GGA_ALT, s->alt, 5, 1);
+		toggle(t, GGA_ALT, 7);
+	}
+	if (s->geoid != old->geoid)
+	{
+		toggle(t, GGA_GEOID, 6);
+		put_number(buffer + GGA_GEOID, s->geoid, 4, 1);
+		toggle(t, GGA_GEOID, 6);
+	}
+}
+
+/*
+ * Function: patch_rmc
+ * -------------------
+ *   Rewrites the changed RMC fields after the time.
+ *
+ *   returns:	none
+ */
+static void patch_rmc(struct render_template *t, const struct gps_fix *fix, const struct render_state *s)
+{
+	const struct render_state *old = &t->state;
+	char *buffer = t->frame.buffer;
+
+	if (s->quality != old->quality)
+	{
+		toggle(t, RMC_STATUS, 1);
+		toggle(t, RMC_MODE, 1);
+		buffer[RMC_STATUS] = s->quality == '1' || s->quality == '2' ? 'A' : 'V';
+		buffer[RMC_MODE] = quality(fix, 'N', 'A', 'D', 'E');
+		toggle(t, RMC_STATUS, 1);
+		toggle(t, RMC_MODE, 1);
+	}
+	patch_position(t, s, RMC_LAT);
+	if (s->speed != old->speed)
+	{
+		toggle(t, RMC_SPEED, 7);
+		put_number(buffer + RMC_SPEED, s->speed, 4, 2);
+		toggle(t, RMC_SPEED, 7);
+	}
+	if (s->course != old->course)
+	{
+		toggle(t, RMC_COURSE, 6);
+		put_number(buffer + RMC_COURSE, s->course, 3, 2);
+		toggle(t, RMC_COURSE, 6);
+	}
+	if (s->day != old->day || s->month != old->month || s->year != old->year)
+	{
+		char *p = buffer + RMC_DATE;
+		toggle(t, RMC_DATE, 6);
+		p = put_number(p, s->day, 2, 0);
+		p = put_number(p, s->month, 2, 0);
+		put_number(p, s->year % 100, 2, 0);
+		toggle(t, RMC_DATE, 6);
+	}
+}
+
+/*
+ * Function: patch_zda
+ * -------------------
+ *   Rewrites the date of ZDA if it changed.
+ *
+ *   returns:	none
+ */
+static void patch_zda(struct render_template *t, const struct render_state *s)
+{
+	const struct render_state *old = &t->state;
+	char *buffer = t->frame.buffer;
+
+	if (s->day != old->day || s->month != old->month || s->year != old->year)
+	{
+		toggle(t, ZDA_DAY, ZDA_YEAR + 4 - ZDA_DAY);
+		put_number(buffer + ZDA_DAY, s->day, 2, 0);
+		put_number(buffer + ZDA_MONTH, s->month, 2, 0);
+		put_number(buffer + ZDA_YEAR, s->year, 4, 0);
+		toggle(t, ZDA_DAY, ZDA_YEAR + 4 - ZDA_DAY);
+	}
+}
+
+/*
+ * Function: toggle
+ * ----------------
+ *   XORs the characters into the checksum of the template. Called before
+ *   a field is rewritten to remove its old characters and after it to add
+ *   the new ones.
+ *
+ *   pos: position of the first character
+ *   len: number of characters
+ *
+ *   returns:	none
+ */
+static void toggle(struct render_template *t, uint8_t pos, uint8_t len)
+{
+	const char *c = t->frame.buffer + pos;
+	uint8_t checksum = t->checksum;
+
+	while (len--)
+	{
+		checksum ^= (uint8_t) *c++;
+	}
+	t->checksum = checksum;
+}
+
+/*
+ * Function: render_set_ms
+ * -----------------------
+ *   Replaces the milliseconds of the time field, the first field of every
+ *   VX-8 sentence, and updates the checksum. Only time at a whole second
+ *   is replaced.
+ *
+ *   frame: a complete sentence, rendered or produced by the transform
+ *   ms: the new milliseconds, at most 999
+ *
+ *   returns:	1 if the time was replaced, 0 if its milliseconds aren't 000.
+ */
+uint8_t render_set_ms(struct vx8_frame *frame, uint16_t ms)
+{
+	char *p = frame->buffer + TIME_MS_POS;
+
+	if (frame->len < TIME_MS_POS + 3 + TRAILER_LEN || p[-1] != DOT || p[0] != '0' || p[1] != '0' || p[2] != '0')
+	{
+		return 0;
+	}
+	put_number(p, ms < MAX_MS ? ms : MAX_MS, 3, 0);
+	render_finish(frame, frame->buffer + frame->len - TRAILER_LEN);
+	return 1;
+}
+
+/*
+ * Function: render_finish
+ * -----------------------
+ *   Appends the checksum of the characters between $ and the end, and
+ *   CR LF. Sets the frame length.
+ *
+ *   returns:	none
+ */
+void render_finish(struct vx8_frame *frame, char *p)
+{
+	uint8_t checksum = 0;
+
+	for (const char *c = frame->buffer + 1; c < p; c++)
+	{
+		checksum ^= (uint8_t) *c;
+	}
+	*p++ = ASTERISK;
+	*p++ = hex_chars[(checksum & 0xF0) >> 4];
+	*p++ = hex_chars[checksum & 0x0F];
+	*p++ = CR;
+	*p++ = LF;
+	frame->len = (uint8_t) (p - frame->buffer);
+	frame->pos = 0;
+}
@@ -0,0 +1,88 @@
+/*
+ * render.h
+ *
+ *  Created on: 16 Oct 2026
+ *  Author: Dmitry Melnichansky / 4Z7DTF
+ *
+ *  Renders VX-8 sentences from a binary fix. The fields have the same
+ *  fixed widths as the sentences produced from NMEA input by vx8_core.c.
+ *  RENDER_NMEA renders the same sentences as standard NMEA, with the
+ *  numbers not padded and the fields of a missing fix empty, like the
+ *  NEO-6M sends them.
+ *  The fields of the VX-8 dialect have fixed positions, so with a
+ *  render_cache a sentence is rendered once and then kept as a template:
+ *  render_cached() rewrites only the fields whose values changed since
+ *  the last epoch and updates the checksum.
+ */
+
+#ifndef RENDER_H_
+#define RENDER_H_
+
+#include <stdint.h>
+#include "../src/gps_fix.h"
+#include "../src/sentences.h"
+#include "../src/vx8_core.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Dialects of render_sentence(). */
+enum render_dialects
+{
+	RENDER_VX8, /* Fixed width fields for VX-8. */
+	RENDER_NMEA, /* Standard NMEA 0183. */
+};
+
+/* Values of the VX-8 dialect fields, in the units they are written in.
+ * Position, altitude and motion are zero without fix.
+ */
+struct render_state
+{
+	int32_t lat; /* 1e-7 degrees */
+	int32_t lon; /* 1e-7 degrees */
+	int32_t alt; /* dm */
+	int32_t geoid; /* dm */
+	uint32_t speed; /* 0.01 knots */
+	uint16_t course; /* 0.01 degrees */
+	uint16_t hdop; /* 0.1 */
+	uint16_t ms; /* Seconds and milliseconds of the time. */
+	uint16_t year;
+	uint8_t month;
+	uint8_t day;
+	uint8_t hour;
+	uint8_t min;
+	uint8_t num_sv;
+	char quality; /* GGA fix quality, decides RMC status and mode too. */
+};
+
+/* Last VX-8 sentence of one type and the values it was rendered from. */
+struct render_template
+{
+	struct vx8_frame frame;
+	struct render_state state;
+	uint8_t checksum; /* XOR of the characters between $ and *. */
+	uint8_t valid;
+};
+
+struct render_cache
+{
+	struct gps_fix fix; /* Fix of the last call, converted to state. */
+	struct render_state state;
+	uint8_t have_state;
+	struct render_template templates[SENTENCE_COUNT];
+};
+
+uint8_t render_sentence(const struct gps_fix *fix, uint8_t sentence, uint8_t dialect, struct vx8_frame *frame);
+void render_cache_init(struct render_cache *cache);
+uint8_t render_cached(struct render_cache *cache, const struct gps_fix *fix, uint8_t sentence,
+		struct vx8_frame *frame);
+uint8_t render_leds(const struct gps_fix *fix);
+void render_finish(struct vx8_frame *frame, char *end);
+uint8_t render_set_ms(struct vx8_frame *frame, uint16_t ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RENDER_H_ */
@@ -0,0 +1,110 @@
+/*
+ * ring_buffer.h
+ *
+ *  Created on: 16 Oct 2026
+ *  Author: Dmitry Melnichansky / 4Z7DTF
+ *
+ *  Lock-free single producer/single consumer ring buffer. The producer
+ *  (USART_RX_vect) only writes head, the consumer (main loop) only writes
+ *  tail. Both indices are free running 8-bit counters, so a single byte
+ *  load or store is atomic on AVR and no interrupts have to be disabled.
+ */
+
+#ifndef RING_BUFFER_H_
+#define RING_BUFFER_H_
+
+#include <stdint.h>
+
+/* Buffer size must be a power of two not bigger than 128. One 86 byte GGA
+ * sentence fits completely into the default buffer.
+ */
+#ifndef RING_BUFFER_SIZE
+#define RING_BUFFER_SIZE 128
+#endif
+#define RING_BUFFER_MASK (RING_BUFFER_SIZE - 1)
+
+#if (RING_BUFFER_SIZE & RING_BUFFER_MASK) || RING_BUFFER_SIZE > 128
+#error "RING_BUFFER_SIZE must be a power of two not bigger than 128"
+#endif
+
+struct ring_buffer
+{
+	volatile uint8_t data[RING_BUFFER_SIZE];
+	volatile uint8_t head; /* Next position to write. Changed by producer only. */
+	volatile uint8_t tail; /* Next position to read. Changed by consumer only. */
+	volatile uint8_t overflows; /* Bytes dropped because the buffer was full. Saturates at 0xFF. */
+};
+
+/*
+ * Function: ring_put
+ * ------------------
+ *   Adds a byte to the buffer. Called by the producer only. If the buffer
+ *   is full the byte is dropped and the overflow counter is incremented.
+ *
+ *   rb: the ring buffer
+ *   byte: the byte to add
+ *
+ *   returns:	1 if the byte was added, 0 if it was dropped.
+ */
+static inline uint8_t ring_put(struct ring_buffer *rb, uint8_t byte)
+{
+	uint8_t head = rb->head;
+	if ((uint8_t) (head - rb->tail) >= RING_BUFFER_SIZE)
+	{
+		if (rb->overflows != 0xFF)
+			rb->overflows++;
+		return 0;
+	}
+	rb->data[head & RING_BUFFER_MASK] = byte;
+	rb->head = head + 1; /* Publish the byte only after it was stored. */
+	return 1;
+}
+
+/*
+ * Function: ring_get
+ * ------------------
+ *   Takes the oldest byte from the buffer. Called by the consumer only.
+ *
+ *   rb: the ring buffer
+ *   byte: where to store the byte; left unchanged if the buffer is empty
+ *
+ *   returns:	1 if a byte was read, 0 if the buffer was empty.
+ */
+static inline uint8_t ring_get(struct ring_buffer *rb, uint8_t *byte)
+{
+	uint8_t tail = rb->tail;
+	if (tail == rb->head)
+	{
+		return 0;
+	}
+	*byte = rb->data[tail & RING_BUFFER_MASK];
+	rb->tail = tail + 1; /* Free the slot only after it was read. */
+	return 1;
+}
+
+/*
+ * Function: ring_count
+ * --------------------
+ *   returns:	the number of bytes waiting in the buffer.
+ */
+static inline uint8_t ring_count(const struct ring_buffer *rb)
+{
+	return (uint8_t) (rb->head - rb->tail);
+}
+
+/*
+ * Function: ring_reset
+ * --------------------
+ *   Empties the buffer and clears the overflow counter. Must not be called
+ *   while the producer is active.
+ *
+ *   returns:	none
+ */
+static inline void ring_reset(struct ring_buffer *rb)
+{
+	rb->head = 0;
+	rb->tail = 0;
+	rb->overflows = 0;
+}
+
+#endif /* RING_BUFFER_H_ */
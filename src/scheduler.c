@@ -0,0 +1,220 @@
+/*
+ * scheduler.c
+ *
+ *  Created on: 16 Oct 2026
+ *  Author: Dmitry Melnichansky / 4Z7DTF
+ *
+ *  Rates and priorities of the sentence types are set in sentences[].
+ *  The firmware calls sched_next() from USART_UDRE_vect, the other
+ *  functions must be called with interrupts disabled.
+ */
+
+#include "../src/scheduler.h"
+
+#define LAST_PRIORITY 0xFE
+
+static uint8_t priority_of(uint8_t);
+static uint8_t rate_div_of(const struct scheduler *, uint8_t);
+
+/*
+ * Function: sched_init
+ * --------------------
+ *   Initializes the scheduler with no frames waiting.
+ *
+ *   output: OUTPUT_VX8 or OUTPUT_NMEA, the output whose rate dividers
+ *   		 are used
+ *
+ *   returns:	none
+ */
+void sched_init(struct scheduler *s, uint8_t output)
+{
+	for (uint8_t i = 0; i < SCHED_TYPES; i++)
+	{
+		s->pending[i] = SCHED_NONE;
+		s->count[i] = 0;
+	}
+	s->stale = 0;
+	s->skipped = 0;
+	s->output = output;
+}
+
+/*
+ * Function: sched_put
+ * -------------------
+ *   Adds a complete frame. The first of each rate_div frames of a type is
+ *   kept, the others are dropped. A kept frame replaces the frame of the
+ *   same type still waiting for TX.
+ *
+ *   type: sentence type of the frame, index in sentences[]
+ *   frame: index of the frame
+ *
+ *   returns:	index of the frame which isn't used anymore (the dropped
+ *   			or the replaced one), SCHED_NONE if there is none.
+ */
+uint8_t sched_put(struct scheduler *s, uint8_t type, uint8_t frame)
+{
+	uint8_t n = s->count[type];
+	uint8_t old;
+
+	s->count[type] = (n + 1 < rate_div_of(s, type)) ? n + 1 : 0;
+	if (n != 0)
+	{
+		s->skipped++;
+		return frame;
+	}
+
+	old = s->pending[type];
+	s->pending[type] = frame;
+	if (old != SCHED_NONE)
+	{
+		s->stale++;
+	}
+	return old;
+}
+
+/*
+ * Function: sched_next
+ * --------------------
+ *   Takes the waiting frame with the highest priority. Types with equal
+ *   priority are taken in sentences[] order.
+ *
+ *   returns:	index of the frame, SCHED_NONE if no frame is waiting.
+ */
+uint8_t sched_next(struct scheduler *s)
+{
+	uint8_t best = SCHED_NONE;
+	uint8_t best_priority = 0xFF;
+	uint8_t frame;
+
+	for (uint8_t i = 0; i < SCHED_TYPES; i++)
+	{
+		if (s->pending[i] != SCHED_NONE)
+		{
+			uint8_t priority = priority_of(i);
+			if (best == SCHED_NONE || priority < best_priority)
+			{
+				best = i;
+				best_priority = priority;
+			}
+		}
+	}
+	if (best == SCHED_NONE)
+	{
+		return SCHED_NONE;
+	}
+	frame = s->pending[best];
+	s->pending[best] = SCHED_NONE;
+	return frame;
+}
+
+/*
+ * Function: sched_holds
+ * ---------------------
+ *   returns:	1 if the frame is waiting for TX, 0 otherwise.
+ */
+uint8_t sched_holds(const struct scheduler *s, uint8_t frame)
+{
+	for (uint8_t i = 0; i < SCHED_TYPES; i++)
+	{
+		if (s->pending[i] == frame)
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/*
+ * Function: sched_depth
+ * ---------------------
+ *   returns:	number of frames waiting for TX.
+ */
+uint8_t sched_depth(const struct scheduler *s)
+{
+	uint8_t depth = 0;
+	for (uint8_t i = 0; i < SCHED_TYPES; i++)
+	{
+		if (s->pending[i] != SCHED_NONE)
+		{
+			depth++;
+		}
+	}
+	return depth;
+}
+
+/*
+ * Function: sched_order
+ * ---------------------
+ *   Lists the waiting frames in the order sched_next() takes them, if no
+ *   frame is added meanwhile.
+ *
+ *   frames: SCHED_TYPES entries for the frame indexes
+ *
+ *   returns:	number of frames listed.
+ */
+uint8_t sched_order(const struct scheduler *s, uint8_t *frames)
+{
+	uint8_t taken[SCHED_TYPES];
+	uint8_t count = 0;
+
+	for (uint8_t i = 0; i < SCHED_TYPES; i++)
+	{
+		taken[i] = s->pending[i] == SCHED_NONE;
+	}
+	for (;;)
+	{
+		uint8_t best = SCHED_NONE;
+		uint8_t best_priority = 0xFF;
+		for (uint8_t i = 0; i < SCHED_TYPES; i++)
+		{
+			if (!taken[i])
+			{
+				uint8_t priority = priority_of(i);
+				if (best == SCHED_NONE || priority < best_priority)
+				{
+					best = i;
+					best_priority = priority;
+				}
+			}
+		}
+		if (best == SCHED_NONE)
+		{
+			return count;
+		}
+		taken[best] = 1;
+		frames[count++] = s->pending[best];
+	}
+}
+
+/*
+ * Function: priority_of
+ * ---------------------
+ *   returns:	TX priority of the frame type, the telemetry sentence last.
+ */
+static uint8_t priority_of(uint8_t type)
+{
+#ifdef VX8_TELEMETRY
+	if (type == SCHED_TELEMETRY)
+	{
+		return LAST_PRIORITY;
+	}
+#endif
+	return get_sentence_priority(type);
+}
+
+/*
+ * Function: rate_div_of
+ * ---------------------
+ *   returns:	rate divider of the frame type on the output of the
+ *   			scheduler, 1 for the telemetry sentence.
+ */
+static uint8_t rate_div_of(const struct scheduler *s, uint8_t type)
+{
+#ifdef VX8_TELEMETRY
+	if (type == SCHED_TELEMETRY)
+	{
+		return 1;
+	}
+#endif
+	return get_sentence_rate_div(type, s->output);
+}
@@ -0,0 +1,46 @@
+/*
+ * scheduler.h
+ *
+ *  Created on: 16 Oct 2026
+ *  Author: Dmitry Melnichansky / 4Z7DTF
+ *
+ *  Output scheduler between the transform and TX. Keeps the newest
+ *  complete frame of each sentence type and hands them to TX in priority
+ *  order. Frames are referred to by their index in the caller's pool.
+ */
+
+#ifndef SCHEDULER_H_
+#define SCHEDULER_H_
+
+#include <stdint.h>
+#include "../src/sentences.h"
+
+#define SCHED_NONE 0xFF
+
+/* Frame types: the sentences of sentences[] and, with VX8_TELEMETRY, the
+ * telemetry sentence, which isn't received. It is sent after the others.
+ */
+#ifdef VX8_TELEMETRY
+#define SCHED_TELEMETRY SENTENCE_COUNT
+#define SCHED_TYPES (SENTENCE_COUNT + 1)
+#else
+#define SCHED_TYPES SENTENCE_COUNT
+#endif
+
+struct scheduler
+{
+	uint8_t pending[SCHED_TYPES]; /* Newest frame of each type waiting for TX, SCHED_NONE if none. */
+	uint8_t count[SCHED_TYPES]; /* Received sentences of each type modulo rate_div. */
+	uint16_t stale; /* Frames replaced by a newer frame of the same type before TX. */
+	uint16_t skipped; /* Frames dropped by the rate divider. */
+	uint8_t output; /* OUTPUT_VX8 or OUTPUT_NMEA, selects the rate dividers. */
+};
+
+void sched_init(struct scheduler *s, uint8_t output);
+uint8_t sched_put(struct scheduler *s, uint8_t type, uint8_t frame);
+uint8_t sched_next(struct scheduler *s);
+uint8_t sched_holds(const struct scheduler *s, uint8_t frame);
+uint8_t sched_depth(const struct scheduler *s);
+uint8_t sched_order(const struct scheduler *s, uint8_t *frames);
+
+#endif /* SCHEDULER_H_ */
@@ -0,0 +1,177 @@
+/*
+ * sentences.c
+ *
+ *  Created on: 16 Oct 2026
+ *  Author: Dmitry Melnichansky / 4Z7DTF
+ */
+
+#include "../src/sentences.h"
+
+#define KEEP { FIELD_KEEP, 0, 0, 0 }
+#define DECIMAL(i, f) { FIELD_DECIMAL, i, f, 0 }
+#define INTEGER(n) { FIELD_INT, n, 0, 0 }
+#define CHAR(c) { FIELD_CHAR, 0, 0, c }
+/* Time field is fixed to 10 characters: hhmmss.sss. If time field is empty
+ * all the message is discarded. This is done to prevent sending false time
+ * to VX-8.
+ */
+#define TIME { FIELD_DECIMAL | FIELD_REJECT_EMPTY, 6, 3, 0 }
+/* Latitude field is fixed to 9 characters: ddmm.ssss */
+#define LATITUDE { FIELD_DECIMAL | FIELD_FIX_LED, 4, 4, 0 }
+/* Longitude field is fixed to 10 characters: dddmm.ssss */
+#define LONGITUDE DECIMAL(5, 4)
+
+/* NEO-6M vs. Yaesu VX-8
+ * NEO:    $GPGGA,094053.00,3204.41475,N,03445.96499,E,1,09,1.12,28.7,M,17.5,M,,*69
+ * VX8:    $GPGGA,095142.196,4957.5953,N,00811.9616,E,0,00,99.9,00234.7,M,0047.9,M,000.0,0000*42
+ * Dif:    $GPGGA,094053.00_,3204.4147X,N,03445.9649X,E,1,09,_1.1X,___28.7,M,__17.5,M,___._,____*69
+ * Fields:      0          1          2 3           4 5 6  7     8       9 A      B C     D    E
+ */
+static const struct field_spec gga_fields[] PROGMEM = {
+	TIME, /* 0x01 */
+	LATITUDE, /* 0x02 */
+	CHAR('N'), /* 0x03 Latitude N/S field is set to N if empty. */
+	LONGITUDE, /* 0x04 */
+	CHAR('E'), /* 0x05 Longitude E/W field is set to E if empty. */
+	KEEP, /* 0x06 Fix quality doesn't require modification. */
+	INTEGER(2), /* 0x07 Number of satellites is integer fixed to 2 characters. */
+	DECIMAL(2, 1), /* 0x08 Horizontal dilution of position: xx.x. NEO-6M has one character more after the decimal point. */
+	DECIMAL(5, 1), /* 0x09 Altitude above mean sea level: aaaaa.a */
+	CHAR('M'), /* 0x0A Altitude units are set to M (meters) if empty. */
+	DECIMAL(4, 1), /* 0x0B Height of geoid: hhhh.h */
+	CHAR('M'), /* 0x0C Geoid height units are set to M (meters) if empty. */
+	DECIMAL(3, 1), /* 0x0D Time since last DGPS update: ddd.m */
+	INTEGER(4), /* 0x0E DGPS station ID number is integer fixed to 4 characters. */
+};
+
+/* NEO-6M vs. Yaesu VX-8
+ * NEO:    $GPRMC,094054.00,A,3204.41446,N,03445.96604,E,3.876,110.45,231215,,,A*62
+ * VX8:    $GPRMC,095142.196,V,4957.5953,N,00811.9616,E,9999.99,999.99,080810,,*2C
+ * Dif:    $GPRMC,094054.00_,A,3204.4144X,N,03445.9660X,E,___3.87X,110.45,231215,,XX*62
+ * Fields:      0          1 2          3 4           5 6        7      8      9
+ */
+static const struct field_spec rmc_fields[] PROGMEM = {
+	TIME, /* 0x01 */
+	KEEP, /* 0x02 Status A/V. */
+	LATITUDE, /* 0x03 */
+	CHAR('N'), /* 0x04 Latitude N/S field is set to N if empty. */
+	LONGITUDE, /* 0x05 */
+	CHAR('E'), /* 0x06 Longitude E/W field is set to E if empty. */
+	DECIMAL(4, 2), /* 0x07 Speed: ssss.ss */
+	DECIMAL(3, 2), /* 0x08 Track angle: ddd.mm */
+};
+
+/* NEO-6M vs. Yaesu VX-8
+ * NEO:    $GPZDA,142615.00,26,12,2015,,*52
+ * VX8:    $GPZDA,095143.196,08,08,2010,,*51
+ * Dif:    $GPZDA,142615.00_,26,12,2015,,*52
+ * Fields:      0          1  2  3    4
+ */
+static const struct field_spec zda_fields[] PROGMEM = {
+	TIME, /* 0x01 */
+};
+
+#define SENTENCE(type, fields, leds, priority, vx8_rate_div, nmea_rate_div) \
+	{ type, sizeof(fields) / sizeof(fields[0]), fields, leds, priority, { vx8_rate_div, nmea_rate_div } }
+
+/* Output schedule. When the radio link falls behind, only the newest
+ * sentence of each type waits for TX and the waiting sentences are sent
+ * in priority order: RMC and GGA carry the position, ZDA only the time.
+ * The NEO-6M sends each type once per epoch, so rate_div of N sends a
+ * type every N epochs, e.g. 5 for ZDA at a 5Hz GPS rate. The standard
+ * NMEA output of VX8_NMEA_OUTPUT has its own dividers, as it runs at
+ * 4800 baud.
+ */
+const struct sentence_spec sentences[] PROGMEM = {
+	SENTENCE("GGA", gga_fields, LEDS_GGA, 1, 1, 1),
+	SENTENCE("RMC", rmc_fields, LEDS_RMC, 0, 1, 1),
+	SENTENCE("ZDA", zda_fields, LEDS_NONE, 2, 1, 1),
+};
+
+_Static_assert(sizeof(sentences) / sizeof(sentences[0]) == SENTENCE_COUNT,
+		"sentences[] and enum sentence_types must list the same sentences");
+
+/*
+ * Function: find_sentence
+ * -----------------------
+ *   Finds sentence layout by sentence type. Talker ID isn't checked, so
+ *   $GP, $GN and other talkers are accepted.
+ *
+ *   type: the sentence type, e.g. GGA
+ *
+ *   returns:	index of the sentence in sentences[], NO_SENTENCE if the
+ *   			type isn't supported.
+ */
+uint8_t find_sentence(const char type[])
+{
+	for (uint8_t i = 0; i < SENTENCE_COUNT; i++)
+	{
+		uint8_t j = 0;
+		while (j < SENTENCE_TYPE_LEN && (char) pgm_read_byte(&sentences[i].type[j]) == type[j])
+		{
+			j++;
+		}
+		if (j == SENTENCE_TYPE_LEN)
+		{
+			return i;
+		}
+	}
+	return NO_SENTENCE;
+}
+
+/*
+ * Function: get_field_spec
+ * ------------------------
+ *   Copies layout of a field from program memory.
+ *
+ *   sentence: index of the sentence in sentences[]
+ *   field_num: number of the field, 1 for the first field after the type
+ *   spec: where to copy the layout
+ *
+ *   returns:	1 if the field has a layout, 0 if the field is forwarded
+ *   			without changes.
+ */
+uint8_t get_field_spec(uint8_t sentence, uint8_t field_num, struct field_spec *spec)
+{
+	const struct sentence_spec *s = &sentences[sentence];
+	if (field_num == 0 || field_num > pgm_read_byte(&s->field_count))
+	{
+		return 0;
+	}
+	const struct field_spec *fields = (const struct field_spec *) pgm_read_ptr(&s->fields);
+	memcpy_P(spec, &fields[field_num - 1], sizeof(struct field_spec));
+	return 1;
+}
+
+/*
+ * Function: get_sentence_leds
+ * ---------------------------
+ *   returns:	status LEDs of the sentence, one of sentence_leds values.
+ */
+uint8_t get_sentence_leds(uint8_t sentence)
+{
+	return pgm_read_byte(&sentences[sentence].leds);
+}
+
+/*
+ * Function: get_sentence_priority
+ * -------------------------------
+ *   returns:	TX priority of the sentence, 0 is the highest.
+ */
+uint8_t get_sentence_priority(uint8_t sentence)
+{
+	return pgm_read_byte(&sentences[sentence].priority);
+}
+
+/*
+ * Function: get_sentence_rate_div
+ * -------------------------------
+ *   output: OUTPUT_VX8 or OUTPUT_NMEA
+ *
+ *   returns:	rate divider of the sentence on the output, 1 if every
+ *   			sentence is sent.
+ */
+uint8_t get_sentence_rate_div(uint8_t sentence, uint8_t output)
+{
+	return pgm_read_byte(&sentences[sentence].rate_div[output]);
+}
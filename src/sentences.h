@@ -0,0 +1,90 @@
+/*
+ * sentences.h
+ *
+ *  Created on: 16 Oct 2026
+ *  Author: Dmitry Melnichansky / 4Z7DTF
+ *
+ *  Layouts of the NMEA sentences forwarded to VX-8. Each sentence is
+ *  described by a table of field specifications stored in program memory.
+ *  A new sentence is added by adding its table to sentences.c and its
+ *  index to enum sentence_types, which gives SENTENCE_COUNT and so the
+ *  sizes of the scheduler and the render templates.
+ */
+
+#ifndef SENTENCES_H_
+#define SENTENCES_H_
+
+#include <stdint.h>
+#include "../src/progmem.h"
+
+/* Field kinds. The lower nibble of field_spec.kind. */
+#define FIELD_KEEP 0x00 /* Field is forwarded without changes. */
+#define FIELD_DECIMAL 0x01 /* Decimal number fixed to int_len.frac_len characters. */
+#define FIELD_INT 0x02 /* Integer fixed to int_len characters. */
+#define FIELD_CHAR 0x03 /* Set to def if empty. */
+#define FIELD_KIND_MASK 0x0F
+
+/* Field flags. The upper nibble of field_spec.kind. */
+/* The sentence is discarded if the field is empty. In cut-through mode
+ * only the first field is checked before the sentence is released, later
+ * fields with this flag terminate it with an invalid checksum.
+ */
+#define FIELD_REJECT_EMPTY 0x10
+#define FIELD_FIX_LED 0x20 /* The field shows fix status: red LED if empty, green otherwise. */
+
+#define NO_SENTENCE 0xFF
+#define SENTENCE_TYPE_LEN 3
+
+/* Outputs with their own rate dividers. OUTPUT_NMEA is the standard NMEA
+ * output of VX8_NMEA_OUTPUT.
+ */
+#define OUTPUT_VX8 0
+#define OUTPUT_NMEA 1
+#define OUTPUT_COUNT 2
+
+/* Indexes of the sentences in sentences[], in the order of the table.
+ * sentences.c fails to build if the table has a different length.
+ */
+enum sentence_types
+{
+	SENTENCE_GGA, SENTENCE_RMC, SENTENCE_ZDA,
+	SENTENCE_COUNT
+};
+
+/* Status LEDs of a sentence. Mapped to output pins by the firmware. */
+enum sentence_leds
+{
+	LEDS_NONE, LEDS_GGA, LEDS_RMC
+};
+
+/* Layout of one field. */
+struct field_spec
+{
+	uint8_t kind; /* Field kind and flags. */
+	uint8_t int_len; /* Length of integer part, or of an integer field. */
+	uint8_t frac_len; /* Length of fractional part. */
+	char def; /* Default character of FIELD_CHAR fields. */
+};
+
+/* Layout of one sentence. Field 0 (the type) isn't described. fields[0]
+ * describes field 1. Fields after field_count are forwarded without changes.
+ */
+struct sentence_spec
+{
+	char type[SENTENCE_TYPE_LEN]; /* Sentence type without talker ID, e.g. GGA. */
+	uint8_t field_count;
+	const struct field_spec *fields;
+	uint8_t leds;
+	uint8_t priority; /* TX order of sentences waiting together, 0 first. */
+	uint8_t rate_div[OUTPUT_COUNT]; /* One of rate_div received sentences is sent, by output. */
+};
+
+extern const struct sentence_spec sentences[] PROGMEM;
+
+uint8_t find_sentence(const char type[]);
+uint8_t get_field_spec(uint8_t sentence, uint8_t field_num, struct field_spec *spec);
+uint8_t get_sentence_leds(uint8_t sentence);
+uint8_t get_sentence_priority(uint8_t sentence);
+uint8_t get_sentence_rate_div(uint8_t sentence, uint8_t output);
+
+#endif /* SENTENCES_H_ */
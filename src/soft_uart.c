@@ -0,0 +1,183 @@
+/*
+ * soft_uart.c
+ *
+ *  Created on: 16 Oct 2026
+ *  Author: Dmitry Melnichansky / 4Z7DTF
+ *
+ *  Bits are sent by TIMER1_COMPA_vect, or TIMER1_COMPB_vect for the NMEA
+ *  channel, 8N1. Every compare match writes the next bit to the pin and
+ *  moves the compare register one bit time ahead, so ISR latency doesn't
+ *  accumulate. Bit times which aren't a whole number of timer ticks are
+ *  spread over the bits. When a byte is done the next one is taken from
+ *  the callback given to soft_uart_init() and sent without a gap. The
+ *  channels share the code and differ by the constants in channels[].
+ */
+
+#if defined(VX8_SOFT_TX) || defined(VX8_NMEA_OUTPUT)
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#include "../src/soft_uart.h"
+#include "../src/timer1.h"
+
+#define FRAME_BITS 10 /* Start bit, 8 data bits and stop bit. */
+#define CHANNEL_COUNT 2
+
+struct channel
+{
+	uint8_t (*next_byte)(uint8_t *); /* Returns 1 and the next byte to send, 0 if none. */
+	volatile uint16_t shift; /* Bits left to send, LSB first. */
+	volatile uint8_t bits; /* Number of bits left to send. */
+	volatile uint8_t running; /* The compare interrupt is sending. */
+	uint16_t fraction; /* Accumulated remainder of the bit time, in 1/baudrate ticks. */
+	uint16_t bit_ticks;
+	uint16_t remainder; /* TIMER1_HZ % baudrate */
+	uint16_t baudrate;
+	uint8_t pin; /* PORTD bit mask */
+	uint8_t interrupt; /* TIMSK1 bit mask */
+};
+
+static struct channel channels[CHANNEL_COUNT] = {
+	{ 0, 0, 0, 0, 0, TIMER1_HZ / SOFT_UART_BAUDRATE, TIMER1_HZ % SOFT_UART_BAUDRATE, SOFT_UART_BAUDRATE,
+			1 << SOFT_UART_PIN, 1 << OCIE1A },
+	{ 0, 0, 0, 0, 0, TIMER1_HZ / NMEA_BAUDRATE, TIMER1_HZ % NMEA_BAUDRATE, NMEA_BAUDRATE,
+			1 << SOFT_UART_NMEA_PIN, 1 << OCIE1B },
+};
+
+static inline uint16_t send_bit(struct channel *);
+
+/*
+ * Function: soft_uart_init
+ * ------------------------
+ *   Sets the pin of the channel to idle (high) and starts Timer1.
+ *
+ *   channel: SOFT_UART_VX8 or SOFT_UART_NMEA
+ *   next: callback which returns the next byte to send
+ *
+ *   returns:	none
+ */
+void soft_uart_init(uint8_t channel, uint8_t (*next)(uint8_t *))
+{
+	struct channel *c = &channels[channel];
+
+	c->next_byte = next;
+	c->running = 0;
+	PORTD |= c->pin;
+	DDRD |= c->pin;
+	timer1_init();
+}
+
+/*
+ * Function: soft_uart_start
+ * -------------------------
+ *   Starts sending if the channel is idle and its callback has a byte.
+ *   The start bit begins one bit time later.
+ *
+ *   channel: SOFT_UART_VX8 or SOFT_UART_NMEA
+ *
+ *   returns:	none
+ */
+void soft_uart_start(uint8_t channel)
+{
+	struct channel *c = &channels[channel];
+	uint8_t byte;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		if (!c->running && c->next_byte(&byte))
+		{
+			c->shift = ((uint16_t) byte << 1) | (1 << (FRAME_BITS - 1));
+			c->bits = FRAME_BITS;
+			c->fraction = 0;
+			/* Clear a stale compare match. */
+			if (channel == SOFT_UART_VX8)
+			{
+				OCR1A = TCNT1 + c->bit_ticks;
+				TIFR1 = (1 << OCF1A);
+			}
+			else
+			{
+				OCR1B = TCNT1 + c->bit_ticks;
+				TIFR1 = (1 << OCF1B);
+			}
+			TIMSK1 |= c->interrupt;
+			c->running = 1;
+		}
+	}
+}
+
+/*
+ * Function: send_bit
+ * ------------------
+ *   Writes the next bit of the channel to its pin. After the stop bit
+ *   takes the next byte or stops. Called from the compare interrupt.
+ *
+ *   returns:	ticks to the next bit, 0 if the channel stopped.
+ */
+static inline uint16_t send_bit(struct channel *c)
+{
+	uint16_t ticks = c->bit_ticks;
+
+	if (c->bits == 0)
+	{
+		uint8_t byte;
+		if (!c->next_byte(&byte))
+		{
+			TIMSK1 &= ~c->interrupt;
+			c->running = 0;
+			return 0;
+		}
+		c->shift = ((uint16_t) byte << 1) | (1 << (FRAME_BITS - 1));
+		c->bits = FRAME_BITS;
+	}
+
+	if (c->shift & 1)
+		PORTD |= c->pin;
+	else
+		PORTD &= ~c->pin;
+	c->shift >>= 1;
+	c->bits--;
+
+	if (c->remainder)
+	{
+		c->fraction += c->remainder;
+		if (c->fraction >= c->baudrate)
+		{
+			c->fraction -= c->baudrate;
+			ticks++;
+		}
+	}
+	return ticks;
+}
+
+#ifdef VX8_SOFT_TX
+/*
+ * Function: ISR(TIMER1_COMPA_vect)
+ * --------------------------------
+ *   Sends the next bit to VX-8 and schedules the next compare match.
+ *
+ *   returns:	none
+ */
+ISR(TIMER1_COMPA_vect)
+{
+	OCR1A += send_bit(&channels[SOFT_UART_VX8]);
+}
+#endif
+
+#ifdef VX8_NMEA_OUTPUT
+/*
+ * Function: ISR(TIMER1_COMPB_vect)
+ * --------------------------------
+ *   Sends the next bit of the standard NMEA output and schedules the next
+ *   compare match.
+ *
+ *   returns:	none
+ */
+ISR(TIMER1_COMPB_vect)
+{
+	OCR1B += send_bit(&channels[SOFT_UART_NMEA]);
+}
+#endif
+
+#endif /* VX8_SOFT_TX || VX8_NMEA_OUTPUT */
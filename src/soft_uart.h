@@ -0,0 +1,36 @@
+/*
+ * soft_uart.h
+ *
+ *  Created on: 16 Oct 2026
+ *  Author: Dmitry Melnichansky / 4Z7DTF
+ *
+ *  Timer1 driven software UART transmitters. SOFT_UART_VX8 sends the
+ *  output to VX-8 when the firmware is built with VX8_SOFT_TX, so that the
+ *  hardware USART can receive from the GPS at a different baud rate.
+ *  SOFT_UART_NMEA sends the standard NMEA output of VX8_NMEA_OUTPUT.
+ */
+
+#ifndef SOFT_UART_H_
+#define SOFT_UART_H_
+
+#include <stdint.h>
+
+#define SOFT_UART_BAUDRATE 9600
+#define SOFT_UART_PIN PD1 /* PORTD pin, the TXD pin of the USART. */
+
+/* Standard NMEA output. 4800 baud is the NMEA 0183 rate, which cameras
+ * and other NMEA devices expect.
+ */
+#ifndef NMEA_BAUDRATE
+#define NMEA_BAUDRATE 4800
+#endif
+#define SOFT_UART_NMEA_PIN PD3 /* PORTD pin, Arduino pin 3. */
+
+/* Channels. Each one uses its own Timer1 compare unit. */
+#define SOFT_UART_VX8 0 /* Compare unit A, SOFT_UART_PIN */
+#define SOFT_UART_NMEA 1 /* Compare unit B, SOFT_UART_NMEA_PIN */
+
+void soft_uart_init(uint8_t channel, uint8_t (*next)(uint8_t *));
+void soft_uart_start(uint8_t channel);
+
+#endif /* SOFT_UART_H_ */
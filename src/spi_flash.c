@@ -0,0 +1,215 @@
+/*
+ * spi_flash.c
+ *
+ *  Created on: 16 Oct 2026
+ *  Author: Dmitry Melnichansky / 4Z7DTF
+ *
+ *  The capacity is read from the JEDEC ID, up to 16MB of 3 byte
+ *  addresses. Pages are programmed without waiting for the program to
+ *  finish, the next command waits for it. Erasing a sector takes tens of
+ *  milliseconds, so the sector after the one being written is erased
+ *  ahead by spi_flash_poll() when the flash is idle, and a page write
+ *  rarely finds its sector not erased. Only the first write after boot
+ *  at a sector start erases while the main loop waits.
+ */
+
+#ifdef VX8_TRACK_LOG
+
+#include <avr/io.h>
+#include "../src/spi_flash.h"
+
+#define CMD_READ 0x03
+#define CMD_WRITE_ENABLE 0x06
+#define CMD_PAGE_PROGRAM 0x02
+#define CMD_SECTOR_ERASE 0x20
+#define CMD_READ_STATUS 0x05
+#define CMD_JEDEC_ID 0x9F
+#define STATUS_BUSY 0x01
+#define CAPACITY_MIN 0x10 /* 64KB */
+#define CAPACITY_MAX 0x18 /* 16MB */
+#define NO_SECTOR 0xFFFF
+
+#define CS_LOW() (PORTB &= ~(1 << SPI_FLASH_CS))
+#define CS_HIGH() (PORTB |= (1 << SPI_FLASH_CS))
+
+static uint8_t flash_read(uint32_t, uint16_t, uint8_t *, uint16_t);
+static uint8_t flash_write(uint32_t, const uint8_t *);
+static void erase(uint16_t);
+static void command(uint8_t, uint32_t);
+static uint8_t busy(void);
+static void wait_ready(void);
+static uint8_t transfer(uint8_t);
+
+struct track_store spi_flash_store = { 0, flash_read, flash_write };
+
+static uint16_t erased_sector = NO_SECTOR; /* Sector erased ahead of the writes. */
+static uint16_t erase_pending = NO_SECTOR; /* Sector to erase when the flash is idle. */
+
+/*
+ * Function: spi_flash_init
+ * ------------------------
+ *   Starts the SPI as master at F_CPU / 2, mode 0, and reads the capacity
+ *   of the flash.
+ *
+ *   returns:	none
+ */
+void spi_flash_init(void)
+{
+	uint8_t manufacturer;
+	uint8_t capacity;
+
+	PORTB |= (1 << SPI_FLASH_CS);
+	DDRB |= (1 << SPI_FLASH_CS) | (1 << SPI_FLASH_MOSI) | (1 << SPI_FLASH_SCK);
+	DDRB &= ~(1 << SPI_FLASH_MISO);
+	SPCR = (1 << SPE) | (1 << MSTR);
+	SPSR = (1 << SPI2X);
+
+	CS_LOW();
+	transfer(CMD_JEDEC_ID);
+	manufacturer = transfer(0);
+	transfer(0);
+	capacity = transfer(0);
+	CS_HIGH();
+	if (manufacturer == 0x00 || manufacturer == 0xFF || capacity < CAPACITY_MIN || capacity > CAPACITY_MAX)
+	{
+		spi_flash_store.pages = 0;
+		return;
+	}
+	spi_flash_store.pages = (1UL << capacity) / TRACK_PAGE_SIZE;
+}
+
+/*
+ * Function: spi_flash_poll
+ * ------------------------
+ *   Starts the erase of the next sector when the flash is idle.
+ *
+ *   returns:	none
+ */
+void spi_flash_poll(void)
+{
+	if (erase_pending == NO_SECTOR || busy())
+	{
+		return;
+	}
+	erase(erase_pending);
+	erased_sector = erase_pending;
+	erase_pending = NO_SECTOR;
+}
+
+/*
+ * Function: flash_read
+ * --------------------
+ *   track_store read function.
+ *
+ *   returns:	1
+ */
+static uint8_t flash_read(uint32_t page, uint16_t offset, uint8_t *data, uint16_t len)
+{
+	wait_ready();
+	command(CMD_READ, page * TRACK_PAGE_SIZE + offset);
+	while (len--)
+	{
+		*data++ = transfer(0);
+	}
+	CS_HIGH();
+	return 1;
+}
+
+/*
+ * Function: flash_write
+ * ---------------------
+ *   track_store write function. Programs the page and returns while the
+ *   flash is programming it. The first page of a sector erases the sector
+ *   first unless it was erased ahead, and has the next sector erased.
+ *
+ *   returns:	1 if the page was sent to the flash, 0 if it is out of range.
+ */
+static uint8_t flash_write(uint32_t page, const uint8_t *data)
+{
+	uint16_t sector = page / SPI_FLASH_SECTOR_PAGES;
+
+	if (page >= spi_flash_store.pages)
+	{
+		return 0;
+	}
+	wait_ready();
+	if (page % SPI_FLASH_SECTOR_PAGES == 0)
+	{
+		if (sector != erased_sector)
+		{
+			erase(sector);
+			wait_ready();
+		}
+		erase_pending = page + SPI_FLASH_SECTOR_PAGES < spi_flash_store.pages ? sector + 1 : NO_SECTOR;
+	}
+	CS_LOW();
+	transfer(CMD_WRITE_ENABLE);
+	CS_HIGH();
+	command(CMD_PAGE_PROGRAM, page * TRACK_PAGE_SIZE);
+	for (uint16_t i = 0; i < TRACK_PAGE_SIZE; i++)
+	{
+		transfer(data[i]);
+	}
+	CS_HIGH();
+	return 1;
+}
+
+/*
+ * Function: erase
+ * ---------------
+ *   Starts the erase of the sector, the flash is busy until it is done.
+ *
+ *   returns:	none
+ */
+static void erase(uint16_t sector)
+{
+	CS_LOW();
+	transfer(CMD_WRITE_ENABLE);
+	CS_HIGH();
+	command(CMD_SECTOR_ERASE, (uint32_t) sector * SPI_FLASH_SECTOR_PAGES * TRACK_PAGE_SIZE);
+	CS_HIGH();
+}
+
+/*
+ * Function: command
+ * -----------------
+ *   Selects the flash and sends the command with a 3 byte address. The
+ *   caller transfers the data and deselects the flash.
+ *
+ *   returns:	none
+ */
+static void command(uint8_t cmd, uint32_t address)
+{
+	CS_LOW();
+	transfer(cmd);
+	transfer((uint8_t) (address >> 16));
+	transfer((uint8_t) (address >> 8));
+	transfer((uint8_t) address);
+}
+
+static uint8_t busy(void)
+{
+	uint8_t status;
+
+	CS_LOW();
+	transfer(CMD_READ_STATUS);
+	status = transfer(0);
+	CS_HIGH();
+	return status & STATUS_BUSY;
+}
+
+static void wait_ready(void)
+{
+	while (busy())
+		;
+}
+
+static uint8_t transfer(uint8_t byte)
+{
+	SPDR = byte;
+	while (!(SPSR & (1 << SPIF)))
+		;
+	return SPDR;
+}
+
+#endif /* VX8_TRACK_LOG */
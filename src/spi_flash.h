@@ -0,0 +1,35 @@
+/*
+ * spi_flash.h
+ *
+ *  Created on: 16 Oct 2026
+ *  Author: Dmitry Melnichansky / 4Z7DTF
+ *
+ *  SPI NOR flash (W25Qxx, AT25SF and alike) holding the track log, built
+ *  with VX8_TRACK_LOG. The flash is connected to the hardware SPI, Arduino
+ *  pins 10 (CS), 11 (MOSI), 12 (MISO) and 13 (SCK), and powered at 3.3V
+ *  through a level shifter on a 5V board.
+ */
+
+#ifndef SPI_FLASH_H_
+#define SPI_FLASH_H_
+
+#include <stdint.h>
+#include "../src/track_log.h"
+
+#if TRACK_PAGE_SIZE != 256
+#error "SPI NOR flash has 256 byte pages, TRACK_PAGE_SIZE must be 256"
+#endif
+
+#define SPI_FLASH_CS PB2
+#define SPI_FLASH_MOSI PB3
+#define SPI_FLASH_MISO PB4
+#define SPI_FLASH_SCK PB5
+#define SPI_FLASH_SECTOR_PAGES 16 /* 4KB erase sectors. */
+
+/* The flash as a track log store. pages is 0 if no flash answers. */
+extern struct track_store spi_flash_store;
+
+void spi_flash_init(void);
+void spi_flash_poll(void);
+
+#endif /* SPI_FLASH_H_ */
@@ -1,18 +1,21 @@
-/*
- * str_func.h
- *
- *  Created on: 06 jan 2016
- *  Author: Dmitry Melnichansky / 4Z7DTF
- */
-
-#include <stdint.h>
-
-uint8_t int_len(const char *str);
-
-void add_zeros_left(char[], uint8_t, uint8_t);
-void rm_chars_left(char[], uint8_t, uint8_t);
-void add_zeros_right(char[], uint8_t, uint8_t);
-void rm_chars_right(char[], uint8_t, uint8_t);
-
-void fix_int_field_len(char[], uint8_t, uint8_t);
-void fix_decimal_field_len(char[], uint8_t, uint8_t, uint8_t);
+/*
+ * str_func.h
+ *
+ *  Created on: 06 jan 2016
+ *  Author: Dmitry Melnichansky / 4Z7DTF
+ */
+
+#include <stdint.h>
+
+uint8_t int_len(const char *str);
+
+void add_zeros_left(char[], uint8_t, uint8_t);
+void rm_chars_left(char[], uint8_t, uint8_t);
+void add_zeros_right(char[], uint8_t, uint8_t);
+void rm_chars_right(char[], uint8_t, uint8_t);
+
+void fix_int_field_len(char[], uint8_t, uint8_t);
+void fix_decimal_field_len(char[], uint8_t, uint8_t, uint8_t);
+
+uint8_t format_int_field(char[], uint8_t, uint8_t);
+uint8_t format_decimal_field(char[], uint8_t, uint8_t, uint8_t, uint8_t);
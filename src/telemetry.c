@@ -0,0 +1,210 @@
+/*
+ * telemetry.c
+ *
+ *  Created on: 16 Oct 2026
+ *  Author: Dmitry Melnichansky / 4Z7DTF
+ *
+ *  Time is taken from the 32 bit Timer1 clock of timer1.c. The latency is
+ *  sorted into the histogram bins by comparing with doubling limits, so
+ *  there is no division in the interrupt which takes the last byte.
+ */
+
+#ifdef VX8_TELEMETRY
+
+#include <avr/io.h>
+#include <util/atomic.h>
+#include "../src/telemetry.h"
+#include "../src/render.h"
+#include "../src/timer1.h"
+
+#define FIRST_BIN_TICKS ((uint32_t) TELEMETRY_FIRST_BIN_MS * TIMER1_TICKS_PER_MS)
+#define PAGE_COUNTERS 2
+#define PAGE_LATENCY 1
+
+struct telemetry telemetry;
+
+static uint32_t last_check; /* Time of the last telemetry_due() call. */
+static uint32_t elapsed; /* Ticks since the last whole second. */
+static uint32_t uptime; /* Seconds */
+static uint8_t period; /* Seconds since the last sentence. */
+static uint8_t pin_high; /* Last state of TELEMETRY_PIN. */
+static uint8_t pages; /* Pages of the sentence left to send. */
+
+static char *put_text(char *, const char *);
+static char *put_uint(char *, uint32_t);
+
+/*
+ * Function: telemetry_init
+ * ------------------------
+ *   Pulls TELEMETRY_PIN up. The Timer1 clock is started by the caller
+ *   with timer1_clock_init().
+ *
+ *   returns:	none
+ */
+void telemetry_init(void)
+{
+	DDRB &= ~(1 << TELEMETRY_PIN);
+	PORTB |= (1 << TELEMETRY_PIN);
+	pin_high = 1;
+	pages = 0;
+}
+
+/*
+ * Function: telemetry_sent
+ * ------------------------
+ *   Adds the latency of a sentence to the histogram. Called by the
+ *   transmitter when it takes the last byte.
+ *
+ *   start: time when the $ of the sentence was received
+ *
+ *   returns:	none
+ */
+void telemetry_sent(uint32_t start)
+{
+	uint32_t latency = timer1_now() - start;
+	uint32_t limit = FIRST_BIN_TICKS;
+	uint8_t bin = 0;
+
+	while (bin < TELEMETRY_BINS - 1 && latency >= limit)
+	{
+		limit <<= 1;
+		bin++;
+	}
+	telemetry.latency[bin]++;
+	if (latency > telemetry.max_latency)
+	{
+		telemetry.max_latency = latency;
+	}
+}
+
+/*
+ * Function: telemetry_due
+ * -----------------------
+ *   Updates the uptime and requests the sentence every TELEMETRY_PERIOD_S
+ *   seconds and when TELEMETRY_PIN goes low.
+ *
+ *   returns:	1 if a page of the sentence is waiting, 0 otherwise.
+ */
+uint8_t telemetry_due(void)
+{
+	uint32_t now = timer1_now();
+	uint8_t pin = (PINB & (1 << TELEMETRY_PIN)) != 0;
+
+	elapsed += now - last_check;
+	last_check = now;
+	while (elapsed >= TIMER1_HZ)
+	{
+		elapsed -= TIMER1_HZ;
+		uptime++;
+		if (++period >= TELEMETRY_PERIOD_S)
+		{
+			period = 0;
+			pages = PAGE_COUNTERS;
+		}
+	}
+	if (pin_high && !pin)
+	{
+		pages = PAGE_COUNTERS;
+	}
+	pin_high = pin;
+	return pages != 0;
+}
+
+/*
+ * Function: telemetry_render
+ * --------------------------
+ *   Writes the next page of the sentence to the frame. The frame type is
+ *   set to SCHED_TELEMETRY by the caller.
+ *
+ *   ring_overflows: bytes dropped by the RX ring buffer
+ *   stale: frames replaced in the scheduler
+ *   skipped: frames dropped by the rate dividers
+ *
+ *   returns:	none
+ */
+void telemetry_render(struct vx8_frame *frame, uint8_t ring_overflows, uint16_t stale, uint16_t skipped)
+{
+	char *p = put_text(frame->buffer, "$PVX8S,");
+	uint16_t overruns;
+
+	if (pages == PAGE_COUNTERS)
+	{
+		ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+		{
+			overruns = telemetry.overruns;
+		}
+		p = put_text(p, "C,");
+		p = put_uint(p, uptime);
+		for (uint8_t i = 1; i < TELEMETRY_RESULTS; i++)
+		{
+			*p++ = ',';
+			p = put_uint(p, telemetry.results[i]);
+		}
+		*p++ = ',';
+		p = put_uint(p, ring_overflows);
+		*p++ = ',';
+		p = put_uint(p, overruns);
+		*p++ = ',';
+		p = put_uint(p, stale);
+		*p++ = ',';
+		p = put_uint(p, skipped);
+	}
+	else
+	{
+		uint16_t latency[TELEMETRY_BINS];
+		uint32_t max;
+		ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+		{
+			for (uint8_t i = 0; i < TELEMETRY_BINS; i++)
+			{
+				latency[i] = telemetry.latency[i];
+			}
+			max = telemetry.max_latency;
+		}
+		p = put_text(p, "L");
+		for (uint8_t i = 0; i < TELEMETRY_BINS; i++)
+		{
+			*p++ = ',';
+			p = put_uint(p, latency[i]);
+		}
+		*p++ = ',';
+		p = put_uint(p, max / TIMER1_TICKS_PER_MS);
+	}
+	pages--;
+	render_finish(frame, p);
+}
+
+static char *put_text(char *p, const char *text)
+{
+	while (*text)
+	{
+		*p++ = *text++;
+	}
+	return p;
+}
+
+/*
+ * Function: put_uint
+ * ------------------
+ *   Writes a number without leading zeros.
+ *
+ *   returns:	pointer after the written characters.
+ */
+static char *put_uint(char *p, uint32_t value)
+{
+	char digits[10];
+	uint8_t n = 0;
+
+	do
+	{
+		digits[n++] = (char) ('0' + value % 10);
+		value /= 10;
+	} while (value);
+	while (n)
+	{
+		*p++ = digits[--n];
+	}
+	return p;
+}
+
+#endif /* VX8_TELEMETRY */
@@ -0,0 +1,66 @@
+/*
+ * telemetry.h
+ *
+ *  Created on: 16 Oct 2026
+ *  Author: Dmitry Melnichansky / 4Z7DTF
+ *
+ *  Pipeline counters and sentence latency, built with VX8_TELEMETRY. They
+ *  are sent every TELEMETRY_PERIOD_S seconds, or when TELEMETRY_PIN is
+ *  pulled low, as two pages of the proprietary sentence $PVX8S:
+ *    $PVX8S,C,uptime,r1,r2,r3,r4,r5,r6,r7,ring,overrun,stale,skipped*CS
+ *    $PVX8S,L,l0,l1,l2,l3,l4,l5,l6,l7,max*CS
+ *  r1-r7 count the results of vx8_feed() (or ubx_feed() with UBX input)
+ *  by result code, ring the bytes dropped by the RX ring buffer, overrun
+ *  the bytes lost by the USART, stale and skipped the frames dropped by
+ *  the scheduler. l0-l7 count the sentences by latency from $ received to
+ *  the last byte taken by the transmitter: below 32ms, 64ms, ... 2048ms
+ *  and above. max is the largest latency in ms.
+ */
+
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+
+#include <stdint.h>
+#include "../src/vx8_core.h"
+
+#ifndef TELEMETRY_PERIOD_S
+#define TELEMETRY_PERIOD_S 60
+#endif
+#define TELEMETRY_PIN PB1 /* PORTB pin, Arduino pin 9. Pulled up, a button to GND requests the sentence. */
+
+#define TELEMETRY_RESULTS 8 /* Result codes of vx8_feed() and ubx_feed(). */
+#define TELEMETRY_BINS 8
+#define TELEMETRY_FIRST_BIN_MS 32
+
+struct telemetry
+{
+	uint16_t results[TELEMETRY_RESULTS]; /* Input parser results by code. */
+	uint16_t overruns; /* Bytes lost by the USART before USART_RX_vect read them. */
+	uint16_t latency[TELEMETRY_BINS]; /* Sentences by latency. */
+	uint32_t max_latency; /* Timer1 ticks */
+};
+
+extern struct telemetry telemetry;
+
+void telemetry_init(void);
+void telemetry_sent(uint32_t start);
+uint8_t telemetry_due(void);
+void telemetry_render(struct vx8_frame *frame, uint8_t ring_overflows, uint16_t stale, uint16_t skipped);
+
+/*
+ * Function: telemetry_count
+ * -------------------------
+ *   Counts a result of the input parser. Nothing is done for VX8_NONE and
+ *   UBX_NONE, so most bytes cost a compare.
+ *
+ *   returns:	none
+ */
+static inline void telemetry_count(uint8_t res)
+{
+	if (res != 0)
+	{
+		telemetry.results[res]++;
+	}
+}
+
+#endif /* TELEMETRY_H_ */
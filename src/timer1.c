@@ -0,0 +1,88 @@
+/*
+ * timer1.c
+ *
+ *  Created on: 16 Oct 2026
+ *  Author: Dmitry Melnichansky / 4Z7DTF
+ *
+ *  32 bit clock at TIMER1_HZ for telemetry.c and pps.c. TIMER1_OVF_vect
+ *  counts the overflows of the free running counter, which give the upper
+ *  16 bits. It wraps after 2^32 ticks, about 36 minutes at 16MHz, so only
+ *  differences of times closer than that are meaningful.
+ */
+
+#if defined(VX8_TELEMETRY) || defined(VX8_PPS)
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#include "../src/timer1.h"
+
+static volatile uint16_t overflows; /* Timer1 overflows, upper 16 bits of the time. */
+
+/*
+ * Function: timer1_clock_init
+ * ---------------------------
+ *   Starts Timer1 and its overflow interrupt. timer1_init() disables all
+ *   the Timer1 interrupts, so it is called before the modules enabling
+ *   them.
+ *
+ *   returns:	none
+ */
+void timer1_clock_init(void)
+{
+	timer1_init();
+	overflows = 0;
+	TIMSK1 |= (1 << TOIE1);
+}
+
+/*
+ * Function: timer1_now
+ * --------------------
+ *   returns:	Timer1 ticks since timer1_clock_init(), wrapping in 32 bits.
+ */
+uint32_t timer1_now(void)
+{
+	uint32_t now;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		now = timer1_extend(TCNT1);
+	}
+	return now;
+}
+
+/*
+ * Function: timer1_extend
+ * -----------------------
+ *   Extends a counter value read shortly before, like TCNT1 or ICR1, to
+ *   the 32 bit time. Called with interrupts disabled.
+ *
+ *   ticks: the counter value
+ *
+ *   returns:	the time of the counter value.
+ */
+uint32_t timer1_extend(uint16_t ticks)
+{
+	uint16_t high = overflows;
+
+	/* Overflow not serviced yet. A value read before it is close to 0xFFFF. */
+	if ((TIFR1 & (1 << TOV1)) && ticks < 0x8000)
+	{
+		high++;
+	}
+	return ((uint32_t) high << 16) | ticks;
+}
+
+/*
+ * Function: ISR(TIMER1_OVF_vect)
+ * ------------------------------
+ *   Counts Timer1 overflows, every 65536 ticks.
+ *
+ *   returns:	none
+ */
+ISR(TIMER1_OVF_vect)
+{
+	overflows++;
+}
+
+#endif /* VX8_TELEMETRY || VX8_PPS */
@@ -0,0 +1,45 @@
+/*
+ * timer1.h
+ *
+ *  Created on: 16 Oct 2026
+ *  Author: Dmitry Melnichansky / 4Z7DTF
+ *
+ *  Timer1 runs free at F_CPU / 8 and is shared by the modules using it.
+ *  Each of them uses its own compare or capture unit and never resets the
+ *  counter. With VX8_TELEMETRY or VX8_PPS timer1.c extends the counter to
+ *  a 32 bit clock by counting overflows.
+ */
+
+#ifndef TIMER1_H_
+#define TIMER1_H_
+
+#include <avr/io.h>
+
+#define TIMER1_PRESCALER 8
+#define TIMER1_HZ (F_CPU / TIMER1_PRESCALER)
+
+/*
+ * Function: timer1_init
+ * ---------------------
+ *   Starts Timer1 in normal mode with all its interrupts disabled. The
+ *   Arduino core sets Timer1 up for PWM, so all the registers are written.
+ *
+ *   returns:	none
+ */
+static inline void timer1_init(void)
+{
+	TIMSK1 = 0;
+	TCCR1A = 0;
+	TCCR1C = 0;
+	TCCR1B = (1 << CS11); /* clk/8 */
+}
+
+#if defined(VX8_TELEMETRY) || defined(VX8_PPS)
+#define TIMER1_TICKS_PER_MS (TIMER1_HZ / 1000)
+
+void timer1_clock_init(void);
+uint32_t timer1_now(void);
+uint32_t timer1_extend(uint16_t ticks);
+#endif
+
+#endif /* TIMER1_H_ */
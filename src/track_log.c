@@ -0,0 +1,455 @@
+/*
+ * track_log.c
+ *
+ *  Created on: 16 Oct 2026
+ *  Author: Dmitry Melnichansky / 4Z7DTF
+ *
+ *  The write position is found at start by a binary search for the first
+ *  page which was never written, so the log continues after a power
+ *  cycle. Records are only written in full pages; the records in the
+ *  buffer are lost at power-off unless track_log_flush() is called. When
+ *  the store is full logging stops, the old track isn't overwritten.
+ *  No hardware is used here, the store does the I/O.
+ */
+
+#include <string.h>
+#include "../src/track_log.h"
+
+#define DEG_DIV 10 /* 1e-7 degrees of gps_fix to 1e-6 degrees. */
+#define COURSE_DIV 10000 /* 1e-5 degrees of gps_fix to 0.1 degrees. */
+#define FULL_CIRCLE 3600
+#define VARINT_MAX 5
+
+static uint8_t encode(const struct track_log *, const struct track_point *, uint8_t, uint8_t *);
+static uint8_t write_page(struct track_log *);
+static uint8_t *put_u32(uint8_t *, uint32_t);
+static uint8_t *put_varint(uint8_t *, uint32_t);
+static uint8_t *put_svarint(uint8_t *, int32_t);
+static uint8_t get_u32(struct track_reader *, uint32_t *);
+static uint8_t get_varint(struct track_reader *, uint32_t *);
+static uint8_t get_svarint(struct track_reader *, int32_t *);
+
+/*
+ * Function: track_log_init
+ * ------------------------
+ *   Initializes the log with an empty buffer at the first page of the
+ *   store which was never written.
+ *
+ *   store: the page storage
+ *
+ *   returns:	none
+ */
+void track_log_init(struct track_log *log, const struct track_store *store)
+{
+	uint32_t lo = 0;
+	uint32_t hi = store->pages;
+
+	log->store = store;
+	while (lo < hi)
+	{
+		uint32_t mid = lo + (hi - lo) / 2;
+		uint8_t b = TRACK_END;
+		if (store->read(mid, 0, &b, 1) && b == TRACK_END)
+		{
+			hi = mid;
+		}
+		else
+		{
+			lo = mid + 1;
+		}
+	}
+	log->page = lo;
+	log->len = 0;
+	log->lat_step = 0;
+	log->lon_step = 0;
+	log->records = 0;
+	log->record_bytes = 0;
+	log->pages_written = 0;
+	memset(log->buffer, TRACK_END, TRACK_PAGE_SIZE);
+}
+
+/*
+ * Function: track_point_from_fix
+ * ------------------------------
+ *   Converts the fix to the units of the log.
+ *
+ *   returns:	1 if the fix is a valid position from the GPS with UTC date
+ *   			and time, 0 otherwise.
+ */
+uint8_t track_point_from_fix(struct track_point *point, const struct gps_fix *fix)
+{
+	int32_t course;
+
+	if (!gps_fix_ok(fix) || (fix->fix_flags & GPS_FIX_LAST_KNOWN) || !(fix->time_valid & GPS_TIME_VALID_UTC)
+			|| fix->year < 2000 || fix->month < 1 || fix->month > 12)
+	{
+		return 0;
+	}
+	point->time = gps_fix_days(fix->year, fix->month, fix->day) * 86400UL + fix->hour * 3600UL + fix->min * 60U
+			+ fix->sec;
+	point->lat = (fix->lat + (fix->lat < 0 ? -DEG_DIV / 2 : DEG_DIV / 2)) / DEG_DIV;
+	point->lon = (fix->lon + (fix->lon < 0 ? -DEG_DIV / 2 : DEG_DIV / 2)) / DEG_DIV;
+	point->alt = fix->hmsl / 100;
+	point->speed = fix->gspeed > 0xFFFF ? 0xFFFF : (uint16_t) fix->gspeed;
+	course = (fix->heading / COURSE_DIV) % FULL_CIRCLE;
+	point->course = (uint16_t) (course < 0 ? course + FULL_CIRCLE : course);
+	return 1;
+}
+
+/*
+ * Function: track_log_add
+ * -----------------------
+ *   Adds a record of the fix to the page buffer. The buffer is written to
+ *   the store when the record doesn't fit, and the record starts the next
+ *   page as a key record. A fix which isn't later than the last one is
+ *   logged as a key record too.
+ *
+ *   returns:	one of track_log_results values.
+ */
+uint8_t track_log_add(struct track_log *log, const struct gps_fix *fix)
+{
+	struct track_point point;
+	uint8_t record[TRACK_RECORD_MAX];
+	uint8_t len;
+
+	if (!track_point_from_fix(&point, fix))
+	{
+		return TRACK_LOG_SKIPPED;
+	}
+	if (log->page >= log->store->pages)
+	{
+		return TRACK_LOG_FULL;
+	}
+	len = encode(log, &point, log->len == 0 || (int32_t) (point.time - log->last.time) <= 0, record);
+	if (log->len + len > TRACK_PAGE_SIZE)
+	{
+		if (!write_page(log))
+		{
+			return TRACK_LOG_ERROR;
+		}
+		if (log->page >= log->store->pages)
+		{
+			return TRACK_LOG_FULL;
+		}
+		len = encode(log, &point, 1, record);
+	}
+	memcpy(log->buffer + log->len, record, len);
+	if (record[0] == TRACK_KEY)
+	{
+		log->lat_step = 0;
+		log->lon_step = 0;
+	}
+	else
+	{
+		log->lat_step = point.lat - log->last.lat;
+		log->lon_step = point.lon - log->last.lon;
+	}
+	log->last = point;
+	log->len += len;
+	log->records++;
+	log->record_bytes += len;
+	return TRACK_LOG_ADDED;
+}
+
+/*
+ * Function: track_log_flush
+ * -------------------------
+ *   Writes the records in the buffer as a page, the rest of the page
+ *   stays erased. The next record starts a new page.
+ *
+ *   returns:	1 if the records were written or there were none, 0 if the
+ *   			store failed.
+ */
+uint8_t track_log_flush(struct track_log *log)
+{
+	if (log->len == 0)
+	{
+		return 1;
+	}
+	return write_page(log);
+}
+
+/*
+ * Function: encode
+ * ----------------
+ *   Encodes the point as a key record or as a delta record against the
+ *   last logged point. The log isn't changed.
+ *
+ *   key: 1 for a key record
+ *   record: TRACK_RECORD_MAX bytes for the record
+ *
+ *   returns:	length of the record.
+ */
+static uint8_t encode(const struct track_log *log, const struct track_point *point, uint8_t key, uint8_t *record)
+{
+	const struct track_point *last = &log->last;
+	uint8_t *p = record + 1;
+	uint32_t dt;
+	int32_t dlat;
+	int32_t dlon;
+	uint8_t flags = 0;
+
+	if (key)
+	{
+		record[0] = TRACK_KEY;
+		p = put_u32(p, point->time);
+		p = put_u32(p, (uint32_t) point->lat);
+		p = put_u32(p, (uint32_t) point->lon);
+		p = put_svarint(p, point->alt);
+		p = put_varint(p, point->speed);
+		p = put_varint(p, point->course);
+		return (uint8_t) (p - record);
+	}
+
+	dt = point->time - last->time;
+	dlat = point->lat - (last->lat + log->lat_step);
+	dlon = point->lon - (last->lon + log->lon_step);
+	if (dt != 1)
+	{
+		flags |= TRACK_DT;
+		p = put_varint(p, dt);
+	}
+	if (dlat)
+	{
+		flags |= TRACK_LAT;
+		p = put_svarint(p, dlat);
+	}
+	if (dlon)
+	{
+		flags |= TRACK_LON;
+		p = put_svarint(p, dlon);
+	}
+	if (point->alt != last->alt)
+	{
+		flags |= TRACK_ALT;
+		p = put_svarint(p, point->alt - last->alt);
+	}
+	if (point->speed != last->speed)
+	{
+		flags |= TRACK_SPEED;
+		p = put_svarint(p, (int32_t) point->speed - last->speed);
+	}
+	if (point->course != last->course)
+	{
+		flags |= TRACK_COURSE;
+		p = put_svarint(p, (int32_t) point->course - last->course);
+	}
+	record[0] = flags;
+	return (uint8_t) (p - record);
+}
+
+/*
+ * Function: write_page
+ * --------------------
+ *   Writes the buffer to the current page and continues with an empty
+ *   buffer at the next page, also if the write failed.
+ *
+ *   returns:	1 if the page was written, 0 otherwise.
+ */
+static uint8_t write_page(struct track_log *log)
+{
+	uint8_t ok = log->store->write(log->page, log->buffer);
+
+	if (ok)
+	{
+		log->pages_written++;
+	}
+	log->page++;
+	log->len = 0;
+	memset(log->buffer, TRACK_END, TRACK_PAGE_SIZE);
+	return ok;
+}
+
+/*
+ * Function: track_reader_init
+ * ---------------------------
+ *   Starts decoding a page, or the records of a page buffer.
+ *
+ *   data: the page
+ *   len: its length, TRACK_PAGE_SIZE for a page read from a store
+ *
+ *   returns:	none
+ */
+void track_reader_init(struct track_reader *r, const uint8_t *data, uint16_t len)
+{
+	r->data = data;
+	r->len = len;
+	r->pos = 0;
+	r->lat_step = 0;
+	r->lon_step = 0;
+	memset(&r->point, 0, sizeof(r->point));
+}
+
+/*
+ * Function: track_reader_next
+ * ---------------------------
+ *   Decodes the next record into r->point. A page which doesn't start
+ *   with a key record, e.g. an erased one, has no points.
+ *
+ *   returns:	1 if a point was decoded, 0 at the end of the records or if
+ *   			the rest of the page is invalid.
+ */
+uint8_t track_reader_next(struct track_reader *r)
+{
+	struct track_point *point = &r->point;
+	uint32_t u;
+	int32_t d;
+	uint8_t flags;
+
+	if (r->pos >= r->len)
+	{
+		return 0;
+	}
+	flags = r->data[r->pos];
+	if (flags == TRACK_KEY)
+	{
+		uint32_t lat;
+		uint32_t lon;
+		r->pos++;
+		if (!get_u32(r, &point->time) || !get_u32(r, &lat) || !get_u32(r, &lon) || !get_svarint(r, &point->alt)
+				|| !get_varint(r, &u))
+		{
+			return 0;
+		}
+		point->lat = (int32_t) lat;
+		point->lon = (int32_t) lon;
+		point->speed = (uint16_t) u;
+		if (!get_varint(r, &u))
+		{
+			return 0;
+		}
+		point->course = (uint16_t) u;
+		r->lat_step = 0;
+		r->lon_step = 0;
+		return 1;
+	}
+	/* Delta records follow a key record. */
+	if ((flags & TRACK_KEY) || r->pos == 0)
+	{
+		return 0;
+	}
+	r->pos++;
+
+	u = 1;
+	if ((flags & TRACK_DT) && !get_varint(r, &u))
+	{
+		return 0;
+	}
+	point->time += u;
+	d = 0;
+	if ((flags & TRACK_LAT) && !get_svarint(r, &d))
+	{
+		return 0;
+	}
+	d += r->lat_step;
+	point->lat += d;
+	r->lat_step = d;
+	d = 0;
+	if ((flags & TRACK_LON) && !get_svarint(r, &d))
+	{
+		return 0;
+	}
+	d += r->lon_step;
+	point->lon += d;
+	r->lon_step = d;
+	if (flags & TRACK_ALT)
+	{
+		if (!get_svarint(r, &d))
+		{
+			return 0;
+		}
+		point->alt += d;
+	}
+	if (flags & TRACK_SPEED)
+	{
+		if (!get_svarint(r, &d))
+		{
+			return 0;
+		}
+		point->speed = (uint16_t) (point->speed + d);
+	}
+	if (flags & TRACK_COURSE)
+	{
+		if (!get_svarint(r, &d))
+		{
+			return 0;
+		}
+		point->course = (uint16_t) (point->course + d);
+	}
+	return 1;
+}
+
+static uint8_t *put_u32(uint8_t *p, uint32_t v)
+{
+	*p++ = (uint8_t) v;
+	*p++ = (uint8_t) (v >> 8);
+	*p++ = (uint8_t) (v >> 16);
+	*p++ = (uint8_t) (v >> 24);
+	return p;
+}
+
+static uint8_t *put_varint(uint8_t *p, uint32_t v)
+{
+	while (v >= 0x80)
+	{
+		*p++ = (uint8_t) (v | 0x80);
+		v >>= 7;
+	}
+	*p++ = (uint8_t) v;
+	return p;
+}
+
+/*
+ * Function: put_svarint
+ * ---------------------
+ *   Writes a signed value zigzag encoded, so that small negative values
+ *   are short too: 0, -1, 1, -2... become 0, 1, 2, 3...
+ *
+ *   returns:	pointer after the written bytes.
+ */
+static uint8_t *put_svarint(uint8_t *p, int32_t v)
+{
+	return put_varint(p, ((uint32_t) v << 1) ^ (uint32_t) (v >> 31));
+}
+
+static uint8_t get_u32(struct track_reader *r, uint32_t *v)
+{
+	const uint8_t *p = r->data + r->pos;
+
+	if (r->len - r->pos < 4)
+	{
+		return 0;
+	}
+	*v = p[0] | (uint32_t) p[1] << 8 | (uint32_t) p[2] << 16 | (uint32_t) p[3] << 24;
+	r->pos += 4;
+	return 1;
+}
+
+static uint8_t get_varint(struct track_reader *r, uint32_t *v)
+{
+	uint32_t value = 0;
+
+	for (uint8_t i = 0; i < VARINT_MAX && r->pos < r->len; i++)
+	{
+		uint8_t b = r->data[r->pos++];
+		value |= (uint32_t) (b & 0x7F) << (7 * i);
+		if (!(b & 0x80))
+		{
+			*v = value;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static uint8_t get_svarint(struct track_reader *r, int32_t *v)
+{
+	uint32_t u;
+
+	if (!get_varint(r, &u))
+	{
+		return 0;
+	}
+	*v = (int32_t) (u >> 1) ^ -(int32_t) (u & 1);
+	return 1;
+}
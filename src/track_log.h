@@ -0,0 +1,121 @@
+/*
+ * track_log.h
+ *
+ *  Created on: 16 Oct 2026
+ *  Author: Dmitry Melnichansky / 4Z7DTF
+ *
+ *  Compact binary track log. Every logged fix becomes a record of a few
+ *  bytes, delta encoded against the fix before it. Records are collected
+ *  in a page buffer and written a page at a time to a track_store, which
+ *  is an SPI flash (spi_flash.c) on the device and a file on the host.
+ *  Every page starts with a key record with the full values, so pages
+ *  are decoded independently of each other.
+ *
+ *  Record formats, multi-byte values little-endian:
+ *    key:    0x80, time (4 bytes), lat (4), lon (4), alt, speed, course
+ *    delta:  flags (bit 7 clear), then a varint for every flag set
+ *  Varints are 7 bits per byte, low bits first, signed values zigzag
+ *  encoded. Delta flags:
+ *    TRACK_DT      time step in seconds, 1 if not present
+ *    TRACK_LAT     latitude, difference from lat + the last lat step
+ *    TRACK_LON     longitude, like latitude
+ *    TRACK_ALT     difference of altitude
+ *    TRACK_SPEED   difference of speed
+ *    TRACK_COURSE  difference of course
+ *  The position is predicted from the last step, so a steady motion logs
+ *  zero differences. A fix with the same values one second later is a
+ *  single 0x00 byte. 0xFF ends the records of a page (erased flash).
+ */
+
+#ifndef TRACK_LOG_H_
+#define TRACK_LOG_H_
+
+#include <stdint.h>
+#include "../src/gps_fix.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Page size of the store: 256 for SPI NOR flash, 512 for SD cards. */
+#ifndef TRACK_PAGE_SIZE
+#define TRACK_PAGE_SIZE 256
+#endif
+
+#define TRACK_KEY 0x80
+#define TRACK_END 0xFF
+#define TRACK_DT 0x01
+#define TRACK_LAT 0x02
+#define TRACK_LON 0x04
+#define TRACK_ALT 0x08
+#define TRACK_SPEED 0x10
+#define TRACK_COURSE 0x20
+#define TRACK_RECORD_MAX 28 /* Delta record with all the flags and the longest varints. */
+
+/* Results of track_log_add(). */
+enum track_log_results
+{
+	TRACK_LOG_ADDED, /* Record added to the page buffer. */
+	TRACK_LOG_SKIPPED, /* No valid fix or UTC time. */
+	TRACK_LOG_FULL, /* The store is full, nothing is logged anymore. */
+	TRACK_LOG_ERROR, /* The store failed to write a page, the page is lost. */
+};
+
+/* One point of the track. */
+struct track_point
+{
+	uint32_t time; /* UTC seconds since 2000-01-01 00:00. */
+	int32_t lat; /* 1e-6 degrees */
+	int32_t lon; /* 1e-6 degrees */
+	int32_t alt; /* Height above mean sea level, dm. */
+	uint16_t speed; /* Ground speed, cm/s. */
+	uint16_t course; /* Course over ground, 0.1 degrees. */
+};
+
+/* Page storage. Pages are written in order and never rewritten, a page
+ * which was never written reads TRACK_END at offset 0.
+ */
+struct track_store
+{
+	uint32_t pages; /* Capacity in pages, 0 if there is no store. */
+	uint8_t (*read)(uint32_t page, uint16_t offset, uint8_t *data, uint16_t len); /* Returns 1 if read. */
+	uint8_t (*write)(uint32_t page, const uint8_t *data); /* Writes a full page, returns 1 if written. */
+};
+
+struct track_log
+{
+	const struct track_store *store;
+	uint32_t page; /* Page of the buffer. */
+	uint16_t len; /* Bytes in the buffer. */
+	struct track_point last; /* Last logged point. */
+	int32_t lat_step; /* Last steps of the position, for the prediction. */
+	int32_t lon_step;
+	uint32_t records;
+	uint32_t record_bytes;
+	uint32_t pages_written;
+	uint8_t buffer[TRACK_PAGE_SIZE];
+};
+
+/* Decoder of one page. */
+struct track_reader
+{
+	const uint8_t *data;
+	uint16_t len;
+	uint16_t pos;
+	struct track_point point; /* The point decoded by track_reader_next(). */
+	int32_t lat_step;
+	int32_t lon_step;
+};
+
+void track_log_init(struct track_log *log, const struct track_store *store);
+uint8_t track_log_add(struct track_log *log, const struct gps_fix *fix);
+uint8_t track_log_flush(struct track_log *log);
+uint8_t track_point_from_fix(struct track_point *point, const struct gps_fix *fix);
+void track_reader_init(struct track_reader *r, const uint8_t *data, uint16_t len);
+uint8_t track_reader_next(struct track_reader *r);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TRACK_LOG_H_ */
@@ -0,0 +1,254 @@
+/*
+ * ubx.c
+ *
+ *  Created on: 16 Oct 2026
+ *  Author: Dmitry Melnichansky / 4Z7DTF
+ *
+ *  UBX frame: sync characters 0xB5 0x62, class, ID, 16 bit little endian
+ *  payload length, payload and two checksum bytes. The checksum is the
+ *  8 bit Fletcher algorithm over class, ID, length and payload. Payloads
+ *  of the decoded messages are buffered until the checksum is checked,
+ *  payloads of other messages are only counted.
+ */
+
+#include "../src/ubx.h"
+
+/* Bits of ubx.epoch_msgs. */
+#define UBX_MSG_POSLLH 0x01
+#define UBX_MSG_SOL 0x02
+#define UBX_MSG_VELNED 0x04
+#define UBX_MSG_TIMEUTC 0x08
+#define UBX_MSG_DOP 0x10
+#define UBX_MSG_EPOCH (UBX_MSG_POSLLH | UBX_MSG_SOL | UBX_MSG_VELNED | UBX_MSG_TIMEUTC | UBX_MSG_DOP)
+
+/* Payload lengths of the decoded messages. */
+#define UBX_POSLLH_LEN 28
+#define UBX_SOL_LEN 52
+#define UBX_VELNED_LEN 36
+#define UBX_TIMEUTC_LEN 20
+#define UBX_DOP_LEN 18
+#define UBX_ACK_LEN 2
+
+static uint8_t msg_bit(const struct ubx *);
+static uint8_t decode(struct ubx *);
+static uint16_t get_u16(const uint8_t *);
+static uint32_t get_u32(const uint8_t *);
+
+/*
+ * Function: ubx_init
+ * ------------------
+ *   Initializes the UBX input context.
+ *
+ *   returns:	none
+ */
+void ubx_init(struct ubx *ctx)
+{
+	ctx->state = UBX_SYNC_1;
+	ctx->epoch_msgs = 0;
+	ctx->fix.itow = 0;
+	ctx->fix.time_valid = 0;
+	ctx->fix.fix_type = GPS_FIX_NONE;
+	ctx->fix.fix_flags = 0;
+}
+
+/*
+ * Function: ubx_feed
+ * ------------------
+ *   Processes one received byte.
+ *
+ *   ctx: the context
+ *   byte: the received byte
+ *
+ *   returns:	one of ubx_results values.
+ */
+uint8_t ubx_feed(struct ubx *ctx, uint8_t byte)
+{
+	switch (ctx->state)
+	{
+	case UBX_SYNC_1:
+		if (byte == UBX_SYNC_CHAR_1)
+		{
+			ctx->state = UBX_SYNC_2;
+		}
+		return UBX_NONE;
+
+	case UBX_SYNC_2:
+		if (byte == UBX_SYNC_CHAR_2)
+		{
+			ctx->ck_a = 0;
+			ctx->ck_b = 0;
+			ctx->state = UBX_CLASS;
+		}
+		else if (byte != UBX_SYNC_CHAR_1)
+		{
+			ctx->state = UBX_SYNC_1;
+		}
+		return UBX_NONE;
+
+	case UBX_CK_A:
+		ctx->state = byte == ctx->ck_a ? UBX_CK_B : UBX_SYNC_1;
+		return byte == ctx->ck_a ? UBX_NONE : UBX_REJECT_CHECKSUM;
+
+	case UBX_CK_B:
+		ctx->state = UBX_SYNC_1;
+		if (byte != ctx->ck_b)
+		{
+			return UBX_REJECT_CHECKSUM;
+		}
+		return decode(ctx);
+	}
+
+	/* Class, ID, length and payload are covered by the checksum. */
+	ctx->ck_a += byte;
+	ctx->ck_b += ctx->ck_a;
+
+	switch (ctx->state)
+	{
+	case UBX_CLASS:
+		ctx->msg_class = byte;
+		ctx->state = UBX_ID;
+		break;
+
+	case UBX_ID:
+		ctx->msg_id = byte;
+		ctx->state = UBX_LENGTH_1;
+		break;
+
+	case UBX_LENGTH_1:
+		ctx->length = byte;
+		ctx->state = UBX_LENGTH_2;
+		break;
+
+	case UBX_LENGTH_2:
+		ctx->length |= (uint16_t) byte << 8;
+		ctx->pos = 0;
+		ctx->state = ctx->length ? UBX_PAYLOAD : UBX_CK_A;
+		break;
+
+	case UBX_PAYLOAD:
+		if (ctx->pos < UBX_PAYLOAD_SIZE)
+		{
+			ctx->payload[ctx->pos] = byte;
+		}
+		if (++ctx->pos == ctx->length)
+		{
+			ctx->state = UBX_CK_A;
+		}
+		break;
+	}
+	return UBX_NONE;
+}
+
+/*
+ * Function: msg_bit
+ * -----------------
+ *   Identifies the received message.
+ *
+ *   returns:	UBX_MSG_* bit of the message, 0 if it isn't decoded or
+ *   			its length is wrong.
+ */
+static uint8_t msg_bit(const struct ubx *ctx)
+{
+	if (ctx->msg_class != UBX_CLASS_NAV)
+	{
+		return 0;
+	}
+	switch (ctx->msg_id)
+	{
+	case UBX_NAV_POSLLH:
+		return ctx->length == UBX_POSLLH_LEN ? UBX_MSG_POSLLH : 0;
+	case UBX_NAV_SOL:
+		return ctx->length == UBX_SOL_LEN ? UBX_MSG_SOL : 0;
+	case UBX_NAV_VELNED:
+		return ctx->length == UBX_VELNED_LEN ? UBX_MSG_VELNED : 0;
+	case UBX_NAV_TIMEUTC:
+		return ctx->length == UBX_TIMEUTC_LEN ? UBX_MSG_TIMEUTC : 0;
+	case UBX_NAV_DOP:
+		return ctx->length == UBX_DOP_LEN ? UBX_MSG_DOP : 0;
+	}
+	return 0;
+}
+
+/*
+ * Function: decode
+ * ----------------
+ *   Copies the fields of a received message to ctx->fix. All the NAV
+ *   messages start with iTOW. A message with a new iTOW starts a new
+ *   epoch.
+ *
+ *   returns:	UBX_EPOCH if all the messages of the epoch were received,
+ *   			UBX_MESSAGE if not yet, UBX_ACK or UBX_NAK for
+ *   			acknowledgements, UBX_REJECT_TYPE if the message isn't
+ *   			decoded.
+ */
+static uint8_t decode(struct ubx *ctx)
+{
+	struct gps_fix *fix = &ctx->fix;
+	const uint8_t *p = ctx->payload;
+	uint8_t bit = msg_bit(ctx);
+	uint32_t itow;
+
+	if (ctx->msg_class == UBX_CLASS_ACK && ctx->length == UBX_ACK_LEN)
+	{
+		return ctx->msg_id == UBX_ACK_ACK ? UBX_ACK : UBX_NAK;
+	}
+	if (bit == 0)
+	{
+		return UBX_REJECT_TYPE;
+	}
+	itow = get_u32(p);
+	if (itow != fix->itow)
+	{
+		fix->itow = itow;
+		ctx->epoch_msgs = 0;
+	}
+
+	switch (bit)
+	{
+	case UBX_MSG_POSLLH:
+		fix->lon = (int32_t) get_u32(p + 4);
+		fix->lat = (int32_t) get_u32(p + 8);
+		fix->height = (int32_t) get_u32(p + 12);
+		fix->hmsl = (int32_t) get_u32(p + 16);
+		break;
+	case UBX_MSG_SOL:
+		fix->fix_type = p[10];
+		fix->fix_flags = p[11];
+		fix->num_sv = p[47];
+		break;
+	case UBX_MSG_VELNED:
+		fix->gspeed = get_u32(p + 20);
+		fix->heading = (int32_t) get_u32(p + 24);
+		break;
+	case UBX_MSG_TIMEUTC:
+		fix->year = get_u16(p + 12);
+		fix->month = p[14];
+		fix->day = p[15];
+		fix->hour = p[16];
+		fix->min = p[17];
+		fix->sec = p[18];
+		fix->time_valid = p[19];
+		break;
+	case UBX_MSG_DOP:
+		fix->hdop = get_u16(p + 12);
+		break;
+	}
+
+	/* Report a complete epoch once even if a message is repeated. */
+	if (ctx->epoch_msgs & bit)
+	{
+		return UBX_MESSAGE;
+	}
+	ctx->epoch_msgs |= bit;
+	return ctx->epoch_msgs == UBX_MSG_EPOCH ? UBX_EPOCH : UBX_MESSAGE;
+}
+
+static uint16_t get_u16(const uint8_t *p)
+{
+	return p[0] | (uint16_t) p[1] << 8;
+}
+
+static uint32_t get_u32(const uint8_t *p)
+{
+	return get_u16(p) | (uint32_t) get_u16(p + 2) << 16;
+}
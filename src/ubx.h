@@ -0,0 +1,99 @@
+/*
+ * ubx.h
+ *
+ *  Created on: 16 Oct 2026
+ *  Author: Dmitry Melnichansky / 4Z7DTF
+ *
+ *  Hardware independent u-blox UBX input. Bytes received from the GPS are
+ *  fed one by one with ubx_feed(). NAV-POSLLH, NAV-DOP, NAV-SOL,
+ *  NAV-VELNED and NAV-TIMEUTC payloads are decoded into ctx->fix. When all of them were
+ *  received for the same epoch ubx_feed() returns UBX_EPOCH and the fix
+ *  can be rendered. ACK-ACK and ACK-NAK are reported with the class and
+ *  ID of the acknowledged message in ctx->payload[0] and [1]. Other
+ *  messages and bytes outside UBX frames, such as NMEA sentences, are
+ *  skipped.
+ */
+
+#ifndef UBX_H_
+#define UBX_H_
+
+#include <stdint.h>
+#include "../src/gps_fix.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define UBX_SYNC_CHAR_1 0xB5
+#define UBX_SYNC_CHAR_2 0x62
+
+#define UBX_CLASS_NAV 0x01
+#define UBX_NAV_POSLLH 0x02
+#define UBX_NAV_DOP 0x04
+#define UBX_NAV_SOL 0x06
+#define UBX_NAV_VELNED 0x12
+#define UBX_NAV_TIMEUTC 0x21
+
+#define UBX_CLASS_ACK 0x05
+#define UBX_ACK_NAK 0x00
+#define UBX_ACK_ACK 0x01
+
+#define UBX_CLASS_CFG 0x06
+#define UBX_CFG_PRT 0x00
+#define UBX_CFG_MSG 0x01
+#define UBX_CFG_RATE 0x08
+
+#define UBX_CLASS_AID 0x0B
+#define UBX_AID_INI 0x01
+
+#define UBX_PAYLOAD_SIZE 52 /* Largest decoded payload, NAV-SOL. */
+
+/* Results of ubx_feed(). */
+enum ubx_results
+{
+	UBX_NONE, /* Byte processed, nothing to report. */
+	UBX_EPOCH, /* All the messages of an epoch received, ctx->fix is complete. */
+	UBX_MESSAGE, /* A message was decoded, the epoch isn't complete yet. */
+	UBX_REJECT_TYPE, /* Message isn't decoded or has unexpected length. */
+	UBX_REJECT_CHECKSUM, /* Checksum mismatch. */
+	UBX_ACK, /* ACK-ACK received. */
+	UBX_NAK, /* ACK-NAK received. */
+};
+
+/* Receiver states. */
+enum ubx_states
+{
+	UBX_SYNC_1, /* Waiting for the first sync character. */
+	UBX_SYNC_2,
+	UBX_CLASS,
+	UBX_ID,
+	UBX_LENGTH_1,
+	UBX_LENGTH_2,
+	UBX_PAYLOAD,
+	UBX_CK_A,
+	UBX_CK_B,
+};
+
+/* UBX input context. */
+struct ubx
+{
+	uint8_t state; /* Current receiver state. */
+	uint8_t msg_class;
+	uint8_t msg_id;
+	uint16_t length; /* Payload length. */
+	uint16_t pos; /* Payload bytes received. */
+	uint8_t ck_a; /* Fletcher checksum of class, ID, length and payload. */
+	uint8_t ck_b;
+	uint8_t epoch_msgs; /* UBX_MSG_* bits of the messages received for fix.itow. */
+	uint8_t payload[UBX_PAYLOAD_SIZE];
+	struct gps_fix fix;
+};
+
+void ubx_init(struct ubx *ctx);
+uint8_t ubx_feed(struct ubx *ctx, uint8_t byte);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UBX_H_ */
@@ -0,0 +1,438 @@
+/*
+ * vx8_bridge.c
+ *
+ *  Created on: 16 Oct 2026
+ *  Author: Dmitry Melnichansky / 4Z7DTF
+ *
+ *  The bytes read from the GPS are fed to the transform one by one like
+ *  the firmware does, so sentences are checked and reformatted by the same
+ *  process_field() and RX_CHECKSUM handling. The frames of one read are
+ *  queued to all sinks and then each sink is written until its port
+ *  would block, after which the sink waits for EPOLLOUT. When a queue is
+ *  full the oldest frame is dropped, or the one after it if the oldest is
+ *  partly written, so a sink never gets a truncated sentence. When the
+ *  source ends the queues are written out and vx8_bridge_run() returns.
+ *  A sink which doesn't take its queue within drain_ms, e.g. a radio
+ *  holding the line with flow control, is closed so it can't keep the
+ *  bridge running.
+ */
+
+#if defined(__linux__) && !defined(VX8_CUT_THROUGH)
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <time.h>
+#include <unistd.h>
+#include "../src/vx8_bridge.h"
+
+#define SOURCE_ID UINT32_MAX
+#define READ_SIZE 4096
+#define MAX_EVENTS 64
+
+static void read_source(struct vx8_bridge *b);
+static void enqueue(struct vx8_bridge_sink *sink, unsigned queue_size, const struct vx8_frame *frame);
+static void flush(struct vx8_bridge *b, unsigned id);
+static void poll_out(struct vx8_bridge *b, unsigned id, uint8_t on);
+static void close_sink(struct vx8_bridge *b, unsigned id);
+static uint8_t idle(const struct vx8_bridge *b);
+static void close_stuck(struct vx8_bridge *b);
+static long long now_ms(void);
+static int set_nonblock(int fd);
+
+/*
+ * Function: vx8_bridge_init
+ * -------------------------
+ *   Initializes the bridge. The file descriptors are set non-blocking and
+ *   stay owned by the caller.
+ *
+ *   source_fd: GPS serial port or pty, opened for reading
+ *   sink_fds: serial ports or ptys of the radios, opened for writing
+ *   sink_count: number of sinks
+ *   queue_size: frames queued per sink, at least 2
+ *
+ *   returns:	0 on success, -1 with errno set on error.
+ */
+int vx8_bridge_init(struct vx8_bridge *b, int source_fd, const int sink_fds[], unsigned sink_count,
+		unsigned queue_size)
+{
+	struct epoll_event ev;
+
+	memset(b, 0, sizeof(*b));
+	vx8_init(&b->vx8, &b->frame);
+	b->source_fd = source_fd;
+	b->sink_count = sink_count;
+	b->queue_size = queue_size < 2 ? 2 : queue_size;
+	b->drain_ms = VX8_BRIDGE_DRAIN_MS;
+	b->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	if (b->epoll_fd < 0)
+	{
+		return -1;
+	}
+	b->sinks = calloc(sink_count, sizeof(b->sinks[0]));
+	if (b->sinks == NULL)
+	{
+		vx8_bridge_close(b);
+		return -1;
+	}
+
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.u32 = SOURCE_ID;
+	if (set_nonblock(source_fd) != 0 || epoll_ctl(b->epoll_fd, EPOLL_CTL_ADD, source_fd, &ev) != 0)
+	{
+		vx8_bridge_close(b);
+		return -1;
+	}
+	for (unsigned i = 0; i < sink_count; i++)
+	{
+		struct vx8_bridge_sink *sink = &b->sinks[i];
+
+		sink->fd = sink_fds[i];
+		sink->queue = malloc(b->queue_size * sizeof(sink->queue[0]));
+		/* Errors and hang-ups are reported without asking for them. */
+		ev.events = 0;
+		ev.data.u32 = i;
+		if (sink->queue == NULL || set_nonblock(sink->fd) != 0
+				|| epoll_ctl(b->epoll_fd, EPOLL_CTL_ADD, sink->fd, &ev) != 0)
+		{
+			vx8_bridge_close(b);
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/*
+ * Function: vx8_bridge_run
+ * ------------------------
+ *   Runs the bridge until the source ends and the queues are written, or
+ *   the stop flag is set by a signal handler. The queues are written for
+ *   at most drain_ms after the source ends, the sinks which still have
+ *   frames then are closed.
+ *
+ *   returns:	0 on success, -1 with errno set if epoll fails.
+ */
+int vx8_bridge_run(struct vx8_bridge *b)
+{
+	struct epoll_event events[MAX_EVENTS];
+	long long deadline = 0;
+
+	while (!b->stop && !(b->source_closed && idle(b)))
+	{
+		int timeout = -1;
+		int n;
+
+		if (b->source_closed)
+		{
+			long long left;
+			if (deadline == 0)
+			{
+				deadline = now_ms() + b->drain_ms;
+			}
+			left = deadline - now_ms();
+			if (left <= 0)
+			{
+				close_stuck(b);
+				break;
+			}
+			timeout = (int) left;
+		}
+		n = epoll_wait(b->epoll_fd, events, MAX_EVENTS, timeout);
+		if (n < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			return -1;
+		}
+		for (int i = 0; i < n; i++)
+		{
+			uint32_t id = events[i].data.u32;
+
+			if (id == SOURCE_ID)
+			{
+				read_source(b);
+			}
+			else if (b->sinks[id].closed)
+			{
+				continue;
+			}
+			else if (events[i].events & (EPOLLERR | EPOLLHUP))
+			{
+				close_sink(b, id);
+			}
+			else if (events[i].events & EPOLLOUT)
+			{
+				flush(b, id);
+			}
+		}
+	}
+	return 0;
+}
+
+/*
+ * Function: vx8_bridge_close
+ * --------------------------
+ *   Frees the queues and closes the epoll instance. The ports aren't
+ *   closed.
+ *
+ *   returns:	none
+ */
+void vx8_bridge_close(struct vx8_bridge *b)
+{
+	if (b->sinks)
+	{
+		for (unsigned i = 0; i < b->sink_count; i++)
+		{
+			free(b->sinks[i].queue);
+		}
+		free(b->sinks);
+		b->sinks = NULL;
+	}
+	if (b->epoll_fd >= 0)
+	{
+		close(b->epoll_fd);
+		b->epoll_fd = -1;
+	}
+}
+
+/*
+ * Function: read_source
+ * ---------------------
+ *   Reads what the GPS has sent, feeds it to the transform, queues the
+ *   frames to every sink and writes them. End of file and errors other
+ *   than EAGAIN end the source, e.g. EIO when the other side of a pty is
+ *   closed.
+ *
+ *   returns:	none
+ */
+static void read_source(struct vx8_bridge *b)
+{
+	uint8_t buffer[READ_SIZE];
+	ssize_t n = read(b->source_fd, buffer, sizeof(buffer));
+
+	if (n <= 0)
+	{
+		if (n < 0 && (errno == EAGAIN || errno == EINTR))
+		{
+			return;
+		}
+		epoll_ctl(b->epoll_fd, EPOLL_CTL_DEL, b->source_fd, NULL);
+		b->source_closed = 1;
+		return;
+	}
+	for (ssize_t i = 0; i < n; i++)
+	{
+		uint8_t res = vx8_feed(&b->vx8, buffer[i]);
+		if (res == VX8_NONE)
+		{
+			continue;
+		}
+		b->counts[res]++;
+		if (res == VX8_FRAME)
+		{
+			for (unsigned id = 0; id < b->sink_count; id++)
+			{
+				enqueue(&b->sinks[id], b->queue_size, &b->frame);
+			}
+		}
+	}
+	for (unsigned id = 0; id < b->sink_count; id++)
+	{
+		if (!b->sinks[id].closed && !b->sinks[id].polled)
+		{
+			flush(b, id);
+		}
+	}
+}
+
+/*
+ * Function: enqueue
+ * -----------------
+ *   Adds a frame to the queue of the sink. If the queue is full the oldest
+ *   frame is dropped, or the next one if the oldest is partly written.
+ *
+ *   returns:	none
+ */
+static void enqueue(struct vx8_bridge_sink *sink, unsigned queue_size, const struct vx8_frame *frame)
+{
+	struct vx8_bridge_frame *f;
+
+	if (sink->closed)
+	{
+		return;
+	}
+	if (sink->count == queue_size)
+	{
+		unsigned next = (sink->head + 1) % queue_size;
+		if (sink->sent)
+		{
+			/* Keep the partly written frame in place of the next one. */
+			sink->queue[next] = sink->queue[sink->head];
+		}
+		sink->head = next;
+		sink->count--;
+		sink->dropped++;
+	}
+	f = &sink->queue[(sink->head + sink->count) % queue_size];
+	f->len = frame->len;
+	memcpy(f->data, frame->buffer, frame->len);
+	sink->count++;
+	if (sink->count > sink->max_count)
+	{
+		sink->max_count = sink->count;
+	}
+}
+
+/*
+ * Function: flush
+ * ---------------
+ *   Writes the queued frames of the sink until its port would block.
+ *
+ *   returns:	none
+ */
+static void flush(struct vx8_bridge *b, unsigned id)
+{
+	struct vx8_bridge_sink *sink = &b->sinks[id];
+
+	while (sink->count > 0)
+	{
+		struct vx8_bridge_frame *f = &sink->queue[sink->head];
+		ssize_t n = write(sink->fd, f->data + sink->sent, f->len - sink->sent);
+		if (n < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			if (errno == EAGAIN)
+			{
+				poll_out(b, id, 1);
+			}
+			else
+			{
+				close_sink(b, id);
+			}
+			return;
+		}
+		sink->sent += (uint8_t) n;
+		if (sink->sent == f->len)
+		{
+			sink->sent = 0;
+			sink->head = (sink->head + 1) % b->queue_size;
+			sink->count--;
+			sink->frames++;
+		}
+	}
+	poll_out(b, id, 0);
+}
+
+/*
+ * Function: poll_out
+ * ------------------
+ *   Starts or stops waiting for the port of the sink to accept more.
+ *
+ *   returns:	none
+ */
+static void poll_out(struct vx8_bridge *b, unsigned id, uint8_t on)
+{
+	struct vx8_bridge_sink *sink = &b->sinks[id];
+	struct epoll_event ev;
+
+	if (sink->polled == on)
+	{
+		return;
+	}
+	memset(&ev, 0, sizeof(ev));
+	ev.events = on ? EPOLLOUT : 0;
+	ev.data.u32 = id;
+	epoll_ctl(b->epoll_fd, EPOLL_CTL_MOD, sink->fd, &ev);
+	sink->polled = on;
+}
+
+/*
+ * Function: close_sink
+ * --------------------
+ *   Stops serving a sink after a write error, hang-up or drain timeout.
+ *   Its queued frames are discarded and counted as dropped.
+ *
+ *   returns:	none
+ */
+static void close_sink(struct vx8_bridge *b, unsigned id)
+{
+	struct vx8_bridge_sink *sink = &b->sinks[id];
+
+	epoll_ctl(b->epoll_fd, EPOLL_CTL_DEL, sink->fd, NULL);
+	sink->closed = 1;
+	sink->dropped += sink->count;
+	sink->count = 0;
+	sink->sent = 0;
+}
+
+/*
+ * Function: idle
+ * --------------
+ *   returns:	1 if no sink has frames to write, 0 otherwise.
+ */
+static uint8_t idle(const struct vx8_bridge *b)
+{
+	for (unsigned i = 0; i < b->sink_count; i++)
+	{
+		if (!b->sinks[i].closed && b->sinks[i].count > 0)
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/*
+ * Function: close_stuck
+ * ---------------------
+ *   Closes the sinks which still have frames to write.
+ *
+ *   returns:	none
+ */
+static void close_stuck(struct vx8_bridge *b)
+{
+	for (unsigned i = 0; i < b->sink_count; i++)
+	{
+		if (!b->sinks[i].closed && b->sinks[i].count > 0)
+		{
+			close_sink(b, i);
+		}
+	}
+}
+
+/*
+ * Function: now_ms
+ * ----------------
+ *   returns:	monotonic time in milliseconds.
+ */
+static long long now_ms(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+}
+
+/*
+ * Function: set_nonblock
+ * ----------------------
+ *   returns:	0 on success, -1 with errno set on error.
+ */
+static int set_nonblock(int fd)
+{
+	int flags = fcntl(fd, F_GETFL);
+	if (flags < 0)
+	{
+		return -1;
+	}
+	return fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+#endif /* __linux__ && !VX8_CUT_THROUGH */
@@ -0,0 +1,76 @@
+/*
+ * vx8_bridge.h
+ *
+ *  Created on: 16 Oct 2026
+ *  Author: Dmitry Melnichansky / 4Z7DTF
+ *
+ *  Host only (Linux) bridge from one GPS to several radios and loggers.
+ *  The sentences read from the GPS serial port or pty are converted once
+ *  by the transform and every VX-8 frame is queued to each sink. A sink
+ *  has a bounded queue of whole frames, and when it is full the oldest
+ *  frame not being written is dropped, so a slow or stuck port loses its
+ *  own old frames and never delays the others. All ports are non-blocking
+ *  and served by one epoll loop. When the GPS ends the queues are written
+ *  out for at most drain_ms, then the sinks still holding frames are
+ *  closed. Not available with VX8_CUT_THROUGH.
+ */
+
+#ifndef VX8_BRIDGE_H_
+#define VX8_BRIDGE_H_
+
+#include <signal.h>
+#include <stdint.h>
+#include "../src/vx8_bulk.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define VX8_BRIDGE_QUEUE 16 /* Default frames queued per sink, about 3 seconds of GGA, RMC and ZDA. */
+#define VX8_BRIDGE_DRAIN_MS 3000 /* Default time to write the queues out after the source ends. */
+
+struct vx8_bridge_frame
+{
+	uint8_t len;
+	uint8_t data[VX8_BUFFER_SIZE];
+};
+
+struct vx8_bridge_sink
+{
+	int fd;
+	struct vx8_bridge_frame *queue;
+	unsigned head; /* Oldest frame. */
+	unsigned count;
+	unsigned max_count; /* Most frames queued at once. */
+	uint8_t sent; /* Bytes of the oldest frame already written. */
+	uint8_t polled; /* Waiting for the port to accept more. */
+	uint8_t closed; /* Write error or hang-up, no more frames are queued. */
+	unsigned long long frames; /* Frames written completely. */
+	unsigned long long dropped; /* Including the frames discarded when the sink is closed. */
+};
+
+struct vx8_bridge
+{
+	int epoll_fd;
+	int source_fd;
+	uint8_t source_closed;
+	struct vx8 vx8;
+	struct vx8_frame frame;
+	struct vx8_bridge_sink *sinks;
+	unsigned sink_count;
+	unsigned queue_size;
+	unsigned drain_ms; /* VX8_BRIDGE_DRAIN_MS unless changed before vx8_bridge_run(). */
+	unsigned long long counts[VX8_RESULT_COUNT]; /* Results of the transform other than VX8_NONE. */
+	volatile sig_atomic_t stop; /* Set by a signal handler to return from vx8_bridge_run(). */
+};
+
+int vx8_bridge_init(struct vx8_bridge *b, int source_fd, const int sink_fds[], unsigned sink_count,
+		unsigned queue_size);
+int vx8_bridge_run(struct vx8_bridge *b);
+void vx8_bridge_close(struct vx8_bridge *b);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VX8_BRIDGE_H_ */
@@ -0,0 +1,618 @@
+/*
+ * vx8_bulk.c
+ *
+ *  Created on: 16 Oct 2026
+ *  Author: Dmitry Melnichansky / 4Z7DTF
+ *
+ *  The fast path follows the byte by byte transform exactly. A sentence
+ *  is taken when it starts with $ and a 5 character address, has no $
+ *  before its *, and ends with two upper case hex digits, CR and LF. Its
+ *  fields are then reformatted in the output buffer in the order the
+ *  transform does it, with the same overflow checks at the same output
+ *  positions, so the same sentences are rejected for the same reasons.
+ *  Unsupported sentence types are skipped after their address, the next
+ *  $ is found by the kernel like the READY state finds it.
+ */
+
+#ifndef VX8_CUT_THROUGH
+
+#include <string.h>
+#include "../src/vx8_bulk.h"
+#include "../src/sentences.h"
+#include "../src/str_func.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <emmintrin.h>
+#define HAVE_X86 1
+#endif
+
+#define COMMA ','
+#define DOT '.'
+#define DOLLAR '$'
+#define ASTERISK '*'
+#define CR 0x0D
+#define LF 0x0A
+
+#define ADDRESS_LEN 7 /* $GPGGA, */
+#define TRAILER_LEN 5 /* *hh CR LF */
+#define MAX_SCAN 256 /* Longer sentences are left to the transform. */
+#define MAX_FIELDS 40
+#define MAX_DOTS 64
+#define WINDOW 32
+
+static const char hex_chars[16] = { '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F' };
+
+/* Positions of the characters of interest in a 32 byte window, bit i for
+ * byte i.
+ */
+struct masks
+{
+	uint32_t dollar;
+	uint32_t star;
+	uint32_t comma;
+	uint32_t dot;
+};
+
+/* Delimiters of the sentence being taken by the fast path, as offsets
+ * from its $.
+ */
+struct scan
+{
+	uint16_t star;
+	uint8_t comma_count;
+	uint8_t dot_count;
+	uint16_t commas[MAX_FIELDS];
+	uint16_t dots[MAX_DOTS];
+};
+
+static void masks_scalar(const uint8_t *, uint8_t, struct masks *);
+static uint8_t xor_scalar(const uint8_t *, size_t);
+#ifdef HAVE_X86
+static void masks_sse2(const uint8_t *, struct masks *);
+static uint8_t xor_sse2(const uint8_t *, size_t);
+#endif
+static void get_masks(const struct vx8_bulk *, const uint8_t *, const uint8_t *, struct masks *);
+static uint8_t get_xor(const struct vx8_bulk *, const uint8_t *, size_t);
+static const uint8_t *find_dollar(const struct vx8_bulk *, const uint8_t *, const uint8_t *);
+static uint8_t scan_sentence(const struct vx8_bulk *, const uint8_t *, const uint8_t *, struct scan *);
+static const uint8_t *fast_sentence(struct vx8_bulk *, const uint8_t *, const uint8_t *, uint8_t *, size_t *);
+static uint8_t convert(const uint8_t *, const struct scan *, uint8_t, char *, uint8_t *);
+static void feed_byte(struct vx8_bulk *, uint8_t, uint8_t *, size_t *);
+static uint8_t hex_value(uint8_t);
+
+/*
+ * Function: vx8_bulk_init
+ * -----------------------
+ *   Initializes the converter with the transform in READY state.
+ *
+ *   kernel: one of vx8_bulk_kernels
+ *
+ *   returns:	1 if the kernel can run on this CPU, 0 otherwise.
+ */
+uint8_t vx8_bulk_init(struct vx8_bulk *b, uint8_t kernel)
+{
+	memset(b, 0, sizeof(*b));
+	vx8_init(&b->vx8, &b->frame);
+#ifdef HAVE_X86
+	__builtin_cpu_init();
+	if (kernel == VX8_BULK_AUTO)
+	{
+		kernel = VX8_BULK_SSE2;
+	}
+	if (kernel == VX8_BULK_SSE2 && !__builtin_cpu_supports("sse2"))
+	{
+		return 0;
+	}
+#else
+	if (kernel == VX8_BULK_AUTO)
+	{
+		kernel = VX8_BULK_SCALAR;
+	}
+	if (kernel != VX8_BULK_SCALAR)
+	{
+		return 0;
+	}
+#endif
+	b->kernel = kernel;
+	return 1;
+}
+
+/*
+ * Function: vx8_bulk_kernel_name
+ * ------------------------------
+ *   returns:	name of the kernel.
+ */
+const char *vx8_bulk_kernel_name(uint8_t kernel)
+{
+	switch (kernel)
+	{
+	case VX8_BULK_SCALAR:
+		return "scalar";
+	case VX8_BULK_SSE2:
+		return "sse2";
+	}
+	return "auto";
+}
+
+/*
+ * Function: vx8_bulk_convert
+ * --------------------------
+ *   Converts a buffer of NMEA input. Stops when the input is done or the
+ *   output has less than VX8_BUFFER_SIZE bytes free. A sentence which
+ *   continues in the next buffer is carried over in the transform.
+ *
+ *   in: the input
+ *   len: its length
+ *   out: where to write the VX-8 sentences
+ *   out_size: size of out, at least VX8_BUFFER_SIZE
+ *   out_len: where to store the number of bytes written
+ *
+ *   returns:	number of input bytes converted.
+ */
+size_t vx8_bulk_convert(struct vx8_bulk *b, const uint8_t *in, size_t len, uint8_t *out, size_t out_size,
+		size_t *out_len)
+{
+	const uint8_t *p = in;
+	const uint8_t *end = in + len;
+	size_t o = 0;
+
+	while (p < end && out_size - o >= VX8_BUFFER_SIZE)
+	{
+		const uint8_t *next;
+
+		if (b->vx8.state != VX8_READY)
+		{
+			feed_byte(b, *p++, out, &o);
+			continue;
+		}
+		p = find_dollar(b, p, end);
+		if (p == end)
+		{
+			break;
+		}
+		next = fast_sentence(b, p, end, out, &o);
+		if (next)
+		{
+			p = next;
+		}
+		else
+		{
+			feed_byte(b, *p++, out, &o);
+		}
+	}
+	*out_len = o;
+	return (size_t) (p - in);
+}
+
+/*
+ * Function: fast_sentence
+ * -----------------------
+ *   Converts the sentence starting at p if it is well formed and complete.
+ *
+ *   returns:	pointer after the sentence, NULL if it has to be fed to the
+ *   			transform.
+ */
+static const uint8_t *fast_sentence(struct vx8_bulk *b, const uint8_t *p, const uint8_t *end, uint8_t *out,
+		size_t *out_len)
+{
+	struct scan scan;
+	const uint8_t *star;
+	uint8_t command;
+	uint8_t len;
+	uint8_t res;
+
+	if (end - p < ADDRESS_LEN || p[ADDRESS_LEN - 1] != COMMA)
+	{
+		return NULL;
+	}
+	for (uint8_t i = 1; i < ADDRESS_LEN - 1; i++)
+	{
+		if (p[i] == DOLLAR || p[i] == ASTERISK || p[i] == COMMA)
+		{
+			return NULL;
+		}
+	}
+	command = find_sentence((const char *) p + 3);
+	if (command == NO_SENTENCE)
+	{
+		/* READY skips the rest up to the next $. */
+		b->counts[VX8_REJECT_TYPE]++;
+		return p + ADDRESS_LEN;
+	}
+	if (!scan_sentence(b, p, end, &scan))
+	{
+		return NULL;
+	}
+	star = p + scan.star;
+	if (end - star < TRAILER_LEN || !hex_value(star[1]) || !hex_value(star[2]) || star[3] != CR || star[4] != LF)
+	{
+		return NULL;
+	}
+
+	res = convert(p, &scan, command, (char *) out + *out_len, &len);
+	if (res == VX8_FRAME)
+	{
+		uint8_t rx_checksum = (uint8_t) ((hex_value(star[1]) & 0x0F) << 4 | (hex_value(star[2]) & 0x0F));
+		if (rx_checksum != get_xor(b, p + 1, scan.star - 1))
+		{
+			res = VX8_REJECT_CHECKSUM;
+		}
+		else if (len + 3 >= VX8_BUFFER_SIZE)
+		{
+			/* No place for LF after the checksum and CR. */
+			res = VX8_REJECT_OVERFLOW;
+		}
+		else
+		{
+			char *o = (char *) out + *out_len;
+			uint8_t checksum = get_xor(b, (const uint8_t *) o + 1, len - 2);
+			o[len++] = hex_chars[(checksum & 0xF0) >> 4];
+			o[len++] = hex_chars[checksum & 0x0F];
+			o[len++] = CR;
+			o[len++] = LF;
+			*out_len += len;
+		}
+	}
+	b->counts[res]++;
+	b->fast++;
+	return star + TRAILER_LEN;
+}
+
+/*
+ * Function: convert
+ * -----------------
+ *   Reformats the fields of the sentence into o like process_field() does,
+ *   up to and including the *. The overflow checks are made at the
+ *   positions the transform makes them: at every received character of a
+ *   field, which lands at the output position of the field plus its
+ *   received length, and for the reformatted field.
+ *
+ *   p: the sentence
+ *   scan: its delimiters
+ *   command: index of the sentence in sentences[]
+ *   o: output, VX8_BUFFER_SIZE bytes
+ *   len: where to store the length written, up to the *
+ *
+ *   returns:	VX8_FRAME if the fields were converted and the checksum
+ *   			stage overflow checks pass, VX8_REJECT_* otherwise.
+ */
+static uint8_t convert(const uint8_t *p, const struct scan *scan, uint8_t command, char *o, uint8_t *len)
+{
+	const uint8_t *start = p + ADDRESS_LEN;
+	uint8_t pos = ADDRESS_LEN;
+	uint8_t field_num = 1;
+	uint8_t c = 0;
+	uint8_t d = 0;
+
+	memcpy(o, p, ADDRESS_LEN);
+	for (;;)
+	{
+		uint16_t field_end = c < scan->comma_count ? scan->commas[c] : scan->star;
+		uint8_t size = (uint8_t) (p + field_end - start);
+		uint8_t dot = VX8_NO_DOT;
+		struct field_spec spec;
+
+		while (d < scan->dot_count && p + scan->dots[d] < start)
+		{
+			d++;
+		}
+		if (d < scan->dot_count && scan->dots[d] < field_end)
+		{
+			dot = (uint8_t) (p + scan->dots[d] - start);
+		}
+		if (pos + size >= VX8_BUFFER_SIZE)
+		{
+			return VX8_REJECT_OVERFLOW;
+		}
+		memcpy(o + pos, start, size);
+		if (get_field_spec(command, field_num, &spec))
+		{
+			uint8_t new_size = size;
+			if (size == 0 && (spec.kind & FIELD_REJECT_EMPTY))
+			{
+				return VX8_REJECT_FIELD;
+			}
+			switch (spec.kind & FIELD_KIND_MASK)
+			{
+			case FIELD_DECIMAL:
+				new_size = spec.int_len + 1 + spec.frac_len;
+				break;
+			case FIELD_INT:
+				new_size = spec.int_len;
+				break;
+			case FIELD_CHAR:
+				new_size = size ? size : 1;
+				break;
+			}
+			if (pos + new_size >= VX8_BUFFER_SIZE)
+			{
+				return VX8_REJECT_OVERFLOW;
+			}
+			switch (spec.kind & FIELD_KIND_MASK)
+			{
+			case FIELD_DECIMAL:
+				format_decimal_field(o + pos, size, dot, spec.int_len, spec.frac_len);
+				break;
+			case FIELD_INT:
+				format_int_field(o + pos, size, spec.int_len);
+				break;
+			case FIELD_CHAR:
+				if (size == 0)
+				{
+					o[pos] = spec.def;
+				}
+				break;
+			}
+			size = new_size;
+		}
+		pos += size;
+		o[pos++] = c < scan->comma_count ? COMMA : ASTERISK;
+		if (c == scan->comma_count)
+		{
+			break;
+		}
+		start = p + field_end + 1;
+		field_num++;
+		c++;
+	}
+	*len = pos;
+	/* The checksum and CR follow *. vx8_feed() checks this at CR, before
+	 * the checksum is compared.
+	 */
+	if (pos + 3 > VX8_BUFFER_SIZE)
+	{
+		return VX8_REJECT_OVERFLOW;
+	}
+	return VX8_FRAME;
+}
+
+/*
+ * Function: scan_sentence
+ * -----------------------
+ *   Finds the *, the commas after the address and the decimal points of
+ *   the sentence, a window at a time.
+ *
+ *   returns:	1 if the * was found before any $, within MAX_SCAN bytes and
+ *   			with at most MAX_FIELDS fields, 0 otherwise.
+ */
+static uint8_t scan_sentence(const struct vx8_bulk *b, const uint8_t *p, const uint8_t *end, struct scan *scan)
+{
+	const uint8_t *limit = end - p > MAX_SCAN ? p + MAX_SCAN : end;
+
+	scan->comma_count = 0;
+	scan->dot_count = 0;
+	for (const uint8_t *w = p + ADDRESS_LEN; w < limit; w += WINDOW)
+	{
+		struct masks m;
+		uint32_t stop;
+		uint16_t base = (uint16_t) (w - p);
+
+		get_masks(b, w, limit, &m);
+		stop = m.dollar | m.star;
+		if (stop)
+		{
+			uint32_t below = (1UL << __builtin_ctz(stop)) - 1;
+			if (m.dollar & (below + 1))
+			{
+				return 0;
+			}
+			m.comma &= below;
+			m.dot &= below;
+		}
+		while (m.comma)
+		{
+			if (scan->comma_count == MAX_FIELDS)
+			{
+				return 0;
+			}
+			scan->commas[scan->comma_count++] = base + __builtin_ctz(m.comma);
+			m.comma &= m.comma - 1;
+		}
+		while (m.dot)
+		{
+			if (scan->dot_count == MAX_DOTS)
+			{
+				return 0;
+			}
+			scan->dots[scan->dot_count++] = base + __builtin_ctz(m.dot);
+			m.dot &= m.dot - 1;
+		}
+		if (stop)
+		{
+			scan->star = base + __builtin_ctz(stop);
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/*
+ * Function: find_dollar
+ * ---------------------
+ *   returns:	pointer to the first $ from p, end if there is none.
+ */
+static const uint8_t *find_dollar(const struct vx8_bulk *b, const uint8_t *p, const uint8_t *end)
+{
+	while (p < end)
+	{
+		struct masks m;
+		get_masks(b, p, end, &m);
+		if (m.dollar)
+		{
+			return p + __builtin_ctz(m.dollar);
+		}
+		p += WINDOW;
+	}
+	return end;
+}
+
+/*
+ * Function: feed_byte
+ * -------------------
+ *   Feeds one byte to the transform and copies a completed frame to the
+ *   output.
+ *
+ *   returns:	none
+ */
+static void feed_byte(struct vx8_bulk *b, uint8_t byte, uint8_t *out, size_t *out_len)
+{
+	uint8_t res = vx8_feed(&b->vx8, byte);
+
+	if (res == VX8_NONE)
+	{
+		return;
+	}
+	b->counts[res]++;
+	if (res == VX8_FRAME)
+	{
+		memcpy(out + *out_len, b->frame.buffer, b->frame.len);
+		*out_len += b->frame.len;
+	}
+}
+
+/*
+ * Function: hex_value
+ * -------------------
+ *   returns:	0x10 | value of an upper case hex digit, 0 for any other
+ *   			character.
+ */
+static uint8_t hex_value(uint8_t c)
+{
+	if (c >= '0' && c <= '9')
+	{
+		return 0x10 | (c - '0');
+	}
+	if (c >= 'A' && c <= 'F')
+	{
+		return 0x10 | (c - 'A' + 10);
+	}
+	return 0;
+}
+
+/*
+ * Function: get_masks
+ * -------------------
+ *   Fills the masks of the window at p with the kernel. A window which
+ *   would read past end is done by the scalar kernel.
+ *
+ *   returns:	none
+ */
+static void get_masks(const struct vx8_bulk *b, const uint8_t *p, const uint8_t *end, struct masks *m)
+{
+	if (end - p < WINDOW)
+	{
+		masks_scalar(p, (uint8_t) (end - p), m);
+		return;
+	}
+	switch (b->kernel)
+	{
+#ifdef HAVE_X86
+	case VX8_BULK_SSE2:
+		masks_sse2(p, m);
+		return;
+#endif
+	default:
+		masks_scalar(p, WINDOW, m);
+	}
+}
+
+static uint8_t get_xor(const struct vx8_bulk *b, const uint8_t *p, size_t len)
+{
+	switch (b->kernel)
+	{
+#ifdef HAVE_X86
+	case VX8_BULK_SSE2:
+		return xor_sse2(p, len);
+#endif
+	default:
+		return xor_scalar(p, len);
+	}
+}
+
+static void masks_scalar(const uint8_t *p, uint8_t len, struct masks *m)
+{
+	memset(m, 0, sizeof(*m));
+	for (uint8_t i = 0; i < len; i++)
+	{
+		uint32_t bit = 1UL << i;
+		switch (p[i])
+		{
+		case DOLLAR:
+			m->dollar |= bit;
+			break;
+		case ASTERISK:
+			m->star |= bit;
+			break;
+		case COMMA:
+			m->comma |= bit;
+			break;
+		case DOT:
+			m->dot |= bit;
+			break;
+		}
+	}
+}
+
+/* Eight bytes at a time. */
+static uint8_t xor_scalar(const uint8_t *p, size_t len)
+{
+	uint64_t acc = 0;
+	uint8_t res = 0;
+	size_t i = 0;
+
+	for (; i + 8 <= len; i += 8)
+	{
+		uint64_t w;
+		memcpy(&w, p + i, 8);
+		acc ^= w;
+	}
+	for (; i < len; i++)
+	{
+		res ^= p[i];
+	}
+	acc ^= acc >> 32;
+	acc ^= acc >> 16;
+	acc ^= acc >> 8;
+	return res ^ (uint8_t) acc;
+}
+
+#ifdef HAVE_X86
+__attribute__((target("sse2")))
+static uint32_t mask16(__m128i v, char c)
+{
+	return (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(c)));
+}
+
+__attribute__((target("sse2")))
+static void masks_sse2(const uint8_t *p, struct masks *m)
+{
+	__m128i lo = _mm_loadu_si128((const __m128i *) p);
+	__m128i hi = _mm_loadu_si128((const __m128i *) (p + 16));
+
+	m->dollar = mask16(lo, DOLLAR) | mask16(hi, DOLLAR) << 16;
+	m->star = mask16(lo, ASTERISK) | mask16(hi, ASTERISK) << 16;
+	m->comma = mask16(lo, COMMA) | mask16(hi, COMMA) << 16;
+	m->dot = mask16(lo, DOT) | mask16(hi, DOT) << 16;
+}
+
+__attribute__((target("sse2")))
+static uint8_t xor_sse2(const uint8_t *p, size_t len)
+{
+	__m128i acc = _mm_setzero_si128();
+	size_t i = 0;
+	uint64_t w;
+
+	for (; i + 16 <= len; i += 16)
+	{
+		acc = _mm_xor_si128(acc, _mm_loadu_si128((const __m128i *) (p + i)));
+	}
+	acc = _mm_xor_si128(acc, _mm_srli_si128(acc, 8));
+	_mm_storel_epi64((__m128i *) &w, acc);
+	w ^= w >> 32;
+	w ^= w >> 16;
+	w ^= w >> 8;
+	return (uint8_t) w ^ xor_scalar(p + i, len - i);
+}
+#endif
+
+#endif /* VX8_CUT_THROUGH */
@@ -0,0 +1,61 @@
+/*
+ * vx8_bulk.h
+ *
+ *  Created on: 16 Oct 2026
+ *  Author: Dmitry Melnichansky / 4Z7DTF
+ *
+ *  Host only bulk version of the transform for archived NMEA logs. A
+ *  buffer of input is converted at once: $, *, commas and decimal points
+ *  are found 32 bytes at a time with SSE2 and the checksum is computed
+ *  the same way. The fields are then reformatted by the same
+ *  field layouts and str_func.c routines as vx8_core.c uses. The output
+ *  and the result counts are the same as feeding every byte to
+ *  vx8_feed(): only complete, well formed sentences take the fast path,
+ *  anything else (sync errors, malformed checksums, a sentence cut by the
+ *  end of the buffer) is fed byte by byte to the transform in
+ *  struct vx8_bulk, which carries over to the next buffer.
+ *  Not built into the firmware, and not available with VX8_CUT_THROUGH.
+ */
+
+#ifndef VX8_BULK_H_
+#define VX8_BULK_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "../src/vx8_core.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define VX8_RESULT_COUNT (VX8_REJECT_SYNC + 1)
+
+/* Scanning kernels. VX8_BULK_AUTO takes SSE2 on x86 and the scalar one
+ * elsewhere.
+ */
+enum vx8_bulk_kernels
+{
+	VX8_BULK_AUTO,
+	VX8_BULK_SCALAR,
+	VX8_BULK_SSE2,
+};
+
+struct vx8_bulk
+{
+	struct vx8 vx8; /* Transform for the bytes off the fast path. */
+	struct vx8_frame frame;
+	uint8_t kernel; /* One of vx8_bulk_kernels, never VX8_BULK_AUTO. */
+	unsigned long long counts[VX8_RESULT_COUNT]; /* Results other than VX8_NONE, like vx8_feed() returns them. */
+	unsigned long long fast; /* Sentences taken by the fast path. */
+};
+
+uint8_t vx8_bulk_init(struct vx8_bulk *b, uint8_t kernel);
+size_t vx8_bulk_convert(struct vx8_bulk *b, const uint8_t *in, size_t len, uint8_t *out, size_t out_size,
+		size_t *out_len);
+const char *vx8_bulk_kernel_name(uint8_t kernel);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VX8_BULK_H_ */
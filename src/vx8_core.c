@@ -0,0 +1,593 @@
+/*
+ * vx8_core.c
+ *
+ *  Created on: 16 Oct 2026
+ *  Author: Dmitry Melnichansky / 4Z7DTF
+ *
+ *  The receive state machine and field processing moved from main.c.
+ *  All the state is kept in struct vx8, no hardware registers are used.
+ */
+
+#include <string.h>
+#include "../src/vx8_core.h"
+#include "../src/sentences.h"
+#include "../src/str_func.h"
+
+#define COMMA ','
+#define DOT '.'
+#define DOLLAR '$'
+#define ASTERISK '*'
+#define CR 0x0D
+#define LF 0x0A
+
+/* Green and red LED events of each sentence_leds value. */
+static const uint8_t sentence_leds[][2] = {
+	{ 0, 0 },
+	{ VX8_LED_GGA_GREEN, VX8_LED_GGA_RED },
+	{ VX8_LED_RMC_GREEN, VX8_LED_RMC_RED },
+};
+
+/* Lookup table for converting numerical values to hexadecimal digits. */
+static const char hex_chars[16] = { '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F' };
+
+static uint8_t feed(struct vx8 *, uint8_t);
+static void reset(struct vx8 *);
+static uint8_t restart(struct vx8 *, uint8_t, uint8_t);
+#ifdef VX8_CUT_THROUGH
+static uint8_t release(struct vx8 *);
+static void terminate(struct vx8 *);
+#endif
+static uint8_t process_field(struct vx8 *);
+static uint8_t field_len(const struct field_spec *, uint8_t);
+static void set_decimal_field(struct vx8 *, uint8_t, uint8_t);
+static void set_int_field(struct vx8 *, uint8_t);
+static void set_default_char(struct vx8 *, char);
+
+/*
+ * Function: vx8_init
+ * ------------------
+ *   Initializes the transform context.
+ *
+ *   ctx: the context
+ *   frame: frame for the first received sentence
+ *
+ *   returns:	none
+ */
+void vx8_init(struct vx8 *ctx, struct vx8_frame *frame)
+{
+	ctx->frame = frame;
+	ctx->leds = 0;
+#ifdef VX8_GPS_FIX
+	ctx->fix = 0;
+	ctx->fix_updated = 0;
+#endif
+	reset(ctx);
+}
+
+/*
+ * Function: vx8_set_frame
+ * -----------------------
+ *   Sets the frame for the next sentence. Called after vx8_feed() returned
+ *   VX8_FRAME and the complete frame was taken by the caller. If it isn't
+ *   called the same frame is reused.
+ *
+ *   returns:	none
+ */
+void vx8_set_frame(struct vx8 *ctx, struct vx8_frame *frame)
+{
+	ctx->frame = frame;
+}
+
+#ifdef VX8_GPS_FIX
+/*
+ * Function: vx8_set_fix
+ * ---------------------
+ *   Sets the fix read from the converted fields, NULL to stop reading it.
+ *
+ *   returns:	none
+ */
+void vx8_set_fix(struct vx8 *ctx, struct gps_fix *fix)
+{
+	ctx->fix = fix;
+}
+#endif
+
+/*
+ * Function: vx8_feed
+ * ------------------
+ *   Processes one received byte.
+ *
+ *   ctx: the context
+ *   byte: the received byte
+ *
+ *   returns:	one of vx8_results values. VX8_FRAME if a sentence was
+ *   			completed, VX8_REJECT_* if a sentence was discarded.
+ */
+uint8_t vx8_feed(struct vx8 *ctx, uint8_t byte)
+{
+#ifdef VX8_CUT_THROUGH
+	struct vx8_frame *frame = ctx->frame;
+
+	/* The released bytes were sent by the caller. Keep the rest. */
+	if (frame->len)
+	{
+		frame->pos -= frame->len;
+		memmove(frame->buffer, &frame->buffer[frame->len], frame->pos);
+		frame->len = 0;
+	}
+#endif
+	return feed(ctx, byte);
+}
+
+/*
+ * Function: feed
+ * --------------
+ *   The receive state machine. Processes one received byte.
+ *
+ *   returns:	one of vx8_results values.
+ */
+static uint8_t feed(struct vx8 *ctx, uint8_t byte)
+{
+	struct vx8_frame *frame = ctx->frame;
+
+	switch (ctx->state)
+	{
+	case VX8_READY:
+		/* READY: The system is ready to receive and remains is this state
+		 * until $ character is received.
+		 */
+		if (byte == DOLLAR)
+		{
+#ifdef VX8_CUT_THROUGH
+			frame->pos = frame->len; /* After the trailer of an aborted sentence. */
+#else
+			frame->pos = 0;
+#endif
+			frame->buffer[frame->pos] = byte;
+			frame->pos++;
+			ctx->state = VX8_RX_TYPE_DETECT;
+		}
+		break;
+
+	case VX8_RX_TYPE_DETECT:
+		/* RX_TYPE_DETECT: The system receives the first field of NMEA
+		 * sentence and when comma is received tries to detect sentence
+		 * type (GGA, RMC or ZDA). If supported sentence type is detected,
+		 * the state changes to RX_MESSAGE. Otherwise the system is reset
+		 * and returns to READY state.
+		 */
+		if (byte == DOLLAR || byte == ASTERISK)
+		{
+			return restart(ctx, byte, VX8_REJECT_SYNC);
+		}
+		if (frame->pos >= VX8_BUFFER_SIZE)
+		{
+			return restart(ctx, byte, VX8_REJECT_OVERFLOW);
+		}
+		frame->buffer[frame->pos] = byte;
+		frame->pos++;
+		ctx->calc_checksum ^= byte;
+		ctx->out_checksum ^= byte; /* Type field isn't changed. */
+
+		if (byte == COMMA)
+		{
+			/* Sentence type follows $ and two characters of talker ID.
+			 * Shorter type fields aren't checked because the buffer isn't
+			 * cleared between sentences.
+			 */
+			if (frame->pos > 3 + SENTENCE_TYPE_LEN)
+			{
+				ctx->command = find_sentence(&frame->buffer[3]);
+			}
+
+			if (ctx->command == NO_SENTENCE)
+			{
+				return restart(ctx, byte, VX8_REJECT_TYPE);
+			}
+			ctx->field_num++;
+			ctx->state = VX8_RX_MESSAGE;
+#ifdef VX8_GPS_FIX
+			if (ctx->fix)
+			{
+				ctx->next = *ctx->fix;
+			}
+#endif
+		}
+		break;
+
+	case VX8_RX_MESSAGE:
+		/* RX_MESSAGE: The system receives the message between $ and *
+		 * delimiters. NMEA sentence checksum is calculated on the fly.
+		 * Comma character marks end of field. Each time it is
+		 * received, the field is verified and changed to VX-8 specific
+		 * format if required. Changing the fields on the fly results
+		 * in getting a new VX-8 compatible message at the end of reception.
+		 * NMEA sentences with empty time fields are discarded. The system
+		 * stops receiving current sentence and returns to READY. This is
+		 * done to prevent sending false time to VX-8. Other empty fields
+		 * are filled with default values, in most cases zeros. That's why
+		 * VX-8 shows zeros in coordinate fields when GPS fix isn't acquired
+		 * or is lost.
+		 * When * character is received the state changes to RX_CHECKSUM.
+		 */
+		/* If received character is $ or the buffer is overflown,
+		 * reset and return to READY state.
+		 */
+		if (byte == DOLLAR)
+		{
+			return restart(ctx, byte, VX8_REJECT_SYNC);
+		}
+		if (frame->pos >= VX8_BUFFER_SIZE)
+		{
+			return restart(ctx, byte, VX8_REJECT_OVERFLOW);
+		}
+
+		/* Comma and marks end of field, asterisk marks end of message
+		 * which is also end of the last field.
+		 */
+		if (byte == COMMA || byte == ASTERISK)
+		{
+#ifdef VX8_GPS_FIX
+			uint8_t start = frame->pos - ctx->field_size;
+#endif
+			uint8_t res = process_field(ctx);
+			if (res != VX8_NONE)
+			{
+				return restart(ctx, byte, res);
+			}
+#ifdef VX8_GPS_FIX
+			/* The field is read as it was written to the frame. */
+			if (ctx->fix)
+			{
+				gps_fix_field(&ctx->next, ctx->command, ctx->field_num, &frame->buffer[start], frame->pos - start);
+			}
+#endif
+			/* Output checksum is updated with the final contents
+			 * of the field and the comma following it. Asterisk
+			 * isn't a part of the checksum.
+			 */
+			ctx->out_checksum ^= ctx->field_xor;
+			if (byte == COMMA)
+				ctx->out_checksum ^= COMMA;
+			ctx->field_num++;
+			ctx->field_size = 0;
+			ctx->field_dot = VX8_NO_DOT;
+			ctx->field_xor = 0x00;
+		}
+		else
+		{
+			if (byte == DOT && ctx->field_dot == VX8_NO_DOT)
+			{
+				ctx->field_dot = ctx->field_size;
+			}
+			ctx->field_xor ^= byte;
+			ctx->field_size++;
+		}
+
+		frame->buffer[frame->pos] = byte;
+		frame->pos++;
+
+		/* If end of message, change state to RX_CHECKSUM
+		 * without affecting the calculated checksum.
+		 */
+		if (byte == ASTERISK)
+		{
+			ctx->state = VX8_RX_CHECKSUM;
+		}
+		else
+		{
+			ctx->calc_checksum ^= byte;
+		}
+#ifdef VX8_CUT_THROUGH
+		if (byte == COMMA || byte == ASTERISK)
+		{
+			return release(ctx);
+		}
+#endif
+		break;
+
+	case VX8_RX_CHECKSUM:
+		/* RX_CHECKSUM: The system receives the checksum (first two bytes
+		 * after *). After CR (\r) character is received, the system
+		 * compares it to the calculated value. If two values match,
+		 * the checksum of the reformatted message is added to it.
+		 * Upon receiving the LF (\n) character which marks end of sentence
+		 * the frame is complete.
+		 */
+		/* If received character is $ or *, reset and return to READY state. */
+		if (byte == DOLLAR || byte == ASTERISK)
+		{
+			return restart(ctx, byte, VX8_REJECT_SYNC);
+		}
+		/* CR (\r) is received after the last character of checksum. */
+		if (byte == CR)
+		{
+			/* No place for the checksum and CR. */
+			if (frame->pos + 3 > VX8_BUFFER_SIZE)
+			{
+				return restart(ctx, byte, VX8_REJECT_OVERFLOW);
+			}
+			/* If match, add the new one, else reset. */
+			if (ctx->rx_checksum != ctx->calc_checksum)
+			{
+				return restart(ctx, byte, VX8_REJECT_CHECKSUM);
+			}
+			frame->buffer[frame->pos] = hex_chars[(ctx->out_checksum & 0xF0) >> 4];
+			frame->pos++;
+			frame->buffer[frame->pos] = hex_chars[ctx->out_checksum & 0x0F];
+			frame->pos++;
+			frame->buffer[frame->pos] = byte;
+			frame->pos++;
+		}
+		/* LF (\n) is the last symbol of NMEA message. */
+		else if (byte == LF)
+		{
+			if (frame->pos >= VX8_BUFFER_SIZE)
+			{
+				return restart(ctx, byte, VX8_REJECT_OVERFLOW);
+			}
+			frame->buffer[frame->pos] = byte;
+			frame->pos++;
+			frame->len = frame->pos;
+			frame->type = ctx->command;
+#ifdef VX8_GPS_FIX
+			ctx->fix_updated = ctx->fix && gps_fix_end(&ctx->next, ctx->command, ctx->field_num);
+			if (ctx->fix_updated)
+			{
+				*ctx->fix = ctx->next;
+			}
+#endif
+			reset(ctx);
+			return VX8_FRAME;
+		}
+		/* Characters 0-9 and A-F are converted to numbers and added to checksum.
+		 * Digit symbols have values 0x30-0x39. Capital letters start from 0x41.
+		 * If the received byte is a letter (val. 0x4X) we subtract 0x07
+		 * to convert the value to 0x3A-0x3F. Bitwise AND with 0x0F converts
+		 * the value to 0x00-0x0F.
+		 * Previous value of the received checksum is rotated 4 bits left. If the first
+		 * byte of the checksum was received, the value is 0x00 and isn't affected.
+		 * If the second byte is received, the value 0x0X becomes 0xX0 leaving a
+		 * place for the second digit.
+		 */
+		else
+		{
+			uint8_t val = byte;
+			if (val & 0x40)
+				val -= 0x07;
+			val &= 0x0F;
+			ctx->rx_checksum <<= 4;
+			ctx->rx_checksum |= val;
+		}
+		break;
+	}
+	return VX8_NONE;
+}
+
+/*
+ * Function: reset
+ * ---------------
+ *   Resets the receiver to READY state. The frame isn't changed.
+ *
+ *   returns:	none
+ */
+static void reset(struct vx8 *ctx)
+{
+	ctx->state = VX8_READY;
+	ctx->calc_checksum = 0x00;
+	ctx->rx_checksum = 0x00;
+	ctx->out_checksum = 0x00;
+	ctx->command = NO_SENTENCE;
+	ctx->field_num = 0;
+	ctx->field_size = 0;
+	ctx->field_dot = VX8_NO_DOT;
+	ctx->field_xor = 0x00;
+}
+
+/*
+ * Function: restart
+ * -----------------
+ *   Discards the sentence being received. The byte which caused it is
+ *   processed in READY state, so $ starting a new sentence isn't lost.
+ *
+ *   byte: the byte which caused the sentence to be discarded
+ *   reason: one of VX8_REJECT_* values
+ *
+ *   returns:	reason
+ */
+static uint8_t restart(struct vx8 *ctx, uint8_t byte, uint8_t reason)
+{
+#ifdef VX8_CUT_THROUGH
+	terminate(ctx);
+#endif
+	reset(ctx);
+	feed(ctx, byte);
+	return reason;
+}
+
+#ifdef VX8_CUT_THROUGH
+/*
+ * Function: release
+ * -----------------
+ *   Releases the processed part of the sentence for sending.
+ *
+ *   returns:	VX8_FIELD
+ */
+static uint8_t release(struct vx8 *ctx)
+{
+	ctx->frame->len = ctx->frame->pos;
+	return VX8_FIELD;
+}
+
+/*
+ * Function: terminate
+ * -------------------
+ *   Replaces the unreleased part of a discarded sentence with a trailer
+ *   whose checksum doesn't match the released part, if the start of the
+ *   sentence was already released. The trailer is released for sending.
+ *
+ *   returns:	none
+ */
+static void terminate(struct vx8 *ctx)
+{
+	struct vx8_frame *frame = ctx->frame;
+	uint8_t checksum = ~ctx->out_checksum;
+
+	/* Fields are released after the time field is processed. */
+	if (ctx->state < VX8_RX_MESSAGE || (ctx->state == VX8_RX_MESSAGE && ctx->field_num < 2))
+	{
+		return;
+	}
+	frame->pos = 0;
+	if (ctx->state == VX8_RX_MESSAGE)
+	{
+		frame->buffer[frame->pos++] = ASTERISK;
+	}
+	frame->buffer[frame->pos++] = hex_chars[(checksum & 0xF0) >> 4];
+	frame->buffer[frame->pos++] = hex_chars[checksum & 0x0F];
+	frame->buffer[frame->pos++] = CR;
+	frame->buffer[frame->pos++] = LF;
+	frame->len = frame->pos;
+}
+#endif
+
+/*
+ * Function: process_field
+ * -----------------------
+ *   Changes the last received field to VX-8 specific format according
+ *   to its layout in sentences[]. Sentences with empty fields which have
+ *   FIELD_REJECT_EMPTY flag (time fields) are discarded. Other empty
+ *   fields are filled with default values.
+ *
+ *   returns:	VX8_NONE if the field was valid, VX8_REJECT_FIELD if the message
+ *   			has to be discarded due to current field's value,
+ *   			VX8_REJECT_OVERFLOW if the new field doesn't fit into the frame.
+ */
+static uint8_t process_field(struct vx8 *ctx)
+{
+	struct field_spec spec;
+
+	if (!get_field_spec(ctx->command, ctx->field_num, &spec))
+	{
+		return VX8_NONE;
+	}
+
+	const uint8_t *leds = sentence_leds[get_sentence_leds(ctx->command)];
+	if (ctx->field_size == 0 && (spec.kind & FIELD_REJECT_EMPTY))
+	{
+		ctx->leds |= leds[1]; /* Red LED on. */
+		return VX8_REJECT_FIELD;
+	}
+	if (spec.kind & FIELD_FIX_LED)
+	{
+		ctx->leds |= (ctx->field_size == 0) ? leds[1] : leds[0]; /* Red or green LED on. */
+	}
+
+	/* The new field and the delimiter following it must fit into the frame. */
+	if (ctx->frame->pos - ctx->field_size + field_len(&spec, ctx->field_size) >= VX8_BUFFER_SIZE)
+	{
+		return VX8_REJECT_OVERFLOW;
+	}
+
+	switch (spec.kind & FIELD_KIND_MASK)
+	{
+	case FIELD_DECIMAL:
+		set_decimal_field(ctx, spec.int_len, spec.frac_len);
+		break;
+	case FIELD_INT:
+		set_int_field(ctx, spec.int_len);
+		break;
+	case FIELD_CHAR:
+		set_default_char(ctx, spec.def);
+		break;
+	}
+	return VX8_NONE;
+}
+
+/*
+ * Function: field_len
+ * -------------------
+ *   Calculates length of a field after it is processed.
+ *
+ *   spec: layout of the field
+ *   size: size of the received field
+ *
+ *   returns:	the new field length.
+ */
+static uint8_t field_len(const struct field_spec *spec, uint8_t size)
+{
+	switch (spec->kind & FIELD_KIND_MASK)
+	{
+	case FIELD_DECIMAL:
+		return spec->int_len + 1 + spec->frac_len;
+	case FIELD_INT:
+		return spec->int_len;
+	case FIELD_CHAR:
+		return size ? size : 1;
+	}
+	return size;
+}
+
+/*
+ * Function: set_decimal_field
+ * ---------------------------
+ *   Sets size of the last received field containing a decimal number.
+ *
+ *   int_len: the new length of the integer part
+ *   frac_len: the new length of the fractional part
+ *
+ *   returns:	none
+ */
+static void set_decimal_field(struct vx8 *ctx, uint8_t int_len, uint8_t frac_len)
+{
+	struct vx8_frame *frame = ctx->frame;
+	/* A field of the new shape is kept, field_xor is its checksum. */
+	if (ctx->field_dot == int_len && ctx->field_size == int_len + 1 + frac_len)
+	{
+		return;
+	}
+	frame->pos -= ctx->field_size;
+	ctx->field_xor = format_decimal_field(&frame->buffer[frame->pos], ctx->field_size, ctx->field_dot, int_len, frac_len);
+	frame->pos += int_len + 1 + frac_len;
+}
+
+/*
+ * Function: set_int_field
+ * -----------------------
+ *   Sets size of the last received field containing an integer.
+ *
+ *   len: required field length
+ *
+ *   returns:	none
+ */
+static void set_int_field(struct vx8 *ctx, uint8_t len)
+{
+	struct vx8_frame *frame = ctx->frame;
+	if (ctx->field_size == len)
+	{
+		return;
+	}
+	frame->pos -= ctx->field_size;
+	ctx->field_xor = format_int_field(&frame->buffer[frame->pos], ctx->field_size, len);
+	frame->pos += len;
+}
+
+/*
+ * Function: set_default_char
+ * --------------------------
+ *   Sets the last received field to the given character if it is empty.
+ *
+ *   c: the default character
+ *
+ *   returns:	none
+ */
+static void set_default_char(struct vx8 *ctx, char c)
+{
+	if (ctx->field_size == 0)
+	{
+		struct vx8_frame *frame = ctx->frame;
+		frame->buffer[frame->pos] = c;
+		frame->pos++;
+		ctx->field_xor = c;
+	}
+}
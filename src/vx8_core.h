@@ -0,0 +1,125 @@
+/*
+ * vx8_core.h
+ *
+ *  Created on: 16 Oct 2026
+ *  Author: Dmitry Melnichansky / 4Z7DTF
+ *
+ *  Hardware independent NMEA to Yaesu VX-8 transform. Bytes received from
+ *  the GPS are fed one by one with vx8_feed(). Supported sentences are
+ *  reformatted in place in the current frame. When a sentence is complete
+ *  vx8_feed() returns VX8_FRAME and the frame is ready to be sent.
+ *
+ *  Cut-through mode is selected by building everything with VX8_CUT_THROUGH
+ *  defined. Every field is released as soon as it is processed: after each
+ *  call of vx8_feed() the caller sends frame->len bytes from the start of
+ *  the frame, if there are any, before feeding the next byte. The frame
+ *  holds only the part of the sentence not released yet. Output starts
+ *  after the time field, so sentences with empty time are still discarded
+ *  silently. A sentence discarded after its start was released (checksum
+ *  mismatch, overflow, lost sync) is terminated with an invalid checksum
+ *  and VX-8 ignores it.
+ *
+ *  With a fix set by vx8_set_fix() the converted fields of GGA, RMC and
+ *  ZDA are also read into the fix by gps_fix.c, so the caller gets the
+ *  values without parsing the frame again. The fix is updated when
+ *  vx8_feed() returns VX8_FRAME and sets ctx->fix_updated.
+ */
+
+#ifndef VX8_CORE_H_
+#define VX8_CORE_H_
+
+#include <stdint.h>
+
+/* The fix is read on the host and by the firmware options which use it. */
+#if !defined(__AVR__) || defined(VX8_LAST_FIX) || defined(VX8_NMEA_OUTPUT) || defined(VX8_TRACK_LOG)
+#define VX8_GPS_FIX
+#include "../src/gps_fix.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Different sources state that maximum sentence length is 80 characters
+ * plus CR and LF. Actual Yaesu FGPS-2 GPS output shows that this standard
+ * is ignored and GGA message reaches 86 symbols. That's why the buffer sizes
+ * are limited to 90 characters instead of 82.
+ */
+#ifdef VX8_CUT_THROUGH
+/* Type field, the time field and an aborted sentence trailer. */
+#define VX8_BUFFER_SIZE 32
+#else
+#define VX8_BUFFER_SIZE 90
+#endif
+#define VX8_NO_DOT 0xFF
+
+/* Status LED events. Set in vx8.leds by vx8_feed() and cleared by the caller. */
+#define VX8_LED_GGA_GREEN 0x01 /* GGA sentence valid */
+#define VX8_LED_GGA_RED 0x02 /* GGA sentence invalid */
+#define VX8_LED_RMC_GREEN 0x04 /* RMC sentence valid */
+#define VX8_LED_RMC_RED 0x08 /* RMC sentence invalid */
+
+/* Results of vx8_feed(). */
+enum vx8_results
+{
+	VX8_NONE, /* Byte processed, nothing to report. */
+	VX8_FRAME, /* Sentence complete. frame->len bytes are ready to be sent. */
+	VX8_FIELD, /* Cut-through mode: frame->len bytes of the sentence are ready to be sent. */
+	VX8_REJECT_TYPE, /* Sentence type isn't supported. */
+	VX8_REJECT_FIELD, /* A field has a value which discards the sentence (empty time). */
+	VX8_REJECT_OVERFLOW, /* Sentence (cut-through mode: field) is longer than VX8_BUFFER_SIZE. */
+	VX8_REJECT_CHECKSUM, /* Checksum mismatch. */
+	VX8_REJECT_SYNC, /* $ or * received in the middle of a sentence. */
+};
+
+/* Receiver states. */
+enum vx8_states
+{
+	VX8_READY, /* Default state, ready to receive. Changes if $ is received. */
+	VX8_RX_TYPE_DETECT, /* Detecting message type (RMC, GGA etc.) Changes if comma is received. */
+	VX8_RX_MESSAGE, /* Receiving the message between the $ and * delimiters. */
+	VX8_RX_CHECKSUM, /* Receiving the checksum. Changes if \r\n  is received. */
+};
+
+/* Sentence buffer. */
+struct vx8_frame
+{
+	char buffer[VX8_BUFFER_SIZE];
+	uint8_t pos;
+	uint8_t len; /* Length of a complete sentence. */
+	uint8_t type; /* Type of a complete sentence. Index in sentences[]. */
+};
+
+/* Transform context. */
+struct vx8
+{
+	struct vx8_frame *frame; /* Frame being received. */
+	uint8_t state; /* Current receiver state. */
+	uint8_t command; /* NMEA command being received. Index in sentences[], NO_SENTENCE if unknown. */
+	uint8_t field_num; /* Current field of NMEA command. */
+	uint8_t field_size; /* Current field size. */
+	uint8_t field_dot; /* Position of the decimal point in the current field, VX8_NO_DOT if none. */
+	uint8_t field_xor; /* XOR of the current field characters. */
+	uint8_t calc_checksum; /* Calculated checksum of the received message. Calculated on the fly. */
+	uint8_t rx_checksum; /* Checksum of the received NMEA sentence. */
+	uint8_t out_checksum; /* Checksum of the reformatted message. Updated after each field. */
+	uint8_t leds; /* VX8_LED_* events. */
+#ifdef VX8_GPS_FIX
+	struct gps_fix *fix; /* Fix updated by complete sentences, NULL if not read. */
+	struct gps_fix next; /* The fix with the fields of the sentence being received. */
+	uint8_t fix_updated; /* The last complete sentence updated the fix. */
+#endif
+};
+
+void vx8_init(struct vx8 *ctx, struct vx8_frame *frame);
+void vx8_set_frame(struct vx8 *ctx, struct vx8_frame *frame);
+#ifdef VX8_GPS_FIX
+void vx8_set_fix(struct vx8 *ctx, struct gps_fix *fix);
+#endif
+uint8_t vx8_feed(struct vx8 *ctx, uint8_t byte);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VX8_CORE_H_ */
@@ -0,0 +1,514 @@
+/*
+ * vx8_parallel.c
+ *
+ *  Created on: 16 Oct 2026
+ *  Author: Dmitry Melnichansky / 4Z7DTF
+ *
+ *  Chunk k covers the input from the first $ at or after k * chunk_size
+ *  to the first $ of the next chunk which has one, so a chunk without $
+ *  is empty and its bytes belong to the chunk before it. Any $ puts the
+ *  transform in RX_TYPE_DETECT with nothing else carried over, and the
+ *  transform left in another state than READY by the end of a chunk
+ *  rejects the sentence as out of sync on the $ starting the next one,
+ *  which is counted with the chunk.
+ *
+ *  The chunks are converted into a window of 4 output buffers per thread,
+ *  which the calling thread writes straight to out_fd as they complete in
+ *  order, so the input is only read where it is mapped and the output is
+ *  only written where it is converted. Chunk k is owned by thread
+ *  k % threads. A thread takes its own lowest chunk while it is in the
+ *  window, otherwise it steals the lowest chunk left in the window from
+ *  another thread, which keeps the window moving past a slow chunk. The
+ *  queue of a thread is only the number of its lowest chunk left, in a
+ *  cache line of its own, and the owner and the thieves take a chunk by
+ *  advancing it with compare and swap. Both take from the low end, the
+ *  high end is out of the window. The lock is only taken to sleep: by the
+ *  calling thread when the next chunk to write isn't done, woken by the
+ *  thread which finishes it, and by threads which find the window full,
+ *  woken when the window moves.
+ */
+
+#ifndef VX8_CUT_THROUGH
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "../src/vx8_parallel.h"
+
+#define WINDOW_PER_THREAD 4
+#define NO_CHUNK ((size_t) -1)
+#define WINDOW_FULL ((size_t) -2)
+#define CACHE_LINE 64
+
+struct slot
+{
+	uint8_t *buffer;
+	size_t size;
+	size_t len;
+	uint8_t done; /* Set by the converting thread, cleared by the writer. */
+	uint8_t used; /* The chunk has a $. */
+	unsigned long long counts[VX8_RESULT_COUNT];
+};
+
+/* Chunks left of a thread: next, next + threads, ... below chunk_count. */
+struct queue
+{
+	size_t next;
+	uint8_t pad[CACHE_LINE - sizeof(size_t)];
+};
+
+struct pool
+{
+	const uint8_t *in;
+	size_t len;
+	size_t chunk_size;
+	size_t chunk_count;
+	uint8_t kernel;
+	unsigned threads;
+	struct queue *queues;
+	struct slot *slots;
+	size_t window;
+	size_t written; /* Chunks written to the output. */
+	size_t writer_waits; /* Chunk the writer sleeps for, NO_CHUNK if awake. */
+	unsigned idle; /* Threads sleeping until the window moves. */
+	unsigned long long steals;
+	int error;
+	pthread_mutex_t lock;
+	pthread_cond_t done_cond;
+	pthread_cond_t space_cond;
+};
+
+struct worker
+{
+	struct pool *pool;
+	unsigned id;
+	pthread_t thread;
+};
+
+static void *work(void *arg);
+static size_t take(struct pool *pool, unsigned id, size_t written);
+static void wait_done(struct pool *pool, size_t chunk);
+static void finish(struct pool *pool, size_t chunk, int error);
+static void wait_space(struct pool *pool, size_t written);
+static void wake_all(struct pool *pool);
+static int convert_chunk(struct pool *pool, size_t chunk, struct slot *slot);
+static size_t chunk_start(const struct pool *pool, size_t chunk);
+static int write_all(int fd, const uint8_t *buffer, size_t len);
+
+/*
+ * Function: vx8_parallel_convert
+ * ------------------------------
+ *   Converts the input to VX-8 sentences with a pool of threads and writes
+ *   them to out_fd in order.
+ *
+ *   in: the input, e.g. a memory mapped NMEA log
+ *   len: its length
+ *   out_fd: file descriptor to write the VX-8 sentences to
+ *   threads: number of converting threads, at least 1
+ *   chunk_size: nominal size of a chunk, VX8_PARALLEL_CHUNK by default
+ *   kernel: one of vx8_bulk_kernels the CPU has
+ *   stats: where to store the result counts
+ *
+ *   returns:	0 on success, -1 with errno set if out of memory or the
+ *   			output can't be written.
+ */
+int vx8_parallel_convert(const uint8_t *in, size_t len, int out_fd, unsigned threads, size_t chunk_size,
+		uint8_t kernel, struct vx8_parallel_stats *stats)
+{
+	struct pool pool;
+	struct worker *workers;
+	unsigned started = 0;
+	int error = 0;
+
+	memset(stats, 0, sizeof(*stats));
+	memset(&pool, 0, sizeof(pool));
+	pool.in = in;
+	pool.len = len;
+	pool.chunk_size = chunk_size ? chunk_size : VX8_PARALLEL_CHUNK;
+	pool.chunk_count = (len + pool.chunk_size - 1) / pool.chunk_size;
+	pool.kernel = kernel;
+	pool.threads = threads ? threads : 1;
+	pool.window = (size_t) pool.threads * WINDOW_PER_THREAD;
+	pool.writer_waits = NO_CHUNK;
+	if (posix_memalign((void **) &pool.queues, CACHE_LINE, pool.threads * sizeof(pool.queues[0])) != 0)
+	{
+		pool.queues = NULL;
+	}
+	pool.slots = calloc(pool.window, sizeof(pool.slots[0]));
+	workers = calloc(pool.threads, sizeof(workers[0]));
+	if (pool.queues == NULL || pool.slots == NULL || workers == NULL)
+	{
+		free(pool.queues);
+		free(pool.slots);
+		free(workers);
+		errno = ENOMEM;
+		return -1;
+	}
+	for (unsigned i = 0; i < pool.threads; i++)
+	{
+		pool.queues[i].next = i;
+	}
+	pthread_mutex_init(&pool.lock, NULL);
+	pthread_cond_init(&pool.done_cond, NULL);
+	pthread_cond_init(&pool.space_cond, NULL);
+
+	for (; started < pool.threads; started++)
+	{
+		workers[started].pool = &pool;
+		workers[started].id = started;
+		if (pthread_create(&workers[started].thread, NULL, work, &workers[started]) != 0)
+		{
+			break;
+		}
+	}
+	if (started == 0)
+	{
+		error = EAGAIN;
+	}
+
+	/* Write the chunks in order as they complete. */
+	for (size_t chunk = 0; chunk < pool.chunk_count && !error; chunk++)
+	{
+		struct slot *slot = &pool.slots[chunk % pool.window];
+
+		wait_done(&pool, chunk);
+		error = __atomic_load_n(&pool.error, __ATOMIC_ACQUIRE);
+		if (error)
+		{
+			break;
+		}
+
+		if (write_all(out_fd, slot->buffer, slot->len) != 0)
+		{
+			error = errno;
+		}
+		for (unsigned i = 0; i < VX8_RESULT_COUNT; i++)
+		{
+			stats->counts[i] += slot->counts[i];
+		}
+		stats->chunks += slot->used;
+
+		slot->done = 0;
+		__atomic_store_n(&pool.written, chunk + 1, __ATOMIC_SEQ_CST);
+		if (error)
+		{
+			__atomic_store_n(&pool.error, error, __ATOMIC_SEQ_CST);
+			wake_all(&pool);
+		}
+		else if (__atomic_load_n(&pool.idle, __ATOMIC_SEQ_CST))
+		{
+			/* Only the threads which found the window full. */
+			pthread_mutex_lock(&pool.lock);
+			pthread_cond_broadcast(&pool.space_cond);
+			pthread_mutex_unlock(&pool.lock);
+		}
+	}
+
+	for (unsigned i = 0; i < started; i++)
+	{
+		pthread_join(workers[i].thread, NULL);
+	}
+	stats->steals = pool.steals;
+
+	for (size_t i = 0; i < pool.window; i++)
+	{
+		free(pool.slots[i].buffer);
+	}
+	free(pool.slots);
+	free(pool.queues);
+	free(workers);
+	pthread_cond_destroy(&pool.space_cond);
+	pthread_cond_destroy(&pool.done_cond);
+	pthread_mutex_destroy(&pool.lock);
+	if (error)
+	{
+		errno = error;
+		return -1;
+	}
+	return 0;
+}
+
+/*
+ * Function: work
+ * --------------
+ *   Converting thread. Takes chunks until none is left.
+ *
+ *   returns:	NULL
+ */
+static void *work(void *arg)
+{
+	struct worker *worker = arg;
+	struct pool *pool = worker->pool;
+
+	while (!__atomic_load_n(&pool->error, __ATOMIC_ACQUIRE))
+	{
+		size_t written = __atomic_load_n(&pool->written, __ATOMIC_SEQ_CST);
+		size_t chunk = take(pool, worker->id, written);
+
+		if (chunk == NO_CHUNK)
+		{
+			break;
+		}
+		if (chunk == WINDOW_FULL)
+		{
+			wait_space(pool, written);
+			continue;
+		}
+		finish(pool, chunk, convert_chunk(pool, chunk, &pool->slots[chunk % pool->window]));
+	}
+	return NULL;
+}
+
+/*
+ * Function: take
+ * --------------
+ *   Takes the next chunk for the thread: its own lowest chunk if it is in
+ *   the window, otherwise the lowest chunk left of all threads. Another
+ *   thread may take the same chunk first, then the choice is made again.
+ *
+ *   written: chunks written to the output when the thread looked
+ *
+ *   returns:	the chunk, WINDOW_FULL if the lowest chunk left is after
+ *   			the window, NO_CHUNK if all chunks are taken.
+ */
+static size_t take(struct pool *pool, unsigned id, size_t written)
+{
+	size_t limit = written + pool->window;
+
+	for (;;)
+	{
+		size_t chunk = __atomic_load_n(&pool->queues[id].next, __ATOMIC_ACQUIRE);
+		unsigned owner = id;
+
+		if (chunk >= pool->chunk_count || chunk >= limit)
+		{
+			chunk = NO_CHUNK;
+			for (unsigned i = 0; i < pool->threads; i++)
+			{
+				size_t next = __atomic_load_n(&pool->queues[i].next, __ATOMIC_ACQUIRE);
+				if (next < pool->chunk_count && next < chunk)
+				{
+					chunk = next;
+					owner = i;
+				}
+			}
+			if (chunk == NO_CHUNK)
+			{
+				return NO_CHUNK;
+			}
+			if (chunk >= limit)
+			{
+				return WINDOW_FULL;
+			}
+		}
+		if (__atomic_compare_exchange_n(&pool->queues[owner].next, &chunk, chunk + pool->threads, 0,
+				__ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+		{
+			if (owner != id)
+			{
+				__atomic_add_fetch(&pool->steals, 1, __ATOMIC_RELAXED);
+			}
+			return chunk;
+		}
+	}
+}
+
+/*
+ * Function: wait_done
+ * -------------------
+ *   Sleeps until the chunk is converted or a thread fails. Called by the
+ *   writing thread.
+ *
+ *   returns:	none
+ */
+static void wait_done(struct pool *pool, size_t chunk)
+{
+	struct slot *slot = &pool->slots[chunk % pool->window];
+
+	if (__atomic_load_n(&slot->done, __ATOMIC_ACQUIRE))
+	{
+		return;
+	}
+	pthread_mutex_lock(&pool->lock);
+	__atomic_store_n(&pool->writer_waits, chunk, __ATOMIC_SEQ_CST);
+	while (!__atomic_load_n(&slot->done, __ATOMIC_SEQ_CST) && !__atomic_load_n(&pool->error, __ATOMIC_SEQ_CST))
+	{
+		pthread_cond_wait(&pool->done_cond, &pool->lock);
+	}
+	__atomic_store_n(&pool->writer_waits, NO_CHUNK, __ATOMIC_RELAXED);
+	pthread_mutex_unlock(&pool->lock);
+}
+
+/*
+ * Function: finish
+ * ----------------
+ *   Marks the chunk converted and wakes the writing thread if it sleeps
+ *   for it. On error wakes all the threads so they stop.
+ *
+ *   error: the result of convert_chunk()
+ *
+ *   returns:	none
+ */
+static void finish(struct pool *pool, size_t chunk, int error)
+{
+	if (error)
+	{
+		__atomic_store_n(&pool->error, error, __ATOMIC_SEQ_CST);
+		wake_all(pool);
+		return;
+	}
+	__atomic_store_n(&pool->slots[chunk % pool->window].done, 1, __ATOMIC_SEQ_CST);
+	if (__atomic_load_n(&pool->writer_waits, __ATOMIC_SEQ_CST) == chunk)
+	{
+		pthread_mutex_lock(&pool->lock);
+		pthread_cond_signal(&pool->done_cond);
+		pthread_mutex_unlock(&pool->lock);
+	}
+}
+
+/*
+ * Function: wait_space
+ * --------------------
+ *   Sleeps until more chunks are written than the thread saw, so the
+ *   window has moved, or a thread fails.
+ *
+ *   written: chunks written to the output when the thread looked
+ *
+ *   returns:	none
+ */
+static void wait_space(struct pool *pool, size_t written)
+{
+	pthread_mutex_lock(&pool->lock);
+	__atomic_add_fetch(&pool->idle, 1, __ATOMIC_SEQ_CST);
+	while (__atomic_load_n(&pool->written, __ATOMIC_SEQ_CST) == written
+			&& !__atomic_load_n(&pool->error, __ATOMIC_SEQ_CST))
+	{
+		pthread_cond_wait(&pool->space_cond, &pool->lock);
+	}
+	__atomic_sub_fetch(&pool->idle, 1, __ATOMIC_SEQ_CST);
+	pthread_mutex_unlock(&pool->lock);
+}
+
+/*
+ * Function: wake_all
+ * ------------------
+ *   Wakes the sleeping threads after pool->error was set.
+ *
+ *   returns:	none
+ */
+static void wake_all(struct pool *pool)
+{
+	pthread_mutex_lock(&pool->lock);
+	pthread_cond_signal(&pool->done_cond);
+	pthread_cond_broadcast(&pool->space_cond);
+	pthread_mutex_unlock(&pool->lock);
+}
+
+/*
+ * Function: convert_chunk
+ * -----------------------
+ *   Converts a chunk into its output slot. The buffer of the slot grows
+ *   when a chunk gives more output than it has room for.
+ *
+ *   returns:	0 on success, ENOMEM if out of memory.
+ */
+static int convert_chunk(struct pool *pool, size_t chunk, struct slot *slot)
+{
+	struct vx8_bulk b;
+	size_t start = chunk_start(pool, chunk);
+	size_t end = pool->len;
+
+	slot->len = 0;
+	slot->used = start != NO_CHUNK;
+	memset(slot->counts, 0, sizeof(slot->counts));
+	if (start == NO_CHUNK)
+	{
+		return 0;
+	}
+	for (size_t next = chunk + 1; next < pool->chunk_count; next++)
+	{
+		if ((end = chunk_start(pool, next)) != NO_CHUNK)
+		{
+			break;
+		}
+		end = pool->len;
+	}
+
+	vx8_bulk_init(&b, pool->kernel);
+	while (start < end)
+	{
+		size_t out_len;
+
+		if (slot->size - slot->len < VX8_BUFFER_SIZE)
+		{
+			size_t size = slot->size ? slot->size * 2 : pool->chunk_size + VX8_BUFFER_SIZE;
+			uint8_t *buffer = realloc(slot->buffer, size);
+			if (buffer == NULL)
+			{
+				return ENOMEM;
+			}
+			slot->buffer = buffer;
+			slot->size = size;
+		}
+		start += vx8_bulk_convert(&b, pool->in + start, end - start, slot->buffer + slot->len,
+				slot->size - slot->len, &out_len);
+		slot->len += out_len;
+	}
+	/* The $ of the next chunk rejects an incomplete sentence. */
+	if (end < pool->len && b.vx8.state != VX8_READY)
+	{
+		b.counts[VX8_REJECT_SYNC]++;
+	}
+	memcpy(slot->counts, b.counts, sizeof(slot->counts));
+	return 0;
+}
+
+/*
+ * Function: chunk_start
+ * ---------------------
+ *   returns:	offset of the first $ of the chunk, 0 for the first chunk,
+ *   			NO_CHUNK if the chunk has no $.
+ */
+static size_t chunk_start(const struct pool *pool, size_t chunk)
+{
+	size_t start = chunk * pool->chunk_size;
+	size_t len = pool->len - start < pool->chunk_size ? pool->len - start : pool->chunk_size;
+	const uint8_t *dollar;
+
+	if (chunk == 0)
+	{
+		return 0;
+	}
+	dollar = memchr(pool->in + start, '$', len);
+	return dollar ? (size_t) (dollar - pool->in) : NO_CHUNK;
+}
+
+/*
+ * Function: write_all
+ * -------------------
+ *   Writes the whole buffer, retrying short writes.
+ *
+ *   returns:	0 on success, -1 with errno set on error.
+ */
+static int write_all(int fd, const uint8_t *buffer, size_t len)
+{
+	while (len > 0)
+	{
+		ssize_t n = write(fd, buffer, len);
+		if (n < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			return -1;
+		}
+		buffer += n;
+		len -= (size_t) n;
+	}
+	return 0;
+}
+
+#endif /* VX8_CUT_THROUGH */
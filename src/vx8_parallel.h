@@ -0,0 +1,43 @@
+/*
+ * vx8_parallel.h
+ *
+ *  Created on: 16 Oct 2026
+ *  Author: Dmitry Melnichansky / 4Z7DTF
+ *
+ *  Host only multi-threaded conversion of large NMEA logs. The input,
+ *  normally a memory mapped file, is split into chunks which are converted
+ *  by a pool of threads with the bulk transform of vx8_bulk.c and written
+ *  in order. Every chunk starts at its first $, so it is converted by a
+ *  transform in READY state the same way as by the one running over the
+ *  whole input: the output and the result counts are identical.
+ *  Not available with VX8_CUT_THROUGH.
+ */
+
+#ifndef VX8_PARALLEL_H_
+#define VX8_PARALLEL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "../src/vx8_bulk.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define VX8_PARALLEL_CHUNK (4UL << 20) /* Default chunk size in bytes. */
+
+struct vx8_parallel_stats
+{
+	unsigned long long counts[VX8_RESULT_COUNT]; /* Like vx8_bulk.counts for the whole input. */
+	unsigned long long chunks; /* Chunks with at least one $. */
+	unsigned long long steals; /* Chunks converted by a thread other than their owner. */
+};
+
+int vx8_parallel_convert(const uint8_t *in, size_t len, int out_fd, unsigned threads, size_t chunk_size,
+		uint8_t kernel, struct vx8_parallel_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VX8_PARALLEL_H_ */
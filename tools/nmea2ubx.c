@@ -0,0 +1,248 @@
+/*
+ * nmea2ubx.c
+ *
+ *  Created on: 16 Oct 2026
+ *  Author: Dmitry Melnichansky / 4Z7DTF
+ *
+ *  Converts the NMEA captures in gps_output to the UBX NAV messages the
+ *  receiver sends for the same epochs: NAV-POSLLH, NAV-DOP, NAV-SOL,
+ *  NAV-VELNED and NAV-TIMEUTC, in this order. An epoch ends with ZDA, the last
+ *  sentence of an epoch of the NEO-6M, or with the RMC of the next one
+ *  when ZDA is missing from the capture. Used to feed the UBX input of the
+ *  firmware with the same data as the NMEA input. HDOP of GGA is written
+ *  to hDOP of NAV-DOP, the other DOP values are zero.
+ *
+ *  Usage: nmea2ubx [input] > output.ubx
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../src/ubx.h"
+
+#define MAX_FIELDS 24
+#define GPS_LEAP_SECONDS 17 /* GPS - UTC from July 2015 to December 2016. */
+#define WEEK_MS 604800000UL
+
+static void put_u16(uint8_t *p, uint16_t v)
+{
+	p[0] = (uint8_t) v;
+	p[1] = (uint8_t) (v >> 8);
+}
+
+static void put_u32(uint8_t *p, uint32_t v)
+{
+	put_u16(p, (uint16_t) v);
+	put_u16(p + 2, (uint16_t) (v >> 16));
+}
+
+static void write_ubx(uint8_t msg_class, uint8_t msg_id, const uint8_t *payload, uint16_t len)
+{
+	uint8_t header[6] = { UBX_SYNC_CHAR_1, UBX_SYNC_CHAR_2, msg_class, msg_id };
+	uint8_t ck[2] = { 0, 0 };
+
+	put_u16(header + 4, len);
+	for (int i = 2; i < 6; i++)
+	{
+		ck[0] += header[i];
+		ck[1] += ck[0];
+	}
+	for (uint16_t i = 0; i < len; i++)
+	{
+		ck[0] += payload[i];
+		ck[1] += ck[0];
+	}
+	fwrite(header, 1, sizeof(header), stdout);
+	fwrite(payload, 1, len, stdout);
+	fwrite(ck, 1, sizeof(ck), stdout);
+}
+
+static long round_half_away(double v)
+{
+	return v < 0 ? (long) (v - 0.5) : (long) (v + 0.5);
+}
+
+/* Days since 1970-01-01 of a civil date. */
+static long days_from_civil(long y, unsigned m, unsigned d)
+{
+	y -= m <= 2;
+	long era = (y >= 0 ? y : y - 399) / 400;
+	unsigned yoe = (unsigned) (y - era * 400);
+	unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+	unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+	return era * 146097 + (long) doe - 719468;
+}
+
+/* Parses ddmm.mmmmm or dddmm.mmmmm and the hemisphere to 1e-7 degrees.
+ * Rounded up, so that the minutes truncated by render.c are the same as
+ * in the sentence. */
+static int32_t parse_angle(const char *value, const char *hemisphere)
+{
+	long v = round_half_away(atof(value) * 1e5); /* dddmm, 1e-5 minutes */
+	long deg = v / 10000000L;
+	long min = v % 10000000L;
+	int32_t angle = (int32_t) (deg * 10000000L + (min * 10 + 5) / 6);
+
+	if (hemisphere[0] == 'S' || hemisphere[0] == 'W')
+		angle = -angle;
+	return angle;
+}
+
+static void parse_time(struct gps_fix *fix, const char *value)
+{
+	double t = atof(value);
+	long sec = (long) t;
+
+	fix->hour = (uint8_t) (sec / 10000);
+	fix->min = (uint8_t) (sec / 100 % 100);
+	fix->sec = (uint8_t) (sec % 100);
+	/* Milliseconds until itow is known. */
+	fix->itow = (uint32_t) round_half_away((t - sec) * 1000);
+	fix->time_valid = value[0] ? 0x07 : 0;
+}
+
+static void write_epoch(const struct gps_fix *fix)
+{
+	uint8_t payload[UBX_PAYLOAD_SIZE];
+	long days = days_from_civil(fix->year, fix->month, fix->day);
+	/* 1970-01-01 was a Thursday, GPS weeks start on Sunday. */
+	long dow = (days + 4) % 7;
+	uint32_t itow = (uint32_t) ((dow * 86400 + fix->hour * 3600L + fix->min * 60 + fix->sec + GPS_LEAP_SECONDS) * 1000
+			+ fix->itow) % WEEK_MS;
+
+	memset(payload, 0, sizeof(payload));
+	put_u32(payload, itow);
+	put_u32(payload + 4, (uint32_t) fix->lon);
+	put_u32(payload + 8, (uint32_t) fix->lat);
+	put_u32(payload + 12, (uint32_t) fix->height);
+	put_u32(payload + 16, (uint32_t) fix->hmsl);
+	write_ubx(UBX_CLASS_NAV, UBX_NAV_POSLLH, payload, 28);
+
+	memset(payload, 0, sizeof(payload));
+	put_u32(payload, itow);
+	put_u16(payload + 12, fix->hdop);
+	write_ubx(UBX_CLASS_NAV, UBX_NAV_DOP, payload, 18);
+
+	memset(payload, 0, sizeof(payload));
+	put_u32(payload, itow);
+	payload[10] = fix->fix_type;
+	payload[11] = fix->fix_flags;
+	payload[47] = fix->num_sv;
+	write_ubx(UBX_CLASS_NAV, UBX_NAV_SOL, payload, 52);
+
+	memset(payload, 0, sizeof(payload));
+	put_u32(payload, itow);
+	put_u32(payload + 20, fix->gspeed);
+	put_u32(payload + 24, (uint32_t) fix->heading);
+	write_ubx(UBX_CLASS_NAV, UBX_NAV_VELNED, payload, 36);
+
+	memset(payload, 0, sizeof(payload));
+	put_u32(payload, itow);
+	put_u16(payload + 12, fix->year);
+	payload[14] = fix->month;
+	payload[15] = fix->day;
+	payload[16] = fix->hour;
+	payload[17] = fix->min;
+	payload[18] = fix->sec;
+	payload[19] = fix->time_valid;
+	write_ubx(UBX_CLASS_NAV, UBX_NAV_TIMEUTC, payload, 20);
+}
+
+/* Splits a sentence at commas and at the asterisk. */
+static int split(char *line, char *fields[])
+{
+	int n = 0;
+	char *star = strchr(line, '*');
+
+	if (star)
+		*star = '\0';
+	fields[n++] = line;
+	for (char *p = line; *p && n < MAX_FIELDS; p++)
+	{
+		if (*p == ',')
+		{
+			*p = '\0';
+			fields[n++] = p + 1;
+		}
+	}
+	for (int i = n; i < MAX_FIELDS; i++)
+		fields[i] = "";
+	return n;
+}
+
+int main(int argc, char *argv[])
+{
+	FILE *in = stdin;
+	char line[256];
+	char *f[MAX_FIELDS];
+	struct gps_fix fix;
+	int pending = 0; /* Epoch has sentences and wasn't written yet. */
+
+	if (argc > 1 && (in = fopen(argv[1], "r")) == NULL)
+	{
+		perror(argv[1]);
+		return 1;
+	}
+
+	memset(&fix, 0, sizeof(fix));
+	while (fgets(line, sizeof(line), in))
+	{
+		char *start = strchr(line, '$');
+
+		if (start == NULL || strlen(start) < 7)
+			continue;
+		split(start, f);
+		if (strcmp(f[0] + 3, "RMC") == 0)
+		{
+			if (pending)
+			{
+				write_epoch(&fix);
+				memset(&fix, 0, sizeof(fix));
+			}
+			pending = 1;
+			parse_time(&fix, f[1]);
+			if (strlen(f[9]) == 6)
+			{
+				fix.day = (uint8_t) ((f[9][0] - '0') * 10 + f[9][1] - '0');
+				fix.month = (uint8_t) ((f[9][2] - '0') * 10 + f[9][3] - '0');
+				fix.year = (uint16_t) (2000 + atoi(f[9] + 4));
+			}
+			fix.gspeed = (uint32_t) round_half_away(atof(f[7]) * 185200.0 / 3600.0);
+			fix.heading = (int32_t) round_half_away(atof(f[8]) * 1e5);
+		}
+		else if (strcmp(f[0] + 3, "GGA") == 0)
+		{
+			int quality = atoi(f[6]);
+
+			pending = 1;
+			parse_time(&fix, f[1]);
+			if (f[2][0] && quality > 0)
+			{
+				fix.lat = parse_angle(f[2], f[3]);
+				fix.lon = parse_angle(f[4], f[5]);
+				fix.fix_type = GPS_FIX_3D;
+				fix.fix_flags = GPS_FIX_OK | (quality == 2 ? GPS_FIX_DIFF : 0);
+			}
+			fix.num_sv = (uint8_t) atoi(f[7]);
+			fix.hdop = (uint16_t) round_half_away(atof(f[8]) * 100);
+			fix.hmsl = (int32_t) round_half_away(atof(f[9]) * 1000);
+			fix.height = fix.hmsl + (int32_t) round_half_away(atof(f[11]) * 1000);
+		}
+		else if (strcmp(f[0] + 3, "ZDA") == 0)
+		{
+			parse_time(&fix, f[1]);
+			fix.day = (uint8_t) atoi(f[2]);
+			fix.month = (uint8_t) atoi(f[3]);
+			fix.year = (uint16_t) atoi(f[4]);
+			write_epoch(&fix);
+			memset(&fix, 0, sizeof(fix));
+			pending = 0;
+		}
+	}
+	if (pending)
+	{
+		write_epoch(&fix);
+	}
+	return 0;
+}
@@ -0,0 +1,74 @@
+/*
+ * track_dump.c
+ *
+ *  Created on: 16 Oct 2026
+ *  Author: Dmitry Melnichansky / 4Z7DTF
+ *
+ *  Decodes a track log, written by vx8_filter -l or read out of the SPI
+ *  flash of the firmware built with VX8_TRACK_LOG, to CSV on standard
+ *  output. Every page is decoded on its own, a damaged page loses only
+ *  its own points. Decoding stops at the first page which was never
+ *  written. With -s the number of points, pages and bytes per point are
+ *  printed to standard error.
+ *
+ *  Usage: track_dump [-s] [track_log] > track.csv
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "../src/track_log.h"
+
+#define EPOCH_2000 946684800L /* 2000-01-01 00:00 in Unix time. */
+
+int main(int argc, char *argv[])
+{
+	FILE *in = stdin;
+	uint8_t page[TRACK_PAGE_SIZE];
+	struct track_reader r;
+	unsigned long points = 0;
+	unsigned long pages = 0;
+	unsigned long bytes = 0;
+	int stats = 0;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-s") == 0)
+		{
+			stats = 1;
+		}
+		else if ((in = fopen(argv[i], "rb")) == NULL)
+		{
+			perror(argv[i]);
+			return 1;
+		}
+	}
+
+	printf("time,lat,lon,alt_m,speed_kmh,course\n");
+	while (fread(page, 1, sizeof(page), in) == sizeof(page) && page[0] != TRACK_END)
+	{
+		pages++;
+		track_reader_init(&r, page, sizeof(page));
+		while (track_reader_next(&r))
+		{
+			const struct track_point *p = &r.point;
+			time_t t = (time_t) (p->time + EPOCH_2000);
+			struct tm *tm = gmtime(&t);
+			char date[24];
+
+			strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", tm);
+			printf("%s,%.6f,%.6f,%.1f,%.2f,%.1f\n", date, p->lat / 1e6, p->lon / 1e6, p->alt / 10.0,
+					p->speed * 0.036, p->course / 10.0);
+			points++;
+		}
+		bytes += r.pos;
+	}
+
+	if (stats)
+	{
+		fprintf(stderr, "points          %lu\n", points);
+		fprintf(stderr, "pages           %lu\n", pages);
+		fprintf(stderr, "bytes per point %.2f\n", points ? (double) bytes / points : 0.0);
+	}
+	return 0;
+}
@@ -0,0 +1,196 @@
+/*
+ * vx8_bridge.c
+ *
+ *  Created on: 16 Oct 2026
+ *  Author: Dmitry Melnichansky / 4Z7DTF
+ *
+ *  Serial bridge daemon: converts the sentences of one GPS once and sends
+ *  the VX-8 sentences to several radios or loggers, see src/vx8_bridge.h.
+ *
+ *  Usage: vx8_bridge [-s] [-b baud] [-q frames] [-d ms] gps_port sink_port...
+ *    -s  print the number of sentences sent and rejected by reason, and
+ *        the frames written and dropped per sink, to standard error at exit
+ *    -b  baud rate of the serial ports, 9600 by default; ptys and other
+ *        files which aren't terminals are used as they are
+ *    -q  frames queued per sink, 16 by default
+ *    -d  time to write the queues out after the GPS port is closed, 3000ms
+ *        by default; sinks which still have frames then are closed
+ *  Runs until SIGINT or SIGTERM, or until the GPS port is closed.
+ *
+ *  Try it with ptys, e.g.:
+ *    socat -d -d pty,raw,echo=0,link=/tmp/gps pty,raw,echo=0,link=/tmp/gps_in &
+ *    socat -d -d pty,raw,echo=0,link=/tmp/vx8 pty,raw,echo=0,link=/tmp/vx8_out &
+ *    build/host/vx8_bridge -s /tmp/gps /tmp/vx8 &
+ *    cat /tmp/vx8_out &
+ *    cat gps_output/gps_strings_fix.txt > /tmp/gps_in
+ */
+
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+#include "../src/vx8_bridge.h"
+
+static const char *result_names[] = {
+	"none", "sent", "fields sent", "unsupported type", "empty field",
+	"overflow", "checksum mismatch", "out of sync",
+};
+
+#if defined(__linux__) && !defined(VX8_CUT_THROUGH)
+static struct vx8_bridge bridge;
+
+static void on_signal(int sig)
+{
+	(void) sig;
+	bridge.stop = 1;
+}
+
+static int open_port(const char *name, int flags, speed_t speed)
+{
+	struct termios tio;
+	int fd = open(name, flags | O_NOCTTY | O_NONBLOCK);
+
+	if (fd < 0)
+	{
+		perror(name);
+		return -1;
+	}
+	if (isatty(fd))
+	{
+		tcgetattr(fd, &tio);
+		cfmakeraw(&tio);
+		cfsetispeed(&tio, speed);
+		cfsetospeed(&tio, speed);
+		tio.c_cflag |= CLOCAL | CREAD;
+		if (tcsetattr(fd, TCSANOW, &tio) != 0)
+		{
+			perror(name);
+			close(fd);
+			return -1;
+		}
+	}
+	return fd;
+}
+
+static speed_t baud_rate(long baud)
+{
+	switch (baud)
+	{
+	case 4800:
+		return B4800;
+	case 9600:
+		return B9600;
+	case 19200:
+		return B19200;
+	case 38400:
+		return B38400;
+	case 57600:
+		return B57600;
+	case 115200:
+		return B115200;
+	default:
+		return B0;
+	}
+}
+#endif
+
+int main(int argc, char *argv[])
+{
+#if !defined(__linux__) || defined(VX8_CUT_THROUGH)
+	(void) argc;
+	(void) argv;
+	(void) result_names;
+	fprintf(stderr, "vx8_bridge: needs Linux and isn't available with VX8_CUT_THROUGH\n");
+	return 1;
+#else
+	struct sigaction sa;
+	speed_t speed = B9600;
+	unsigned queue_size = VX8_BRIDGE_QUEUE;
+	unsigned drain_ms = VX8_BRIDGE_DRAIN_MS;
+	int stats = 0;
+	int source;
+	int *sinks;
+	int count = 0;
+	int i;
+
+	for (i = 1; i < argc && argv[i][0] == '-'; i++)
+	{
+		if (strcmp(argv[i], "-s") == 0)
+		{
+			stats = 1;
+		}
+		else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc)
+		{
+			if ((speed = baud_rate(atol(argv[++i]))) == B0)
+			{
+				fprintf(stderr, "%s: unsupported baud rate\n", argv[i]);
+				return 1;
+			}
+		}
+		else if (strcmp(argv[i], "-q") == 0 && i + 1 < argc)
+		{
+			queue_size = (unsigned) atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc)
+		{
+			drain_ms = (unsigned) atoi(argv[++i]);
+		}
+		else
+		{
+			break;
+		}
+	}
+	if (argc - i < 2)
+	{
+		fprintf(stderr, "usage: vx8_bridge [-s] [-b baud] [-q frames] [-d ms] gps_port sink_port...\n");
+		return 1;
+	}
+	if ((source = open_port(argv[i++], O_RDONLY, speed)) < 0)
+	{
+		return 1;
+	}
+	sinks = calloc(argc - i, sizeof(sinks[0]));
+	for (; i < argc; i++)
+	{
+		if ((sinks[count++] = open_port(argv[i], O_WRONLY, speed)) < 0)
+		{
+			return 1;
+		}
+	}
+	if (vx8_bridge_init(&bridge, source, sinks, count, queue_size) != 0)
+	{
+		perror("vx8_bridge");
+		return 1;
+	}
+	bridge.drain_ms = drain_ms;
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = on_signal;
+	sigaction(SIGINT, &sa, NULL);
+	sigaction(SIGTERM, &sa, NULL);
+	signal(SIGPIPE, SIG_IGN);
+
+	if (vx8_bridge_run(&bridge) != 0)
+	{
+		perror("vx8_bridge");
+	}
+	if (stats)
+	{
+		for (unsigned r = 1; r < VX8_RESULT_COUNT; r++)
+		{
+			fprintf(stderr, "%-18s %llu\n", result_names[r], bridge.counts[r]);
+		}
+		for (int s = 0; s < count; s++)
+		{
+			const struct vx8_bridge_sink *sink = &bridge.sinks[s];
+			fprintf(stderr, "%-18s %llu written, %llu dropped, %u queued at most%s\n", argv[argc - count + s],
+					sink->frames, sink->dropped, sink->max_count, sink->closed ? ", closed" : "");
+		}
+	}
+	vx8_bridge_close(&bridge);
+	return 0;
+#endif
+}
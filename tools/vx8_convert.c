@@ -0,0 +1,195 @@
+/*
+ * vx8_convert.c
+ *
+ *  Created on: 16 Oct 2026
+ *  Author: Dmitry Melnichansky / 4Z7DTF
+ *
+ *  Batch converter for archived NMEA logs. Writes the same VX-8 sentences
+ *  as vx8_filter, using the bulk transform of vx8_bulk.c, which finds the
+ *  delimiters and computes the checksums 16 or 32 bytes at a time.
+ *
+ *  Usage: vx8_convert [-s] [-k auto|scalar|sse2] [-j threads [-c KB]] [input] > output
+ *    -s  print the number of sentences sent and rejected by reason, and
+ *        the throughput, to standard error
+ *    -k  scanning kernel, SSE2 on x86 by default
+ *    -j  convert with a pool of threads (vx8_parallel.c), the input has to
+ *        be a file, which is memory mapped
+ *    -c  size of the chunks converted by the threads, 4096KB by default
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "../src/vx8_bulk.h"
+#include "../src/vx8_parallel.h"
+
+#define IN_SIZE (1 << 20)
+#define OUT_SIZE (2 << 20)
+
+static const char *result_names[] = {
+	"none", "sent", "fields sent", "unsupported type", "empty field",
+	"overflow", "checksum mismatch", "out of sync",
+};
+
+static const char *kernel_names[] = { "auto", "scalar", "sse2" };
+
+#ifndef VX8_CUT_THROUGH
+static int convert_mapped(const char *name, unsigned threads, size_t chunk_size, uint8_t kernel,
+		unsigned long long counts[], unsigned long long *total)
+{
+	struct vx8_parallel_stats stats;
+	struct stat st;
+	uint8_t *map = NULL;
+	int fd = open(name, O_RDONLY);
+	int res;
+
+	if (fd < 0 || fstat(fd, &st) != 0)
+	{
+		perror(name);
+		return 1;
+	}
+	if (st.st_size > 0)
+	{
+		map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (map == MAP_FAILED)
+		{
+			perror(name);
+			return 1;
+		}
+		madvise(map, st.st_size, MADV_SEQUENTIAL);
+	}
+	res = vx8_parallel_convert(map, st.st_size, STDOUT_FILENO, threads, chunk_size, kernel, &stats);
+	if (res != 0)
+	{
+		perror("vx8_convert");
+	}
+	if (map)
+	{
+		munmap(map, st.st_size);
+	}
+	close(fd);
+	memcpy(counts, stats.counts, sizeof(stats.counts));
+	*total = st.st_size;
+	return res != 0;
+}
+#endif
+
+int main(int argc, char *argv[])
+{
+#ifdef VX8_CUT_THROUGH
+	(void) argc;
+	(void) argv;
+	(void) result_names;
+	(void) kernel_names;
+	fprintf(stderr, "vx8_convert: not available with VX8_CUT_THROUGH\n");
+	return 1;
+#else
+	static struct vx8_bulk bulk;
+	static uint8_t in_buf[IN_SIZE];
+	static uint8_t out_buf[OUT_SIZE];
+	FILE *in = stdin;
+	const char *name = NULL;
+	unsigned threads = 0;
+	size_t chunk_size = VX8_PARALLEL_CHUNK;
+	uint8_t kernel = VX8_BULK_AUTO;
+	unsigned long long total = 0;
+	struct timespec t0;
+	struct timespec t1;
+	double seconds;
+	int stats = 0;
+	size_t n;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-s") == 0)
+		{
+			stats = 1;
+		}
+		else if (strcmp(argv[i], "-k") == 0 && i + 1 < argc)
+		{
+			i++;
+			for (kernel = 0; kernel < sizeof(kernel_names) / sizeof(kernel_names[0]); kernel++)
+			{
+				if (strcmp(argv[i], kernel_names[kernel]) == 0)
+				{
+					break;
+				}
+			}
+			if (kernel == sizeof(kernel_names) / sizeof(kernel_names[0]))
+			{
+				fprintf(stderr, "%s: unknown kernel\n", argv[i]);
+				return 1;
+			}
+		}
+		else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+		{
+			threads = (unsigned) atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc)
+		{
+			chunk_size = (size_t) atol(argv[++i]) << 10;
+		}
+		else
+		{
+			name = argv[i];
+		}
+	}
+	if (threads && name == NULL)
+	{
+		fprintf(stderr, "-j: the input has to be a file\n");
+		return 1;
+	}
+	if (!threads && name && (in = fopen(name, "rb")) == NULL)
+	{
+		perror(name);
+		return 1;
+	}
+	if (!vx8_bulk_init(&bulk, kernel))
+	{
+		fprintf(stderr, "%s: not supported by this CPU\n", kernel_names[kernel]);
+		return 1;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	if (threads)
+	{
+		fflush(stdout);
+		if (convert_mapped(name, threads, chunk_size, bulk.kernel, bulk.counts, &total) != 0)
+		{
+			return 1;
+		}
+	}
+	else
+	{
+		while ((n = fread(in_buf, 1, sizeof(in_buf), in)) > 0)
+		{
+			size_t done = 0;
+			total += n;
+			while (done < n)
+			{
+				size_t out_len;
+				done += vx8_bulk_convert(&bulk, in_buf + done, n - done, out_buf, sizeof(out_buf), &out_len);
+				fwrite(out_buf, 1, out_len, stdout);
+			}
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	if (stats)
+	{
+		for (unsigned i = 1; i < VX8_RESULT_COUNT; i++)
+		{
+			fprintf(stderr, "%-18s %llu\n", result_names[i], bulk.counts[i]);
+		}
+		seconds = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+		fprintf(stderr, "%-18s %s\n", "kernel", vx8_bulk_kernel_name(bulk.kernel));
+		fprintf(stderr, "%-18s %.3f GB/s\n", "throughput", seconds > 0 ? total / seconds / 1e9 : 0.0);
+	}
+	return 0;
+#endif
+}
@@ -0,0 +1,248 @@
+/*
+ * vx8_filter.c
+ *
+ *  Created on: 16 Oct 2026
+ *  Author: Dmitry Melnichansky / 4Z7DTF
+ *
+ *  Host version of the firmware. Reads NMEA sentences from a file or
+ *  standard input and writes the VX-8 sentences produced by the transform
+ *  to standard output. With -u reads u-blox UBX NAV messages instead and
+ *  writes the sentences rendered from every complete epoch. With -n the
+ *  same sentences are also written as standard NMEA to a second file,
+ *  like the firmware built with VX8_NMEA_OUTPUT does. With -l the fixes
+ *  are added to a track log file, which stands in for the SPI flash of
+ *  the firmware built with VX8_TRACK_LOG. An existing log is continued.
+ *
+ *  Usage: vx8_filter [-s] [-u] [-n nmea_output] [-l track_log] [input]
+ *    -s  print the number of sentences sent and rejected by reason
+ *        to standard error
+ *    -u  UBX input
+ *    -n  standard NMEA output file
+ *    -l  track log file, decoded by track_dump
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "../src/vx8_core.h"
+#include "../src/gps_fix.h"
+#include "../src/render.h"
+#include "../src/sentences.h"
+#include "../src/track_log.h"
+#include "../src/ubx.h"
+
+#define LOG_FILE_PAGES 65536UL /* As large as a 16MB flash. */
+
+static const char *result_names[] = {
+	"none", "sent", "fields sent", "unsupported type", "empty field",
+	"overflow", "checksum mismatch", "out of sync",
+};
+
+static const char *ubx_result_names[] = {
+	"none", "epochs", "messages", "unsupported type", "checksum mismatch",
+	"ack", "nak",
+};
+
+static FILE *log_file;
+
+/*
+ * Function: log_read
+ * ------------------
+ *   track_store read function of the log file. Pages after the end of the
+ *   file read erased.
+ *
+ *   returns:	1 if read, 0 if the file failed.
+ */
+static uint8_t log_read(uint32_t page, uint16_t offset, uint8_t *data, uint16_t len)
+{
+	size_t n;
+
+	if (fseek(log_file, (long) page * TRACK_PAGE_SIZE + offset, SEEK_SET) != 0)
+	{
+		return 0;
+	}
+	n = fread(data, 1, len, log_file);
+	memset(data + n, TRACK_END, len - n);
+	return !ferror(log_file);
+}
+
+static uint8_t log_write(uint32_t page, const uint8_t *data)
+{
+	return fseek(log_file, (long) page * TRACK_PAGE_SIZE, SEEK_SET) == 0
+			&& fwrite(data, 1, TRACK_PAGE_SIZE, log_file) == TRACK_PAGE_SIZE;
+}
+
+static const struct track_store log_store = { LOG_FILE_PAGES, log_read, log_write };
+
+/*
+ * Function: write_nmea
+ * --------------------
+ *   Writes the sentence rendered from the fix in the standard NMEA dialect
+ *   to the NMEA output, if there is one.
+ *
+ *   returns:	none
+ */
+static void write_nmea(FILE *nmea, const struct gps_fix *fix, uint8_t sentence)
+{
+	struct vx8_frame frame;
+
+	if (nmea && render_sentence(fix, sentence, RENDER_NMEA, &frame))
+	{
+		fwrite(frame.buffer, 1, frame.len, nmea);
+	}
+}
+
+static void filter_nmea(FILE *in, FILE *nmea, struct track_log *track, unsigned long counts[])
+{
+	struct vx8 ctx;
+	struct vx8_frame frame;
+	struct gps_fix fix;
+	int c;
+
+#ifdef VX8_CUT_THROUGH
+	(void) nmea;
+	(void) track;
+#endif
+	memset(&fix, 0, sizeof(fix));
+	vx8_init(&ctx, &frame);
+	vx8_set_fix(&ctx, &fix);
+	while ((c = getc(in)) != EOF)
+	{
+		uint8_t res = vx8_feed(&ctx, (uint8_t) c);
+#ifdef VX8_CUT_THROUGH
+		/* Released fields, the end of the sentence or the trailer of
+		 * a discarded one. */
+		if (frame.len)
+#else
+		if (res == VX8_FRAME)
+#endif
+		{
+			fwrite(frame.buffer, 1, frame.len, stdout);
+		}
+#ifndef VX8_CUT_THROUGH
+		if (res == VX8_FRAME && ctx.fix_updated)
+		{
+			if (track && frame.type == SENTENCE_GGA)
+			{
+				track_log_add(track, &fix);
+			}
+			write_nmea(nmea, &fix, frame.type);
+		}
+#endif
+		counts[res]++;
+	}
+}
+
+static void filter_ubx(FILE *in, FILE *nmea, struct track_log *track, unsigned long counts[])
+{
+	static struct ubx ctx;
+	static struct render_cache cache;
+	struct vx8_frame frame;
+	int c;
+
+	ubx_init(&ctx);
+	render_cache_init(&cache);
+	while ((c = getc(in)) != EOF)
+	{
+		uint8_t res = ubx_feed(&ctx, (uint8_t) c);
+		if (res == UBX_EPOCH)
+		{
+			for (uint8_t i = 0; i < SENTENCE_COUNT; i++)
+			{
+				if (render_cached(&cache, &ctx.fix, i, &frame))
+				{
+					fwrite(frame.buffer, 1, frame.len, stdout);
+				}
+			}
+			for (uint8_t i = 0; i < SENTENCE_COUNT; i++)
+			{
+				write_nmea(nmea, &ctx.fix, i);
+			}
+			if (track)
+			{
+				track_log_add(track, &ctx.fix);
+			}
+		}
+		counts[res]++;
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned long counts[sizeof(result_names) / sizeof(result_names[0])] = { 0 };
+	const char **names = result_names;
+	unsigned count = sizeof(result_names) / sizeof(result_names[0]);
+	int stats = 0;
+	int ubx = 0;
+	FILE *in = stdin;
+	FILE *nmea = NULL;
+	static struct track_log track;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-s") == 0)
+		{
+			stats = 1;
+		}
+		else if (strcmp(argv[i], "-u") == 0)
+		{
+			ubx = 1;
+		}
+		else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+		{
+			if ((nmea = fopen(argv[++i], "wb")) == NULL)
+			{
+				perror(argv[i]);
+				return 1;
+			}
+		}
+		else if (strcmp(argv[i], "-l") == 0 && i + 1 < argc)
+		{
+			i++;
+			if ((log_file = fopen(argv[i], "r+b")) == NULL && (log_file = fopen(argv[i], "w+b")) == NULL)
+			{
+				perror(argv[i]);
+				return 1;
+			}
+		}
+		else if ((in = fopen(argv[i], "rb")) == NULL)
+		{
+			perror(argv[i]);
+			return 1;
+		}
+	}
+
+	if (log_file)
+	{
+		track_log_init(&track, &log_store);
+	}
+	if (ubx)
+	{
+		names = ubx_result_names;
+		count = sizeof(ubx_result_names) / sizeof(ubx_result_names[0]);
+		filter_ubx(in, nmea, log_file ? &track : NULL, counts);
+	}
+	else
+	{
+		filter_nmea(in, nmea, log_file ? &track : NULL, counts);
+	}
+	if (log_file)
+	{
+		/* The firmware loses the partial page at power-off. */
+		track_log_flush(&track);
+		fclose(log_file);
+	}
+	if (nmea)
+	{
+		fclose(nmea);
+	}
+
+	if (stats)
+	{
+		/* Result 1 is VX8_FRAME or UBX_EPOCH. */
+		for (unsigned i = 1; i < count; i++)
+		{
+			fprintf(stderr, "%-18s %lu\n", names[i], counts[i]);
+		}
+	}
+	return 0;
+}